@@ -0,0 +1,163 @@
+/*
+ *  archiving_node_ext.cpp
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "archiving_node_ext.h"
+#include "dictutils.h"
+
+#include <cmath>
+
+namespace mynest
+{
+
+  Archiving_Node_Ext::Archiving_Node_Ext()
+    : Archiving_Node(),
+      n_incoming_(0),
+      tau_minus_(20.0),
+      Kminus_(0.0),
+      last_spike_(0),
+      start_(0),
+      K_query_(0),
+      K_value_(0.0),
+      K_valid_(false)
+  {}
+
+  Archiving_Node_Ext::Archiving_Node_Ext(const Archiving_Node_Ext& n)
+    : Archiving_Node(n),
+      n_incoming_(n.n_incoming_),
+      tau_minus_(n.tau_minus_),
+      Kminus_(n.Kminus_),
+      last_spike_(n.last_spike_),
+      start_(0),
+      K_query_(0),
+      K_value_(0.0),
+      K_valid_(false)
+  {}
+
+  void Archiving_Node_Ext::register_step_connection(long_t t_first_read)
+  {
+    // Spikes up to t_first_read will never be read by the new connection,
+    // count them as read so that they can still be dropped, see bug #218.
+    for ( size_t i = start_; i < steps_.size() && steps_[i] <= t_first_read; ++i )
+      ++reads_[i];
+
+    ++n_incoming_;
+  }
+
+  void Archiving_Node_Ext::unregister_step_connection(long_t t_last_read)
+  {
+    // take back the reads of the connection, then the history is in the
+    // state it would be in had the connection never been registered
+    for ( size_t i = start_; i < steps_.size() && steps_[i] <= t_last_read; ++i )
+      --reads_[i];
+
+    if ( n_incoming_ > 0 )
+      --n_incoming_;
+
+    // with no connection left, set_spiketime() stops recording as well
+    prune_();
+  }
+
+  double_t Archiving_Node_Ext::find_K_value_(long_t t) const
+  {
+    const double_t h = Time::get_resolution().get_ms();
+
+    // no spike since t, the trace of the last spike decays up to t
+    if ( last_spike_ < t )
+      return Kminus_ * std::exp((last_spike_ - t) * h / tau_minus_);
+
+    // the node has spiked since t, look up the last spike before t
+    if ( start_ == steps_.size() )
+      return 0.0;
+
+    const long_t* const begin = &steps_[start_];
+    const long_t* const end = begin + (steps_.size() - start_);
+    const long_t* p = std::lower_bound(begin, end, t);
+    if ( p == begin )
+      return 0.0;
+
+    --p;
+    return Kminus_at_[start_ + (p - begin)] * std::exp((*p - t) * h / tau_minus_);
+  }
+
+  void Archiving_Node_Ext::set_spiketime(Time const& t_sp)
+  {
+    Archiving_Node::set_spiketime(t_sp);
+
+    const long_t t = t_sp.get_steps();
+    const double_t h = Time::get_resolution().get_ms();
+    Kminus_ = Kminus_ * std::exp((last_spike_ - t) * h / tau_minus_) + 1.0;
+    last_spike_ = t;
+    K_valid_ = false;
+
+    if ( n_incoming_ == 0 )
+      return;
+
+    prune_();
+    steps_.push_back(t);
+    Kminus_at_.push_back(Kminus_);
+    reads_.push_back(0);
+  }
+
+  void Archiving_Node_Ext::prune_()
+  {
+    // keep the last spike, get_step_K_value() still needs it
+    while ( steps_.size() - start_ > 1 && reads_[start_] >= n_incoming_ )
+      ++start_;
+
+    // compact once the dropped entries outnumber the live ones
+    if ( start_ > 0 && 2 * start_ >= steps_.size() )
+    {
+      steps_.erase(steps_.begin(), steps_.begin() + start_);
+      Kminus_at_.erase(Kminus_at_.begin(), Kminus_at_.begin() + start_);
+      reads_.erase(reads_.begin(), reads_.begin() + start_);
+      start_ = 0;
+    }
+  }
+
+  void Archiving_Node_Ext::clear_history()
+  {
+    Archiving_Node::clear_history();
+
+    Kminus_ = 0.0;
+    last_spike_ = 0;
+    K_valid_ = false;
+    start_ = 0;
+    steps_.clear();
+    Kminus_at_.clear();
+    reads_.clear();
+  }
+
+  void Archiving_Node_Ext::get_status(DictionaryDatum& d) const
+  {
+    Archiving_Node::get_status(d);
+    def<long>(d, "step_archiver_length", steps_.size() - start_);
+  }
+
+  void Archiving_Node_Ext::set_status(const DictionaryDatum& d)
+  {
+    // Archiving_Node checks the value
+    Archiving_Node::set_status(d);
+    updateValue<double_t>(d, "tau_minus", tau_minus_);
+    K_valid_ = false;
+  }
+
+} // namespace
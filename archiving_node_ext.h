@@ -0,0 +1,158 @@
+/*
+ *  archiving_node_ext.h
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef ARCHIVING_NODE_EXT_H
+#define ARCHIVING_NODE_EXT_H
+
+#include "nest.h"
+#include "nest_time.h"
+#include "archiving_node.h"
+#include "dictdatum.h"
+
+#include <algorithm>
+#include <vector>
+
+using namespace nest;
+
+namespace mynest
+{
+
+  /**
+   * Archiving_Node with a second spike history for the STDP synapses of
+   * this module.
+   *
+   * The history keeps the spike steps, the postsynaptic trace K- and the
+   * number of reads of each spike in three arrays. Entries that all
+   * registered connections have read are dropped from the front by
+   * moving a start index; the arrays are compacted once the dropped part
+   * exceeds the live part. The history is therefore contiguous, a range
+   * of spikes is a pointer range, and ranges are found by binary search.
+   *
+   * Connections register with register_step_connection() instead of
+   * Archiving_Node::register_stdp_connection(), so the deque of the base
+   * class stays empty unless NEST's own STDP synapses connect to the node.
+   */
+  class Archiving_Node_Ext : public Archiving_Node
+  {
+
+  public:
+
+    Archiving_Node_Ext();
+    Archiving_Node_Ext(const Archiving_Node_Ext&);
+
+    /**
+     * Register an STDP connection that reads spikes after step
+     * t_first_read. Earlier spikes are marked read for it.
+     */
+    void register_step_connection(long_t t_first_read);
+
+    /**
+     * Remove a connection that has read all spikes up to step t_last_read
+     * and will read no more, so that the history can be dropped without it.
+     */
+    void unregister_step_connection(long_t t_last_read);
+
+    /**
+     * Spikes with t1 < step <= t2 as pointer range [*start, *finish) into
+     * the step array, marked as read once more. The range is valid until
+     * the node spikes again.
+     */
+    void get_step_history(long_t t1, long_t t2,
+                          const long_t** start, const long_t** finish);
+
+    /**
+     * Postsynaptic trace K- just before step t.
+     *
+     * Synapses with the same delay from one source ask for the same t, so
+     * the last result is kept until the node spikes again. If the node has
+     * not spiked since t, K- follows from the trace at the last spike,
+     * which is updated at every spike, and the history is not searched.
+     */
+    double_t get_step_K_value(long_t t) const;
+
+    void get_status(DictionaryDatum& d) const;
+    void set_status(const DictionaryDatum& d);
+
+  protected:
+
+    /**
+     * Record a spike, hides Archiving_Node::set_spiketime().
+     */
+    void set_spiketime(Time const& t_sp);
+
+    void clear_history();
+
+  private:
+
+    void prune_();
+    double_t find_K_value_(long_t t) const;
+
+    size_t   n_incoming_;   //!< Connections registered with this history
+    double_t tau_minus_;    //!< Time constant of K- in ms
+    double_t Kminus_;       //!< K- just after the last spike
+    long_t   last_spike_;   //!< Step of the last spike
+
+    size_t start_;                     //!< First live entry
+    std::vector<long_t>   steps_;      //!< Spike steps, ascending
+    std::vector<double_t> Kminus_at_;  //!< K- just after each spike
+    std::vector<size_t>   reads_;      //!< Reads of each spike
+
+    mutable long_t   K_query_;  //!< Step of the last K- query
+    mutable double_t K_value_;  //!< Result of the last K- query
+    mutable bool     K_valid_;  //!< False after a spike
+  };
+
+  inline
+  double_t Archiving_Node_Ext::get_step_K_value(long_t t) const
+  {
+    if ( !K_valid_ || t != K_query_ )
+    {
+      K_value_ = find_K_value_(t);
+      K_query_ = t;
+      K_valid_ = true;
+    }
+    return K_value_;
+  }
+
+  inline
+  void Archiving_Node_Ext::get_step_history(long_t t1, long_t t2,
+                                            const long_t** start, const long_t** finish)
+  {
+    if ( start_ == steps_.size() )
+    {
+      *start = *finish = 0;
+      return;
+    }
+
+    const long_t* const begin = &steps_[start_];
+    const long_t* const end = begin + (steps_.size() - start_);
+    *start = std::upper_bound(begin, end, t1);
+    *finish = std::upper_bound(*start, end, t2);
+
+    size_t* r = &reads_[start_] + (*start - begin);
+    for ( const long_t* p = *start; p != *finish; ++p, ++r )
+      ++(*r);
+  }
+
+} // namespace
+
+#endif /* #ifndef ARCHIVING_NODE_EXT_H */
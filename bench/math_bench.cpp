@@ -0,0 +1,407 @@
+/*
+ *  math_bench.cpp
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Throughput and error of the math_accuracy tiers, see module_math.h.
+ *
+ * The first table times exp, log and pow of each tier over random
+ * arguments and gives the largest relative error against the std
+ * functions. The second runs the models that use the tiers, without
+ * NEST: the kernels of glif_psc_alpha_multi, iaf_freq_sensor_v2 and
+ * iaf_wsn_hermitian_1/2 step for step, and the learning rule of
+ * stdp_synapse_multi over a history of postsynaptic spikes. It gives the
+ * time per step or per history entry and the largest deviation of the
+ * membrane potential (the weight for the synapse) from tier 0, relative
+ * to the largest value of tier 0, together with the number of spikes.
+ * A spike that moves by a step makes the deviation of the membrane
+ * large, so the spike counts belong with it.
+ *
+ * The tier is a template argument, as in the models, so the loops run
+ * without a branch on math_accuracy. Build and run from the module
+ * directory, with the flags NEST is built with:
+ *
+ *   g++ -O2 -I. -o math_bench bench/math_bench.cpp && ./math_bench
+ *
+ * The polynomials of tiers 1 and 2 gain from fused multiply-add, so
+ * compare with -march=native as well. Times are the best of 7 runs.
+ */
+
+#include "module_math.h"
+#include "glif_psc_alpha_multi_kernel.h"
+#include "iaf_freq_sensor_v2_kernel.h"
+#include "iaf_wsn_hermitian_1_kernel.h"
+#include "iaf_wsn_hermitian_2_kernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+#include <time.h>
+
+using namespace mynest;
+
+namespace
+{
+  double now()
+  {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+  }
+
+  double uniform(double a, double b)
+  {
+    return a + (b - a) * (std::rand() / (RAND_MAX + 1.0));
+  }
+
+  double rel_err(double x, double ref)
+  {
+    if ( x == ref )
+      return 0.0;
+    return std::abs(x - ref) / std::max(std::abs(ref), std::numeric_limits<double>::min());
+  }
+
+  const int n_reps = 7;
+  const char* const tier_names[] = { "0 std", "1 1e-12", "2 1e-7" };
+
+  /* ---- functions ------------------------------------------------------ */
+
+  struct Exp
+  {
+    template <int A>
+    static double f(double x, double) { return math::exp<A>(x); }
+  };
+
+  struct Log
+  {
+    template <int A>
+    static double f(double x, double) { return math::log<A>(x); }
+  };
+
+  struct Pow
+  {
+    template <int A>
+    static double f(double x, double y) { return math::pow<A>(x, y); }
+  };
+
+  /** Results of F for tier A, returns the best time per call in ns. */
+  template <class F, int A>
+  double run_function(const std::vector<double>& x, const std::vector<double>& y,
+                      std::vector<double>& r)
+  {
+    double best = std::numeric_limits<double>::max();
+    for ( int rep = 0; rep < n_reps; ++rep )
+    {
+      const double t0 = now();
+      for ( size_t i = 0; i < x.size(); ++i )
+        r[i] = F::template f<A>(x[i], y[i]);
+      best = std::min(best, now() - t0);
+    }
+    return 1e9 * best / x.size();
+  }
+
+  template <class F>
+  void bench_function(const char* name, const std::vector<double>& x, const std::vector<double>& y)
+  {
+    std::vector<double> r[3];
+    double ns[3];
+    for ( int a = MATH_EXACT; a <= MATH_1E7; ++a )
+      r[a].resize(x.size());
+    ns[MATH_EXACT] = run_function<F, MATH_EXACT>(x, y, r[MATH_EXACT]);
+    ns[MATH_1E12] = run_function<F, MATH_1E12>(x, y, r[MATH_1E12]);
+    ns[MATH_1E7] = run_function<F, MATH_1E7>(x, y, r[MATH_1E7]);
+
+    for ( int a = MATH_EXACT; a <= MATH_1E7; ++a )
+    {
+      double err = 0.0;
+      for ( size_t i = 0; i < x.size(); ++i )
+        err = std::max(err, rel_err(r[a][i], r[MATH_EXACT][i]));
+      std::printf("%-26s %-8s %10.2f %12.2e\n", name, tier_names[a], ns[a], err);
+    }
+  }
+
+  /* ---- models --------------------------------------------------------- */
+
+  const double h = 0.1;
+  const size_t n_steps = 20000;
+
+  struct Trace
+  {
+    std::vector<double> u;
+    size_t spikes;
+    double ns;
+  };
+
+  void report(const char* name, const std::vector<Trace>& tr)
+  {
+    double umax = std::numeric_limits<double>::min();
+    for ( size_t k = 0; k < tr[0].u.size(); ++k )
+      umax = std::max(umax, std::abs(tr[0].u[k]));
+
+    for ( int a = MATH_EXACT; a <= MATH_1E7; ++a )
+    {
+      double dev = 0.0;
+      for ( size_t k = 0; k < tr[a].u.size(); ++k )
+        dev = std::max(dev, std::abs(tr[a].u[k] - tr[0].u[k]));
+      std::printf("%-26s %-8s %10.2f %12.2e %8lu\n", name, tier_names[a],
+                  tr[a].ns, dev / umax, static_cast<unsigned long>(tr[a].spikes));
+    }
+  }
+
+  // input current with a slow and a fast component, clock every 25 ms
+  void make_input(std::vector<double>& current, std::vector<double>& clock)
+  {
+    current.resize(n_steps);
+    clock.resize(n_steps);
+    for ( size_t k = 0; k < n_steps; ++k )
+    {
+      const double t = k * h;
+      current[k] = 2.0 + std::sin(2.0 * kernel_pi * t / 40.0) + 0.5 * std::sin(2.0 * kernel_pi * t / 7.0);
+      clock[k] = k % 250 == 0 ? 1.0 : 0.0;
+    }
+  }
+
+  // the kernels with per-scale arrays need them sized
+  template <class P, class S, class V>
+  void init_(const P&, S&, V&) {}
+
+  void init_(const WsnHermitian1Kernel::Parameters& p, WsnHermitian1Kernel::State& s,
+             WsnHermitian1Kernel::Variables& v)
+  {
+    WsnHermitian1Kernel::resize(p, s, v);
+  }
+
+  void init_(const WsnHermitian2Kernel::Parameters& p, WsnHermitian2Kernel::State& s,
+             WsnHermitian2Kernel::Variables& v)
+  {
+    WsnHermitian2Kernel::resize(p, s, v);
+  }
+
+  template <class K, int A>
+  Trace run_wavelet(const typename K::Parameters& p,
+                    const std::vector<double>& current, const std::vector<double>& clock)
+  {
+    Trace tr;
+    tr.ns = std::numeric_limits<double>::max();
+    for ( int rep = 0; rep < n_reps; ++rep )
+    {
+      typename K::State s;
+      typename K::Variables v;
+      init_(p, s, v);
+      K::calibrate(p, v, h);
+      v.RefractoryCounts_ = 20;
+      tr.u.assign(n_steps, 0.0);
+      tr.spikes = 0;
+      const double t0 = now();
+      for ( size_t k = 0; k < n_steps; ++k )
+      {
+        if ( K::template step<A>(p, s, v, (k + 1) * h, h, clock[k] > 0.1) )
+          ++tr.spikes;
+        s.Ie_ = current[k];
+        tr.u[k] = s.u_;
+      }
+      tr.ns = std::min(tr.ns, 1e9 * (now() - t0) / n_steps);
+    }
+    return tr;
+  }
+
+  template <int A>
+  Trace run_glif(const GlifPscAlphaMultiKernel::Parameters& p,
+                 const std::vector<double>& current, const std::vector<double>& spikes_in)
+  {
+    typedef GlifPscAlphaMultiKernel K;
+    Trace tr;
+    tr.ns = std::numeric_limits<double>::max();
+    for ( int rep = 0; rep < n_reps; ++rep )
+    {
+      K::State s;
+      K::Variables v;
+      K::resize(p, s, v);
+      K::calibrate(p, v, h);
+      v.RefractoryCounts_ = 20;
+      tr.u.assign(n_steps, 0.0);
+      tr.spikes = 0;
+      const double t0 = now();
+      for ( size_t k = 0; k < n_steps; ++k )
+      {
+        if ( K::step<A>(p, s, v, &spikes_in[k * p.num_of_receptors_]) )
+          ++tr.spikes;
+        s.y0_ = current[k];
+        tr.u[k] = s.y3_;
+      }
+      tr.ns = std::min(tr.ns, 1e9 * (now() - t0) / n_steps);
+    }
+    return tr;
+  }
+
+  /**
+   * Learning rule of stdp_synapse_multi, as in learn_() and decays_():
+   * std::pow of the decays in tier 0, exp of dt times their logs else.
+   */
+  template <int A>
+  Trace run_stdp_multi(const std::vector<double>& dts)
+  {
+    const double tplus = 16.8, tneg = 33.7, Aplus = 0.01, Aneg = 0.0105, Wmax = 10.0;
+    double kplus = 1.0 - 1.0/tplus;
+    double kneg = 1.0 - 1.0/tneg;
+    if ( A != MATH_EXACT )
+    {
+      kplus = std::log(kplus);
+      kneg = std::log(kneg);
+    }
+
+    Trace tr;
+    tr.ns = std::numeric_limits<double>::max();
+    for ( int rep = 0; rep < n_reps; ++rep )
+    {
+      tr.u.assign(dts.size(), 0.0);
+      tr.spikes = 0;
+      double w = 1.0;
+      const double t0 = now();
+      for ( size_t i = 0; i < dts.size(); ++i )
+      {
+        const double dt = dts[i];
+        double wd, td;
+        if ( dt > 0 )
+        {
+          wd = math::exp<A>(-w) * Aplus;
+          td = A == MATH_EXACT ? std::pow(kplus, dt) : math::exp<A>(dt * kplus);
+        }
+        else
+        {
+          wd = -w * Aneg;
+          td = A == MATH_EXACT ? std::pow(kneg, -dt) : math::exp<A>(-dt * kneg);
+        }
+        const double nw = w + wd * td;
+        w = nw < 0.0 ? 0.0 : ( nw > Wmax ? Wmax : nw );
+        tr.u[i] = w;
+      }
+      tr.ns = std::min(tr.ns, 1e9 * (now() - t0) / dts.size());
+    }
+    return tr;
+  }
+}
+
+int main()
+{
+  std::srand(12345);
+  const size_t n = 1 << 20;
+
+  std::printf("%-26s %-8s %10s %12s\n", "function", "tier", "ns/call", "max rel err");
+  {
+    std::vector<double> x(n), y(n);
+    for ( size_t i = 0; i < n; ++i )
+      x[i] = uniform(-50.0, 50.0);
+    bench_function<Exp>("exp  x in [-50,50]", x, y);
+
+    for ( size_t i = 0; i < n; ++i )
+      x[i] = std::pow(10.0, uniform(-10.0, 10.0));
+    bench_function<Log>("log  x in [1e-10,1e10]", x, y);
+
+    for ( size_t i = 0; i < n; ++i )
+    {
+      x[i] = uniform(0.5, 2.0);
+      y[i] = uniform(-20.0, 20.0);
+    }
+    bench_function<Pow>("pow  x in [.5,2], |y|<20", x, y);
+  }
+
+  std::printf("\n%-26s %-8s %10s %12s %8s\n", "model", "tier", "ns/step", "max rel dev", "spikes");
+
+  std::vector<double> current, clock;
+  make_input(current, clock);
+  std::vector<Trace> tr(3);
+
+  {
+    GlifPscAlphaMultiKernel::Parameters p;
+    p.num_of_ionchannels_ = 2;
+    const double A[] = { 0.5, 0.2 }, l[] = { 5.0, 50.0 }, mu[] = { -2.0, -1.0 };
+    const double g[] = { 0.05, 0.02 }, E[] = { -5.0, 3.0 };
+    p.A_k_.assign(A, A + 2);
+    p.l_k_.assign(l, l + 2);
+    p.mu_k_.assign(mu, mu + 2);
+    p.g_k_.assign(g, g + 2);
+    p.E_k_.assign(E, E + 2);
+    p.num_of_receptors_ = 2;
+    p.tau_syn_r_.assign(2, 0.5);
+    p.tau_syn_f_.assign(2, 2.0);
+    p.i_L_ = 0.0;
+
+    std::vector<double> spikes_in(n_steps * p.num_of_receptors_, 0.0);
+    for ( size_t k = 0; k < n_steps; k += 37 )
+      spikes_in[k * p.num_of_receptors_ + (k / 37) % 2] = (k / 37) % 2 ? -1.0 : 2.0;
+
+    tr[MATH_EXACT] = run_glif<MATH_EXACT>(p, current, spikes_in);
+    tr[MATH_1E12] = run_glif<MATH_1E12>(p, current, spikes_in);
+    tr[MATH_1E7] = run_glif<MATH_1E7>(p, current, spikes_in);
+    report("glif_psc_alpha_multi", tr);
+  }
+
+  {
+    FreqSensorV2Kernel::Parameters p;
+    p.Sigma_ = 5.0;
+    p.Theta_ = 0.5;
+    tr[MATH_EXACT] = run_wavelet<FreqSensorV2Kernel, MATH_EXACT>(p, current, clock);
+    tr[MATH_1E12] = run_wavelet<FreqSensorV2Kernel, MATH_1E12>(p, current, clock);
+    tr[MATH_1E7] = run_wavelet<FreqSensorV2Kernel, MATH_1E7>(p, current, clock);
+    report("iaf_freq_sensor_v2", tr);
+  }
+
+  {
+    WsnHermitian1Kernel::Parameters p;
+    const double sigmas[] = { 2.0, 4.0, 8.0 };
+    p.Sigmas_.assign(sigmas, sigmas + 3);
+    p.N_Sigmas_ = 3;
+    p.Theta_ = 0.5;
+    tr[MATH_EXACT] = run_wavelet<WsnHermitian1Kernel, MATH_EXACT>(p, current, clock);
+    tr[MATH_1E12] = run_wavelet<WsnHermitian1Kernel, MATH_1E12>(p, current, clock);
+    tr[MATH_1E7] = run_wavelet<WsnHermitian1Kernel, MATH_1E7>(p, current, clock);
+    report("iaf_wsn_hermitian_1", tr);
+  }
+
+  {
+    WsnHermitian2Kernel::Parameters p;
+    const double sigmas[] = { 2.0, 4.0, 8.0 };
+    p.Sigmas_.assign(sigmas, sigmas + 3);
+    p.N_Sigmas_ = 3;
+    p.Theta_ = 0.5;
+    tr[MATH_EXACT] = run_wavelet<WsnHermitian2Kernel, MATH_EXACT>(p, current, clock);
+    tr[MATH_1E12] = run_wavelet<WsnHermitian2Kernel, MATH_1E12>(p, current, clock);
+    tr[MATH_1E7] = run_wavelet<WsnHermitian2Kernel, MATH_1E7>(p, current, clock);
+    report("iaf_wsn_hermitian_2", tr);
+  }
+
+  {
+    // intervals between pre- and postsynaptic spikes in ms
+    std::vector<double> dts(n);
+    for ( size_t i = 0; i < n; ++i )
+      dts[i] = uniform(-100.0, 100.0);
+    tr[MATH_EXACT] = run_stdp_multi<MATH_EXACT>(dts);
+    tr[MATH_1E12] = run_stdp_multi<MATH_1E12>(dts);
+    tr[MATH_1E7] = run_stdp_multi<MATH_1E7>(dts);
+    report("stdp_synapse_multi learn", tr);
+  }
+
+  return 0;
+}
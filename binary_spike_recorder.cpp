@@ -0,0 +1,367 @@
+/*
+ *  binary_spike_recorder.cpp
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "binary_spike_recorder.h"
+#include "network.h"
+#include "dict.h"
+#include "dictutils.h"
+#include "exceptions.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* ----------------------------------------------------------------
+ * Spike files
+ * ---------------------------------------------------------------- */
+
+namespace
+{
+  const char spike_tag[8] = { 'M', 'Y', 'S', 'P', 'I', 'K', 'E', '1' };
+  const int64_t spike_header_bytes = 32;  // tag, records, blocks, resolution
+
+  /** Write all of buf at pos, returns errno or 0. */
+  int write_at(int fd, const void* buf, size_t bytes, int64_t pos)
+  {
+    const char* p = static_cast<const char*>(buf);
+    while ( bytes > 0 )
+    {
+      const ssize_t n = pwrite(fd, p, bytes, pos);
+      if ( n < 0 )
+      {
+        if ( errno == EINTR )
+          continue;
+        return errno;
+      }
+      p += n;
+      pos += n;
+      bytes -= n;
+    }
+    return 0;
+  }
+}
+
+mynest::SpikeFileWriter::SpikeFileWriter()
+  : fd_(-1),
+    block_size_(1),
+    resolution_(0.0),
+    pending_pos_(0),
+    n_records_(0),
+    busy_(false),
+    stop_(false),
+    error_(0)
+{
+  pthread_mutex_init(&lock_, 0);
+  pthread_cond_init(&work_, 0);
+  pthread_cond_init(&idle_, 0);
+}
+
+mynest::SpikeFileWriter::~SpikeFileWriter()
+{
+  try
+  {
+    close();
+  }
+  catch ( ... )
+  {
+    // nothing to report to from a destructor
+  }
+  pthread_cond_destroy(&idle_);
+  pthread_cond_destroy(&work_);
+  pthread_mutex_destroy(&lock_);
+}
+
+void mynest::SpikeFileWriter::open(const std::string& filename, size_t block_size,
+                                   double resolution)
+{
+  assert(!is_open());
+
+  fd_ = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if ( fd_ < 0 )
+    throw IOError("Could not open " + filename + " for writing.");
+
+  filename_ = filename;
+  block_size_ = block_size;
+  resolution_ = resolution;
+  fill_.clear();
+  fill_.reserve(block_size);
+  pending_.clear();
+  pending_.reserve(block_size);
+  n_records_ = 0;
+  index_.clear();
+  busy_ = false;
+  stop_ = false;
+  error_ = 0;
+
+  if ( pthread_create(&thread_, 0, run_, this) != 0 )
+  {
+    ::close(fd_);
+    fd_ = -1;
+    throw IOError("Could not start the writer thread for " + filename + ".");
+  }
+
+  // the file is valid, and empty, from the start
+  flush();
+}
+
+void mynest::SpikeFileWriter::close()
+{
+  if ( !is_open() )
+    return;
+
+  int error = 0;
+  try
+  {
+    flush();
+  }
+  catch ( ... )
+  {
+    error = 1;
+  }
+
+  pthread_mutex_lock(&lock_);
+  stop_ = true;
+  pthread_cond_signal(&work_);
+  pthread_mutex_unlock(&lock_);
+  pthread_join(thread_, 0);
+
+  ::close(fd_);
+  fd_ = -1;
+
+  if ( error )
+    throw IOError("Could not write " + filename_ + ".");
+}
+
+void mynest::SpikeFileWriter::hand_off_()
+{
+  if ( fill_.empty() )
+    return;
+
+  pthread_mutex_lock(&lock_);
+  wait_idle_();
+  check_error_();
+
+  SpikeBlock b;
+  b.first = n_records_;
+  b.n = fill_.size();
+  b.min_step = fill_[0].step;
+  b.max_step = fill_[0].step;
+  for ( size_t i = 1; i < fill_.size(); ++i )
+  {
+    b.min_step = std::min<int64_t>(b.min_step, fill_[i].step);
+    b.max_step = std::max<int64_t>(b.max_step, fill_[i].step);
+  }
+  index_.push_back(b);
+
+  pending_.swap(fill_);
+  fill_.clear();
+  pending_pos_ = spike_header_bytes + n_records_ * static_cast<int64_t>(sizeof(SpikeRecord));
+  n_records_ += b.n;
+  busy_ = true;
+
+  pthread_cond_signal(&work_);
+  pthread_mutex_unlock(&lock_);
+}
+
+void mynest::SpikeFileWriter::flush()
+{
+  hand_off_();
+
+  pthread_mutex_lock(&lock_);
+  wait_idle_();
+  check_error_();
+  pthread_mutex_unlock(&lock_);
+
+  // the index follows the records and replaces the one of the last flush
+  const int64_t index_pos = spike_header_bytes + n_records_ * static_cast<int64_t>(sizeof(SpikeRecord));
+  const int64_t counts[2] = { n_records_, static_cast<int64_t>(index_.size()) };
+
+  char head[spike_header_bytes];
+  std::memcpy(head, spike_tag, sizeof(spike_tag));
+  std::memcpy(head + 8, counts, sizeof(counts));
+  std::memcpy(head + 24, &resolution_, sizeof(double));
+
+  int error = 0;
+  if ( !index_.empty() )
+    error = write_at(fd_, &index_[0], index_.size() * sizeof(SpikeBlock), index_pos);
+  if ( error == 0 )
+    error = write_at(fd_, head, sizeof(head), 0);
+  if ( error == 0 && ftruncate(fd_, index_pos + index_.size() * sizeof(SpikeBlock)) != 0 )
+    error = errno;
+
+  if ( error != 0 )
+    throw IOError("Could not write " + filename_ + ": " + std::strerror(error));
+}
+
+void mynest::SpikeFileWriter::wait_idle_()
+{
+  while ( busy_ )
+    pthread_cond_wait(&idle_, &lock_);
+}
+
+void mynest::SpikeFileWriter::check_error_()
+{
+  if ( error_ == 0 )
+    return;
+
+  const int error = error_;
+  error_ = 0;
+  pthread_mutex_unlock(&lock_);
+  throw IOError("Could not write " + filename_ + ": " + std::strerror(error));
+}
+
+void* mynest::SpikeFileWriter::run_(void* arg)
+{
+  SpikeFileWriter& w = *static_cast<SpikeFileWriter*>(arg);
+
+  pthread_mutex_lock(&w.lock_);
+  while ( true )
+  {
+    while ( !w.busy_ && !w.stop_ )
+      pthread_cond_wait(&w.work_, &w.lock_);
+    if ( !w.busy_ )
+      break;
+
+    // the block is written without the lock, the simulation fills the other one
+    pthread_mutex_unlock(&w.lock_);
+    const int error = write_at(w.fd_, &w.pending_[0], w.pending_.size() * sizeof(SpikeRecord),
+                               w.pending_pos_);
+    pthread_mutex_lock(&w.lock_);
+
+    if ( error != 0 )
+      w.error_ = error;
+    w.busy_ = false;
+    pthread_cond_signal(&w.idle_);
+  }
+  pthread_mutex_unlock(&w.lock_);
+  return 0;
+}
+
+/* ----------------------------------------------------------------
+ * Default constructors defining default parameter
+ * ---------------------------------------------------------------- */
+
+mynest::binary_spike_recorder::Parameters_::Parameters_()
+  : label_(""),
+    block_size_(65536)
+{}
+
+/* ----------------------------------------------------------------
+ * Parameter extraction and manipulation functions
+ * ---------------------------------------------------------------- */
+
+void mynest::binary_spike_recorder::Parameters_::get(DictionaryDatum &d) const
+{
+  def<std::string>(d, "label", label_);
+  def<long>(d, "block_size", block_size_);
+}
+
+void mynest::binary_spike_recorder::Parameters_::set(const DictionaryDatum& d)
+{
+  updateValue<std::string>(d, "label", label_);
+  updateValue<long>(d, "block_size", block_size_);
+
+  if ( block_size_ < 1 )
+    throw BadProperty("The block size must be >= 1.");
+}
+
+/* ----------------------------------------------------------------
+ * Default and copy constructor for node
+ * ---------------------------------------------------------------- */
+
+mynest::binary_spike_recorder::binary_spike_recorder()
+  : Node(),
+    device_(),
+    P_(),
+    writer_()
+{}
+
+mynest::binary_spike_recorder::binary_spike_recorder(const binary_spike_recorder& n)
+  : Node(n),
+    device_(n.device_),
+    P_(n.P_),
+    writer_()
+{}
+
+/* ----------------------------------------------------------------
+ * Status
+ * ---------------------------------------------------------------- */
+
+void mynest::binary_spike_recorder::get_status(DictionaryDatum &d) const
+{
+  P_.get(d);
+  device_.get_status(d);
+
+  def<std::string>(d, "filename", writer_.filename());
+  def<long>(d, "n_records", writer_.is_open() ? writer_.n_records() : 0);
+}
+
+void mynest::binary_spike_recorder::set_status(const DictionaryDatum &d)
+{
+  Parameters_ ptmp = P_;  // temporary copy in case of errors
+  ptmp.set(d);            // throws if BadProperty
+
+  device_.set_status(d);
+
+  // if we get here, temporaries contain consistent set of properties
+  if ( ptmp.label_ != P_.label_ || ptmp.block_size_ != P_.block_size_ )
+    writer_.close();
+  P_ = ptmp;
+}
+
+/* ----------------------------------------------------------------
+ * Node initialization functions
+ * ---------------------------------------------------------------- */
+
+void mynest::binary_spike_recorder::init_state_(const Node& proto)
+{
+  const binary_spike_recorder& pr = downcast<binary_spike_recorder>(proto);
+
+  device_.init_state(pr.device_);
+}
+
+void mynest::binary_spike_recorder::init_buffers_()
+{
+  device_.init_buffers();
+}
+
+void mynest::binary_spike_recorder::calibrate()
+{
+  device_.calibrate();
+
+  if ( writer_.is_open() )
+    return;
+
+  std::ostringstream name;
+  name << (P_.label_.empty() ? get_name() : P_.label_)
+       << '-' << get_gid() << '-' << get_vp() << ".spk";
+  writer_.open(name.str(), P_.block_size_, Time::get_resolution().get_ms());
+}
+
+void mynest::binary_spike_recorder::finalize()
+{
+  if ( writer_.is_open() )
+    writer_.flush();
+}
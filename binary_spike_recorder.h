@@ -0,0 +1,258 @@
+/*
+ *  binary_spike_recorder.h
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef BINARY_SPIKE_RECORDER_H
+#define BINARY_SPIKE_RECORDER_H
+
+#include "nest.h"
+#include "event.h"
+#include "node.h"
+#include "device.h"
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <pthread.h>
+
+/* BeginDocumentation
+Name: binary_spike_recorder - Device writing spikes to a binary file.
+
+Description:
+
+  binary_spike_recorder records the spikes of the neurons connected to it,
+  like spike_detector, but writes them as fixed-width binary records
+  instead of text. Each spike is written when it is delivered, there is no
+  formatting and no per-spike buffering of events.
+
+  There is one instance of the device per thread, and each instance writes
+  its own file, label-gid-vp.spk. The records are collected in a block in
+  memory; a full block is handed to a writer thread of the instance, which
+  writes it while the simulation fills the next block. The simulation
+  waits only if the writer falls one full block behind. At the end of
+  each call to Simulate, the last partial block is written and the header
+  and index are updated, so the file is complete between simulations.
+
+  All numbers are 64 bit and in native byte order. The file consists of
+
+    header   8 byte tag "MYSPIKE1", number of records, number of blocks,
+             resolution in ms as double
+    records  gid, step, offset in ms as double, one per spike
+    index    first record, number of records, smallest step, largest step,
+             one entry per block
+
+  The index starts after the last record, at 32 + 24 * records bytes. The
+  file can be memory-mapped and the records read in place; the index
+  finds the blocks covering a time window. Within a block, records are in
+  order of delivery, not strictly by step. Spikes with multiplicity n
+  yield n records.
+
+Parameters:
+
+  label       string - Prefix of the file name, the model name by default.
+  block_size  int    - Records per block, default 65536.
+  filename    string - File written by this instance (read only).
+  n_records   int    - Records written by this instance (read only).
+
+  The parameters origin, start and stop of all devices apply.
+
+Remarks:
+
+  Setting label or block_size closes the file; the next Simulate starts a
+  new one.
+
+Receives: SpikeEvent
+
+Author: Zhenzhong Wang
+SeeAlso: spike_detector, trace_current_generator
+*/
+
+using namespace nest;
+namespace mynest
+{
+
+  class Network;
+
+  /**
+   * Record of one spike in a binary spike file.
+   */
+  struct SpikeRecord
+  {
+    uint64_t gid;
+    int64_t  step;
+    double   offset;  //!< Precise spike time offset in ms
+  };
+
+  /**
+   * Index entry of one block of records.
+   */
+  struct SpikeBlock
+  {
+    int64_t first;     //!< Number of the first record
+    int64_t n;         //!< Records in the block
+    int64_t min_step;
+    int64_t max_step;
+  };
+
+  /**
+   * Double-buffered binary spike file with a writer thread.
+   *
+   * put() appends to the block being filled. A full block is swapped with
+   * the block of the writer thread, which writes it with pwrite() while
+   * the caller continues. flush() writes the partial block, the header and
+   * the index and waits until all is on file. Write errors of the writer
+   * thread are reported by the next hand-off or flush.
+   */
+  class SpikeFileWriter
+  {
+  public:
+
+    SpikeFileWriter();
+    ~SpikeFileWriter();
+
+    /** Create the file and start the writer thread. */
+    void open(const std::string& filename, size_t block_size, double resolution);
+
+    /** Flush, stop the writer thread and close the file. */
+    void close();
+
+    bool is_open() const { return fd_ >= 0; }
+
+    void put(uint64_t gid, int64_t step, double offset)
+    {
+      const SpikeRecord r = { gid, step, offset };
+      fill_.push_back(r);
+      if ( fill_.size() >= block_size_ )
+        hand_off_();
+    }
+
+    /** Write all records, the header and the index. */
+    void flush();
+
+    const std::string& filename() const { return filename_; }
+    int64_t n_records() const { return n_records_ + fill_.size(); }
+
+  private:
+
+    SpikeFileWriter(const SpikeFileWriter&);
+    SpikeFileWriter& operator=(const SpikeFileWriter&);
+
+    void hand_off_();     //!< Pass the filled block to the writer thread
+    void wait_idle_();    //!< Wait until the writer thread is idle, lock held
+    void check_error_();  //!< Throw if the writer thread failed, lock held
+
+    static void* run_(void*);
+
+    std::string filename_;
+    int fd_;
+    size_t block_size_;
+    double resolution_;
+
+    std::vector<SpikeRecord> fill_;     //!< Block being filled
+    std::vector<SpikeRecord> pending_;  //!< Block being written
+    int64_t pending_pos_;               //!< File position of pending_
+
+    int64_t n_records_;                 //!< Records handed off so far
+    std::vector<SpikeBlock> index_;
+
+    pthread_t thread_;
+    pthread_mutex_t lock_;
+    pthread_cond_t work_;  //!< Signals a block or stop to the writer
+    pthread_cond_t idle_;  //!< Signals a written block to the simulation
+    bool busy_;            //!< pending_ is being written
+    bool stop_;
+    int error_;            //!< errno of a failed write, 0 if none
+  };
+
+  /**
+   * Spike recorder writing through a SpikeFileWriter.
+   */
+  class binary_spike_recorder : public Node
+  {
+
+  public:
+
+    binary_spike_recorder();
+    binary_spike_recorder(const binary_spike_recorder&);
+
+    bool has_proxies() const { return false; }
+    bool local_receiver() const { return true; }
+
+    using Node::connect_sender;
+    using Node::handle;
+
+    port connect_sender(SpikeEvent&, port);
+    void handle(SpikeEvent&);
+
+    void get_status(DictionaryDatum &) const;
+    void set_status(const DictionaryDatum &);
+
+  private:
+
+    void init_state_(const Node&);
+    void init_buffers_();
+    void calibrate();
+    void finalize();
+
+    void update(Time const &, const long_t, const long_t) {}
+
+    // ------------------------------------------------------------
+
+    struct Parameters_ {
+      std::string label_;  //!< Prefix of the file name
+      long_t block_size_;  //!< Records per block
+
+      Parameters_();  //!< Sets default parameter values
+
+      void get(DictionaryDatum&) const;  //!< Store current values in dictionary
+      void set(const DictionaryDatum&);  //!< Set values from dictionary
+    };
+
+    // ------------------------------------------------------------
+
+    Device device_;
+    Parameters_ P_;
+
+    SpikeFileWriter writer_;  //!< Not copied, each instance writes its own file
+  };
+
+  inline
+  port binary_spike_recorder::connect_sender(SpikeEvent&, port receptor_type)
+  {
+    if ( receptor_type != 0 )
+      throw UnknownReceptorType(receptor_type, get_name());
+    return 0;
+  }
+
+  inline
+  void binary_spike_recorder::handle(SpikeEvent& e)
+  {
+    if ( !device_.is_active(e.get_stamp()) )
+      return;
+
+    const int64_t step = e.get_stamp().get_steps();
+    for ( int_t i = 0; i < e.get_multiplicity(); ++i )
+      writer_.put(e.get_sender_gid(), step, e.get_offset());
+  }
+
+} // namespace
+
+#endif /* #ifndef BINARY_SPIKE_RECORDER_H */
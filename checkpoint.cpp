@@ -0,0 +1,297 @@
+/*
+ *  checkpoint.cpp
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "checkpoint.h"
+#include "exceptions.h"
+#include "network.h"
+#include "node.h"
+#include "nestmodule.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace mynest
+{
+
+  /* ----------------------------------------------------------------
+   * Writer and reader
+   * ---------------------------------------------------------------- */
+
+  void CheckpointWriter::put(const std::vector<double_t>& v)
+  {
+    data_.push_back(v.size());
+    data_.insert(data_.end(), v.begin(), v.end());
+  }
+
+  void CheckpointWriter::put(const std::vector<int_t>& v)
+  {
+    data_.push_back(v.size());
+    data_.insert(data_.end(), v.begin(), v.end());
+  }
+
+  void CheckpointWriter::put(const ArenaArray& v)
+  {
+    data_.push_back(v.size());
+    data_.insert(data_.end(), v.begin(), v.end());
+  }
+
+  void CheckpointWriter::put(RingBuffer& b)
+  {
+    data_.push_back(b.size());
+    for ( size_t k = 0; k < b.size(); ++k )
+    {
+      const double_t x = b.get_value(k);  // clears the entry
+      b.set_value(k, x);
+      data_.push_back(x);
+    }
+  }
+
+  void CheckpointWriter::put(std::vector<RingBuffer>& b)
+  {
+    data_.push_back(b.size());
+    for ( size_t i = 0; i < b.size(); ++i )
+      put(b[i]);
+  }
+
+  inline
+  double_t CheckpointReader::next_()
+  {
+    if ( pos_ == end_ )
+      throw BadProperty("Checkpoint record is too short for this node.");
+    return *pos_++;
+  }
+
+  void CheckpointReader::check_size_(size_t n, const char* msg)
+  {
+    if ( static_cast<size_t>(next_()) != n )
+      throw BadProperty(msg);
+    if ( check_ )
+    {
+      if ( static_cast<size_t>(end_ - pos_) < n )
+        throw BadProperty("Checkpoint record is too short for this node.");
+      pos_ += n;
+    }
+  }
+
+  void CheckpointReader::get(double_t& x)
+  {
+    const double_t y = next_();
+    if ( !check_ )
+      x = y;
+  }
+
+  void CheckpointReader::get(int_t& x)
+  {
+    const double_t y = next_();
+    if ( !check_ )
+      x = static_cast<int_t>(y);
+  }
+
+  void CheckpointReader::get(long_t& x)
+  {
+    const double_t y = next_();
+    if ( !check_ )
+      x = static_cast<long_t>(y);
+  }
+
+  void CheckpointReader::get(bool& x)
+  {
+    const double_t y = next_();
+    if ( !check_ )
+      x = y != 0.0;
+  }
+
+  void CheckpointReader::get(std::vector<double_t>& v)
+  {
+    check_size_(v.size(), "Checkpoint record does not match the size of the node.");
+    if ( !check_ )
+      for ( size_t i = 0; i < v.size(); ++i )
+        v[i] = next_();
+  }
+
+  void CheckpointReader::get(std::vector<int_t>& v)
+  {
+    check_size_(v.size(), "Checkpoint record does not match the size of the node.");
+    if ( !check_ )
+      for ( size_t i = 0; i < v.size(); ++i )
+        v[i] = static_cast<int_t>(next_());
+  }
+
+  void CheckpointReader::get(ArenaArray& v)
+  {
+    check_size_(v.size(), "Checkpoint record does not match the size of the node.");
+    if ( !check_ )
+      for ( size_t i = 0; i < v.size(); ++i )
+        v[i] = next_();
+  }
+
+  void CheckpointReader::get(RingBuffer& b)
+  {
+    check_size_(b.size(), "Checkpoint ring buffer does not match, "
+                          "the delays of the network have changed.");
+    if ( !check_ )
+      for ( size_t k = 0; k < b.size(); ++k )
+        b.set_value(k, next_());
+  }
+
+  void CheckpointReader::get(std::vector<RingBuffer>& b)
+  {
+    if ( static_cast<size_t>(next_()) != b.size() )
+      throw BadProperty("Checkpoint record does not match the size of the node.");
+    for ( size_t i = 0; i < b.size(); ++i )
+      get(b[i]);
+  }
+
+  /* ----------------------------------------------------------------
+   * Checkpoint files
+   * ---------------------------------------------------------------- */
+
+  namespace
+  {
+    // tag at the start of checkpoint files, includes a format version
+    const char checkpoint_tag[8] = { 'M', 'Y', 'C', 'K', 'P', 'T', '0', '1' };
+
+    const size_t header_words = 3;  // tag, number of records, flags
+    const size_t index_words = 4;   // gid, model id, offset, length
+  }
+
+  void save_checkpoint(const std::string& filename, bool with_buffers)
+  {
+    Network& net = NestModule::get_network();
+
+    std::vector<int64_t> index;
+    CheckpointWriter w;
+
+    for ( nest::index gid = 1; gid < net.size(); ++gid )
+    {
+      if ( !net.is_local_gid(gid) )
+        continue;
+
+      Node* node = net.get_node(gid);
+      Checkpointable* c = dynamic_cast<Checkpointable*>(node);
+      if ( c == 0 )
+        continue;
+
+      const size_t offset = w.data().size();
+      c->save_checkpoint(w, with_buffers);
+
+      index.push_back(gid);
+      index.push_back(node->get_model_id());
+      index.push_back(offset);
+      index.push_back(w.data().size() - offset);
+    }
+
+    std::ofstream out(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if ( !out )
+      throw IOError("Could not open " + filename + " for writing.");
+
+    const int64_t header[2] = { static_cast<int64_t>(index.size() / index_words),
+                                with_buffers ? 1 : 0 };
+    out.write(checkpoint_tag, sizeof(checkpoint_tag));
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    if ( !index.empty() )
+      out.write(reinterpret_cast<const char*>(&index[0]), index.size() * sizeof(int64_t));
+    if ( !w.data().empty() )
+      out.write(reinterpret_cast<const char*>(&w.data()[0]), w.data().size() * sizeof(double_t));
+
+    if ( !out )
+      throw IOError("Could not write " + filename + ".");
+  }
+
+  void load_checkpoint(const std::string& filename)
+  {
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if ( fd < 0 )
+      throw IOError("Could not open " + filename + " for reading.");
+
+    struct stat st;
+    if ( fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(header_words * 8) )
+    {
+      close(fd);
+      throw IOError(filename + " is not a checkpoint file.");
+    }
+
+    const size_t bytes = st.st_size;
+    void* map = mmap(0, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if ( map == MAP_FAILED )
+      throw IOError("Could not map " + filename + ".");
+
+    // the mapping is released on every exit from here on
+    struct Unmap
+    {
+      void* p;
+      size_t n;
+      ~Unmap() { munmap(p, n); }
+    } unmap = { map, bytes };
+
+    const char* base = static_cast<const char*>(map);
+    const int64_t* words = reinterpret_cast<const int64_t*>(base);
+    if ( std::memcmp(base, checkpoint_tag, sizeof(checkpoint_tag)) != 0 )
+      throw IOError(filename + " is not a checkpoint file.");
+
+    const int64_t n = words[1];
+    const bool with_buffers = words[2] != 0;
+    const int64_t* index = words + header_words;
+    const double_t* data = reinterpret_cast<const double_t*>(index + n * index_words);
+    const double_t* data_end = reinterpret_cast<const double_t*>(base + bytes);
+    if ( n < 0 || data > data_end )
+      throw IOError(filename + " is truncated.");
+
+    Network& net = NestModule::get_network();
+
+    // check the index before reading any record
+    std::vector<Checkpointable*> nodes(n);
+    for ( int64_t r = 0; r < n; ++r )
+    {
+      const int64_t* e = index + r * index_words;
+      if ( e[0] <= 0 || static_cast<nest::index>(e[0]) >= net.size() || !net.is_local_gid(e[0]) )
+        throw BadProperty("Checkpoint contains nodes that are not part of this network.");
+
+      Node* node = net.get_node(e[0]);
+      if ( static_cast<int64_t>(node->get_model_id()) != e[1] )
+        throw BadProperty("Checkpoint was saved from nodes of a different model.");
+      if ( e[2] < 0 || e[3] < 0 || data + e[2] + e[3] > data_end )
+        throw IOError(filename + " is truncated.");
+
+      nodes[r] = dynamic_cast<Checkpointable*>(node);
+      assert(nodes[r] != 0);
+    }
+
+    // check all records before changing any node, then load them
+    for ( int pass = 0; pass < 2; ++pass )
+      for ( int64_t r = 0; r < n; ++r )
+      {
+        const int64_t* e = index + r * index_words;
+        CheckpointReader reader(data + e[2], data + e[2] + e[3], pass == 0);
+        nodes[r]->load_checkpoint(reader, with_buffers);
+        if ( !reader.at_end() )
+          throw BadProperty("Checkpoint record is too long for this node.");
+      }
+  }
+
+} // namespace
@@ -0,0 +1,174 @@
+/*
+ *  checkpoint.h
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "nest.h"
+#include "ring_buffer.h"
+#include "neuron_arena.h"
+
+#include <string>
+#include <vector>
+
+/* BeginDocumentation
+  Name: SaveCheckpoint - Save the state of all module neurons to a file.
+
+  Synopsis:
+   (filename) with_buffers SaveCheckpoint -> -
+   (filename) LoadCheckpoint -> -
+
+  Description:
+   SaveCheckpoint writes the dynamic state (the S_ structure) of every
+   local node of this module to a binary file. If with_buffers is true,
+   the pending contents of the input ring buffers are saved as well, so
+   that spikes and currents in transit are not lost.
+
+   LoadCheckpoint restores the state into the existing nodes, without
+   re-creating or re-connecting them. Nodes are matched by gid and model,
+   so the file can also be loaded into a network built in the same way
+   in another session. Parameters are not part of the checkpoint.
+   All records are checked first; if one does not fit its node, no node
+   is changed.
+
+   The file consists of 64 bit words: an 8 byte tag, the number of
+   records n, a flag for buffers, an index of n entries (gid, model id,
+   offset, length) and the records as doubles. Offset and length are
+   counted in doubles from the start of the records, so the file can be
+   memory-mapped and each record read in place.
+
+  Remarks:
+   Only nodes local to the calling process are saved. With MPI, give
+   each process its own file name. Checkpoints must be saved and loaded
+   between calls to Simulate. The spike history of archiving nodes is not
+   saved.
+
+  Author: Zhenzhong Wang
+  SeeAlso: GetSynapseColumns, SaveSynapseColumns
+*/
+
+using namespace nest;
+
+namespace mynest
+{
+
+  /**
+   * Collects the state of one node as a sequence of doubles.
+   */
+  class CheckpointWriter
+  {
+  public:
+
+    void put(double_t x) { data_.push_back(x); }
+
+    /** Store size and contents of v. */
+    void put(const std::vector<double_t>& v);
+    void put(const std::vector<int_t>& v);
+    void put(const ArenaArray& v);
+
+    /** Store the pending contents of b without consuming them. */
+    void put(RingBuffer& b);
+    void put(std::vector<RingBuffer>& b);
+
+    const std::vector<double_t>& data() const { return data_; }
+    void clear() { data_.clear(); }
+
+  private:
+
+    std::vector<double_t> data_;
+  };
+
+  /**
+   * Reads the state of one node in the order it was written. Throws
+   * BadProperty if the record does not fit the node.
+   *
+   * A reader made with check true only checks the record: get() consumes
+   * the words and compares the sizes, but leaves its argument unchanged.
+   * load_checkpoint() runs every record through such a reader before it
+   * changes any node, so nodes must not change anything else either
+   * while checking().
+   */
+  class CheckpointReader
+  {
+  public:
+
+    CheckpointReader(const double_t* begin, const double_t* end, bool check = false)
+      : pos_(begin),
+        end_(end),
+        check_(check)
+    {}
+
+    void get(double_t& x);
+    void get(int_t& x);
+    void get(long_t& x);
+    void get(bool& x);
+
+    /** Read v, which must have the size it had when saved. */
+    void get(std::vector<double_t>& v);
+    void get(std::vector<int_t>& v);
+    void get(ArenaArray& v);
+
+    /** Replace the pending contents of b. */
+    void get(RingBuffer& b);
+    void get(std::vector<RingBuffer>& b);
+
+    /**
+     * Next word of the record, also while checking. For the values that
+     * decide how the rest of the record is read.
+     */
+    double_t read() { return next_(); }
+
+    bool checking() const { return check_; }
+    bool at_end() const { return pos_ == end_; }
+
+  private:
+
+    double_t next_();
+
+    /** Read the size word of a container and compare it with n. */
+    void check_size_(size_t n, const char* msg);
+
+    const double_t* pos_;
+    const double_t* end_;
+    bool check_;
+  };
+
+  /**
+   * Interface of nodes that can be checkpointed. Saving is not const,
+   * since reading a ring buffer entry clears it.
+   */
+  class Checkpointable
+  {
+  public:
+
+    virtual ~Checkpointable() {}
+
+    virtual void save_checkpoint(CheckpointWriter&, bool with_buffers) = 0;
+    virtual void load_checkpoint(CheckpointReader&, bool with_buffers) = 0;
+  };
+
+  void save_checkpoint(const std::string& filename, bool with_buffers);
+  void load_checkpoint(const std::string& filename);
+
+} // namespace
+
+#endif /* #ifndef CHECKPOINT_H */
@@ -23,10 +23,10 @@
 #ifndef DROP_ODD_SPIKE_CONNECTION_H
 #define DROP_ODD_SPIKE_CONNECTION_H
 
-#include "connection_het_wd.h"
+#include "filter_connection.h"
 
 /* BeginDocumentation
-  Name: drop_odd_spike - Synapse dropping spikes with odd time stamps.
+  Name: drop_odd_synapse - Synapse dropping spikes with odd time stamps.
 
   Description:
   This synapse will not deliver any spikes with odd time stamps, while spikes with even
@@ -34,59 +34,15 @@
 
   Transmits: SpikeEvent
 
-  Remarks:
-  This synapse type is provided only for illustration purposes in MyModule.
-
-  SeeAlso: synapsedict
+  SeeAlso: synapsedict, every_nth_synapse, bernoulli_synapse
 */
 
 namespace mynest {
 
 /**
- * Connection class for illustration purposes.
+ * Connection dropping odd time stamps, see FilterConnection.
  */
-class DropOddSpikeConnection : public nest::ConnectionHetWD
-{
- public:
-
-  /**
-   * Default Constructor.
-   * Sets default values for all parameters. Needed by GenericConnectorModel.
-   */
-  DropOddSpikeConnection() : ConnectionHetWD() {}
-
-  /**
-   * Default Destructor.
-   */
-  ~DropOddSpikeConnection() {}
-
-  /**
-   * Send an event to the receiver of this connection.
-   * @param e The event to send
-   * @param t_lastspike Point in time of last spike sent.
-   * @param cp Common properties to all synapses (empty).
-   */
-  void send(nest::Event& e, nest::double_t t_lastspike,
-            const nest::CommonSynapseProperties &cp);
-
-  //! Defining this as empty means we can handle spike events
-  using Connection::check_event;  // see http://www.gotw.ca/gotw/005.htm
-  void check_event(nest::SpikeEvent&) {}
-
-};
-
-
-inline
-void DropOddSpikeConnection::send(nest::Event& e, nest::double_t last,
-                                  const nest::CommonSynapseProperties &props)
-{
-  if ( e.get_stamp().get_steps() % 2 ) // stamp is odd, drop it
-    return;
-
-  // Even time stamp, we send the spike using the normal sending mechnism
-  // send the spike to the target
-  nest::ConnectionHetWD::send(e, last, props);
-}
+typedef FilterConnection<DropOddPolicy> DropOddSpikeConnection;
 
 } // namespace
 
@@ -0,0 +1,87 @@
+/*
+ *  filter_connection.cpp
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filter_connection.h"
+#include "generic_connector.h"
+#include "generic_connector_model.h"
+#include "common_synapse_properties.h"
+
+namespace
+{
+  class BernoulliConnector;
+
+  typedef mynest::FilterConnection<mynest::BernoulliPolicy> BernoulliConnection;
+  typedef nest::GenericConnectorModel<BernoulliConnection, nest::CommonSynapseProperties,
+                                      BernoulliConnector> BernoulliModel;
+  typedef nest::GenericConnector<BernoulliConnection, nest::CommonSynapseProperties,
+                                 BernoulliModel> BernoulliConnectorBase;
+
+  // connectors are created and deleted serially, by Connect and ResetKernel
+  size_t bernoulli_connectors = 0;
+
+  class BernoulliConnector : public BernoulliConnectorBase
+  {
+  public:
+
+    BernoulliConnector(BernoulliModel& cm)
+      : BernoulliConnectorBase(cm)
+    {
+      ++bernoulli_connectors;
+    }
+
+    ~BernoulliConnector()
+    {
+      if ( --bernoulli_connectors == 0 )
+        mynest::BernoulliPolicy::restart();
+    }
+  };
+}
+
+namespace mynest
+{
+
+  uint64_t BernoulliPolicy::seed_ = 0;
+  BernoulliPolicy::Counter BernoulliPolicy::counters_[BernoulliPolicy::max_threads];
+
+  void BernoulliPolicy::set_seed_(const DictionaryDatum& d)
+  {
+    long seed = 0;
+    if ( !updateValue<long>(d, "seed", seed) )
+      return;
+
+    restart();
+    seed_ = static_cast<uint64_t>(seed);
+  }
+
+  void BernoulliPolicy::restart()
+  {
+    seed_ = 0;
+    for ( size_t t = 0; t < max_threads; ++t )
+      counters_[t].n = 0;
+  }
+
+  nest::synindex register_bernoulli_connection(nest::Network& net, const std::string& name)
+  {
+    return net.register_synapse_prototype(new BernoulliModel(net, name));
+  }
+
+} // namespace
@@ -0,0 +1,335 @@
+/*
+ *  filter_connection.h
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef FILTER_CONNECTION_H
+#define FILTER_CONNECTION_H
+
+#include "connection_het_wd.h"
+#include "dictutils.h"
+#include "exceptions.h"
+#include "network.h"
+
+#include <string>
+#include <stdint.h>
+
+/* BeginDocumentation
+  Name: every_nth_synapse - Static synapse delivering every n-th spike.
+
+  Description:
+   every_nth_synapse counts the spikes it receives and delivers the n-th,
+   2n-th, ... spike unchanged. The other spikes are dropped.
+
+  Parameters:
+   n          int    - Period of delivery, 1 to 65535
+
+  Transmits: SpikeEvent
+
+  SeeAlso: drop_odd_synapse, bernoulli_synapse, static_synapse
+*/
+
+/* BeginDocumentation
+  Name: bernoulli_synapse - Static synapse with probabilistic release.
+
+  Description:
+   bernoulli_synapse delivers each spike unchanged with probability p and
+   drops it otherwise. The random numbers are drawn from a counter-based
+   generator: the k-th draw on thread t is a hash of (seed, t, k). There is
+   no generator state in the synapse and one 64 bit counter per thread.
+
+  Parameters:
+   p          double - Release probability, 0 to 1
+   seed       int    - Seed of the generator, shared by all bernoulli
+                       synapses. Setting it restarts the counters.
+
+  Remarks:
+   p is stored in single precision. Results are reproducible for a fixed
+   number of threads. ResetKernel restores the default seed and restarts
+   the counters. ResetNetwork keeps both; set seed again to repeat a
+   simulation after it.
+
+  Transmits: SpikeEvent
+
+  SeeAlso: drop_odd_synapse, every_nth_synapse, static_synapse
+*/
+
+namespace mynest
+{
+
+  /**
+   * Static connection that asks a filter policy whether to deliver each
+   * spike. The policy is a template argument, so the test is inlined into
+   * send(), and its state is stored in the connection next to the weight.
+   *
+   * A policy provides
+   *   bool deliver(const nest::Event&, nest::thread)
+   *   void get(DictionaryDatum&) const
+   *   void set(const DictionaryDatum&)
+   *   void set(const DictionaryDatum&, nest::index p)
+   *   void initialize_property_arrays(DictionaryDatum&) const
+   *   void append_properties(DictionaryDatum&) const
+   */
+  template <class Policy>
+  class FilterConnection : public nest::ConnectionHetWD
+  {
+  public:
+
+    FilterConnection() : ConnectionHetWD(), policy_() {}
+
+    ~FilterConnection() {}
+
+    void get_status(DictionaryDatum& d) const
+    {
+      ConnectionHetWD::get_status(d);
+      policy_.get(d);
+    }
+
+    void set_status(const DictionaryDatum& d, nest::ConnectorModel& cm)
+    {
+      ConnectionHetWD::set_status(d, cm);
+      policy_.set(d);
+    }
+
+    void set_status(const DictionaryDatum& d, nest::index p, nest::ConnectorModel& cm)
+    {
+      ConnectionHetWD::set_status(d, p, cm);
+      policy_.set(d, p);
+    }
+
+    void initialize_property_arrays(DictionaryDatum& d) const
+    {
+      ConnectionHetWD::initialize_property_arrays(d);
+      policy_.initialize_property_arrays(d);
+    }
+
+    void append_properties(DictionaryDatum& d) const
+    {
+      ConnectionHetWD::append_properties(d);
+      policy_.append_properties(d);
+    }
+
+    /**
+     * Send an event to the receiver of this connection, if the policy
+     * lets it pass.
+     * @param e The event to send
+     * @param t_lastspike Point in time of last spike sent.
+     * @param cp Common properties to all synapses (empty).
+     */
+    void send(nest::Event& e, nest::double_t t_lastspike,
+              const nest::CommonSynapseProperties& cp)
+    {
+      if ( policy_.deliver(e, target_->get_thread()) )
+        ConnectionHetWD::send(e, t_lastspike, cp);
+    }
+
+    //! Defining this as empty means we can handle spike events
+    using Connection::check_event;
+    void check_event(nest::SpikeEvent&) {}
+
+  private:
+
+    Policy policy_;
+  };
+
+  /* ----------------------------------------------------------------
+   * Policies
+   * ---------------------------------------------------------------- */
+
+  /**
+   * Drops spikes with odd time stamps, no state.
+   */
+  class DropOddPolicy
+  {
+  public:
+
+    bool deliver(const nest::Event& e, nest::thread) const
+    {
+      return e.get_stamp().get_steps() % 2 == 0;
+    }
+
+    void get(DictionaryDatum&) const {}
+    void set(const DictionaryDatum&) {}
+    void set(const DictionaryDatum&, nest::index) {}
+    void initialize_property_arrays(DictionaryDatum&) const {}
+    void append_properties(DictionaryDatum&) const {}
+  };
+
+  /**
+   * Delivers every n-th spike, four bytes of state.
+   */
+  class EveryNthPolicy
+  {
+  public:
+
+    EveryNthPolicy() : n_(1), count_(0) {}
+
+    bool deliver(const nest::Event&, nest::thread)
+    {
+      if ( ++count_ < n_ )
+        return false;
+      count_ = 0;
+      return true;
+    }
+
+    void get(DictionaryDatum& d) const
+    {
+      def<long>(d, "n", n_);
+    }
+
+    void set(const DictionaryDatum& d)
+    {
+      long n = n_;
+      updateValue<long>(d, "n", n);
+      set_n_(n);
+    }
+
+    void set(const DictionaryDatum& d, nest::index p)
+    {
+      long n = n_;
+      nest::set_property<long>(d, "n", p, n);
+      set_n_(n);
+    }
+
+    void initialize_property_arrays(DictionaryDatum& d) const
+    {
+      nest::initialize_property_array(d, "n");
+    }
+
+    void append_properties(DictionaryDatum& d) const
+    {
+      nest::append_property<long>(d, "n", static_cast<long>(n_));
+    }
+
+  private:
+
+    void set_n_(long n)
+    {
+      if ( n < 1 || n > 65535 )
+        throw nest::BadProperty("n must be between 1 and 65535.");
+      n_ = static_cast<uint16_t>(n);
+      count_ = 0;
+    }
+
+    uint16_t n_;
+    uint16_t count_;
+  };
+
+  /**
+   * Delivers each spike with probability p, four bytes of state.
+   */
+  class BernoulliPolicy
+  {
+  public:
+
+    BernoulliPolicy() : p_(1.0f) {}
+
+    bool deliver(const nest::Event&, nest::thread t) const
+    {
+      // upper 32 bits of the hash, scaled to [0, 1)
+      return (draw_(t) >> 32) * (1.0 / 4294967296.0) < p_;
+    }
+
+    void get(DictionaryDatum& d) const
+    {
+      def<double>(d, "p", p_);
+      def<long>(d, "seed", static_cast<long>(seed_));
+    }
+
+    void set(const DictionaryDatum& d)
+    {
+      double p = p_;
+      updateValue<double>(d, "p", p);
+      set_p_(p);
+      set_seed_(d);
+    }
+
+    void set(const DictionaryDatum& d, nest::index i)
+    {
+      double p = p_;
+      nest::set_property<double>(d, "p", i, p);
+      set_p_(p);
+    }
+
+    void initialize_property_arrays(DictionaryDatum& d) const
+    {
+      nest::initialize_property_array(d, "p");
+    }
+
+    void append_properties(DictionaryDatum& d) const
+    {
+      nest::append_property<double>(d, "p", p_);
+    }
+
+    /**
+     * Default seed and counters from 0. Called when the last connector of
+     * bernoulli_synapse is deleted, as by ResetKernel.
+     */
+    static void restart();
+
+  private:
+
+    /** Threads beyond this share counters, without locking. */
+    static const size_t max_threads = 64;
+
+    /** One counter per cache line. */
+    struct Counter
+    {
+      uint64_t n;
+      char pad[56];
+    };
+
+    static uint64_t draw_(nest::thread t)
+    {
+      const uint64_t k = counters_[t % max_threads].n++;
+      uint64_t x = seed_ ^ (static_cast<uint64_t>(t) << 40) ^ k;
+
+      // splitmix64 finalizer
+      x += 0x9E3779B97F4A7C15ULL;
+      x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+      return x ^ (x >> 31);
+    }
+
+    void set_p_(double p)
+    {
+      if ( p < 0.0 || p > 1.0 )
+        throw nest::BadProperty("p must be between 0 and 1.");
+      p_ = static_cast<float>(p);
+    }
+
+    static void set_seed_(const DictionaryDatum& d);
+
+    float p_;
+
+    static uint64_t seed_;
+    static Counter counters_[max_threads];
+  };
+
+  /**
+   * Register bernoulli_synapse with connectors that restart BernoulliPolicy
+   * when the last of them is deleted. Use instead of
+   * nest::register_prototype_connection().
+   */
+  nest::synindex register_bernoulli_connection(nest::Network& net, const std::string& name);
+
+} // namespace
+
+#endif /* #ifndef FILTER_CONNECTION_H */
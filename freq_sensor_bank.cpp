@@ -0,0 +1,442 @@
+/*
+ *  freq_sensor_bank.cpp
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "exceptions.h"
+#include "freq_sensor_bank.h"
+#include "network.h"
+#include "dict.h"
+#include "integerdatum.h"
+#include "doubledatum.h"
+#include "arraydatum.h"
+#include "dictutils.h"
+#include "numerics.h"
+#include "universal_data_logger_impl.h"
+
+#include <limits>
+
+nest::RecordablesMap<mynest::freq_sensor_bank> mynest::freq_sensor_bank::recordablesMap_;
+using namespace nest;
+
+namespace nest
+{
+
+  /*
+   * Override the create() method with one call to RecordablesMap::insert_()
+   * for each quantity to be recorded.
+   */
+  template <>
+  void RecordablesMap<mynest::freq_sensor_bank>::create()
+  {
+    // per-channel state is available through GetStatus
+    insert_("Currents", &mynest::freq_sensor_bank::get_y0_);
+  }
+}
+
+namespace mynest
+{
+  /* ----------------------------------------------------------------
+   * Default constructors defining default parameters and state
+   * ---------------------------------------------------------------- */
+
+  mynest::freq_sensor_bank::Parameters_::Parameters_()
+    : Tau_       (  30.0   ),  // ms
+      C_         (   1.0   ),  // pF
+      TauR_      (   2.0   ),  // ms
+      U0_        (   0.0   ),  // mV
+      I_e_       (   0.0   ),  // pA
+      V_reset_   ( -10.0   ),  // mV, rel to U0_
+      Theta_     (  -1.0   ),  // mV, rel to U0_
+      LowerBound_(-std::numeric_limits<double_t>::infinity()),
+      Sigma_     ( 1, 30.0 ),
+      Ti_        ( 1, 50.0 ),  // ms
+      senders_   ()
+  {}
+
+  mynest::freq_sensor_bank::State_::State_()
+    : y0_   (0.0),
+      ti_   (-std::numeric_limits<double_t>::infinity()),
+      y1_   (1, 0.0),
+      y2_   (1, 0.0),
+      y3_   (1, 0.0),
+      currents_ (1, 0.0),
+      r_    (1, 0)
+  {}
+
+  void mynest::freq_sensor_bank::State_::resize(size_t n)
+  {
+    y1_.resize(n, 0.0);
+    y2_.resize(n, 0.0);
+    y3_.resize(n, 0.0);
+    currents_.resize(n, 0.0);
+    r_.resize(n, 0);
+  }
+
+  /* ----------------------------------------------------------------
+   * Parameter and state extractions and manipulation functions
+   * ---------------------------------------------------------------- */
+
+  void mynest::freq_sensor_bank::Parameters_::get(DictionaryDatum &d) const
+  {
+    def<double>(d, names::E_L, U0_);   // Resting potential
+    def<double>(d, names::I_e, I_e_);
+    def<double>(d, names::V_th, Theta_+U0_); // threshold value
+    def<double>(d, names::V_reset, V_reset_+U0_);
+    def<double>(d, names::V_min, LowerBound_+U0_);
+    def<double>(d, names::C_m, C_);
+    def<double>(d, names::tau_m, Tau_);
+    def<double>(d, names::t_ref, TauR_);
+    def<int>(d, "n_channels", n_channels());
+
+    ArrayDatum Sigma_ad(Sigma_);
+    ArrayDatum Ti_ad(Ti_);
+    ArrayDatum senders_ad(senders_);
+    def<ArrayDatum>(d, "Sigma", Sigma_ad);
+    def<ArrayDatum>(d, "Ti", Ti_ad);
+    def<ArrayDatum>(d, names::senders, senders_ad);
+  }
+
+  double mynest::freq_sensor_bank::Parameters_::set(const DictionaryDatum& d)
+  {
+    // if U0_ is changed, we need to adjust all variables defined relative to U0_
+    const double ELold = U0_;
+    updateValue<double>(d, names::E_L, U0_);
+    const double delta_EL = U0_ - ELold;
+
+    updateValue<double>(d, names::V_reset, V_reset_);
+    updateValue<double>(d, names::V_th, Theta_);
+    updateValue<double>(d, names::V_min, LowerBound_);
+
+    updateValue<double>(d, names::I_e, I_e_);
+    updateValue<double>(d, names::C_m, C_);
+    updateValue<double>(d, names::tau_m, Tau_);
+    updateValue<double>(d, names::t_ref, TauR_);
+
+    updateValue<std::vector<double> >(d, "Sigma", Sigma_);
+    updateValue<std::vector<double> >(d, "Ti", Ti_);
+    updateValue<std::vector<long> >(d, names::senders, senders_);
+
+    if ( Sigma_.empty() )
+      throw BadProperty("The bank needs at least one channel.");
+
+    if ( Ti_.size() != Sigma_.size() )
+      throw BadProperty("Sigma and Ti must have one entry per channel.");
+
+    if ( !senders_.empty() && senders_.size() != Sigma_.size() )
+      throw BadProperty("senders must be empty or have one entry per channel.");
+
+    for ( size_t i = 0; i < Sigma_.size(); ++i )
+    {
+      if ( Sigma_[i] <= 0.0 )
+        throw BadProperty("All Sigma constants must be > 0.");
+      if ( Ti_[i] <= 0.0 )
+        throw BadProperty("Integration time must be > 0.");
+    }
+
+    if ( C_ <= 0.0 )
+      throw BadProperty("Capacitance must be > 0.");
+
+    if ( Tau_ <= 0.0 )
+      throw BadProperty("Membrane time constant must be > 0.");
+
+    if ( TauR_ < 0.0 )
+    	throw BadProperty("The refractory time t_ref can't be negative.");
+
+    return delta_EL;
+  }
+
+  void mynest::freq_sensor_bank::State_::get(DictionaryDatum &d, const Parameters_& p) const
+  {
+    std::vector<double> V_m(y3_.begin(), y3_.end());
+    ArrayDatum V_m_ad(V_m);
+    def<ArrayDatum>(d, names::V_m, V_m_ad); // Membrane potentials
+  }
+
+  void mynest::freq_sensor_bank::State_::set(const DictionaryDatum& d, const Parameters_& p, double delta_EL)
+  {
+    std::vector<double> V_m;
+    if ( updateValue<std::vector<double> >(d, names::V_m, V_m) )
+    {
+      if ( V_m.size() != y3_.size() )
+        throw BadProperty("V_m must have one entry per channel.");
+      y3_.assign(V_m.begin(), V_m.end());
+    }
+  }
+
+  mynest::freq_sensor_bank::Buffers_::Buffers_(freq_sensor_bank& n)
+    : logger_(n)
+  {}
+
+  mynest::freq_sensor_bank::Buffers_::Buffers_(const Buffers_ &, freq_sensor_bank& n)
+    : logger_(n)
+  {}
+
+
+  /* ----------------------------------------------------------------
+   * Default and copy constructor for node
+   * ---------------------------------------------------------------- */
+
+  mynest::freq_sensor_bank::freq_sensor_bank()
+    : Node(),
+      P_(),
+      S_(),
+      B_(*this)
+  {
+    recordablesMap_.create();
+  }
+
+  mynest::freq_sensor_bank::freq_sensor_bank(const freq_sensor_bank& n)
+    : Node(n),
+      P_(n.P_),
+      S_(n.S_),
+      B_(n.B_, *this)
+  {}
+
+  /* ----------------------------------------------------------------
+   * Node initialization functions
+   * ---------------------------------------------------------------- */
+
+  void mynest::freq_sensor_bank::init_state_(const Node& proto)
+  {
+    const freq_sensor_bank& pr = downcast<freq_sensor_bank>(proto);
+    S_ = pr.S_;
+  }
+
+  void mynest::freq_sensor_bank::init_buffers_()
+  {
+    B_.clock_.clear();          // includes resize
+    B_.encoding_.clear();
+    B_.currents_.clear();
+
+    B_.logger_.reset();
+  }
+
+  void mynest::freq_sensor_bank::calibrate()
+  {
+    B_.logger_.init();  // ensures initialization in case mm connected after Simulate
+
+    const double h = Time::get_resolution().get_ms();
+    const size_t n = P_.n_channels();
+
+    V_.P21_.resize(n);
+    V_.P22_.resize(n);
+    V_.half_Ti_.resize(n);
+    for ( size_t i = 0; i < n; ++i )
+    {
+      V_.P21_[i] = 2.0 / (std::sqrt(3.0*P_.Sigma_[i]) * std::pow(numerics::pi,0.25) * P_.Sigma_[i]);
+      V_.P22_[i] = - 1.0 / (P_.Sigma_[i] * P_.Sigma_[i]);
+      V_.half_Ti_[i] = P_.Ti_[i] / 2.0;
+    }
+
+    V_.P33_ = std::exp(-h/P_.Tau_);
+    V_.P31_ = P_.Tau_ /P_.C_ * (1.0 - V_.P33_);
+
+    // refractory period rounded to the grid, see iaf_freq_sensor
+    V_.RefractoryCounts_ = Time(Time::ms(P_.TauR_)).get_steps();
+    assert(V_.RefractoryCounts_ >= 0);  // since t_ref_ >= 0, this can only fail in error
+
+    // the network sends spikes from the thread of their sender, so all
+    // senders must live on the thread of the bank
+    V_.senders_.assign(n, this);
+    for ( size_t i = 0; i < P_.senders_.size(); ++i )
+    {
+      Node* s = network()->get_node(P_.senders_[i], get_thread());
+      if ( s->is_proxy() || s->get_thread() != get_thread() )
+        throw BadProperty("All senders must be local to the thread of the bank.");
+      V_.senders_[i] = s;
+    }
+
+    V_.spiked_.assign(n, 0);
+    S_.resize(n);
+  }
+
+  /* ----------------------------------------------------------------
+   * Update and spike handling functions
+   */
+
+  void mynest::freq_sensor_bank::update(Time const & origin, const long_t from, const long_t to)
+  {
+    assert(to >= 0 && (delay) from < Scheduler::get_min_delay());
+    assert(from < to);
+
+    const double h = Time::get_resolution().get_ms();
+    const size_t n = P_.n_channels();
+
+    double_t* const y1 = &S_.y1_[0];
+    double_t* const y2 = &S_.y2_[0];
+    double_t* const y3 = &S_.y3_[0];
+    double_t* const cur = &S_.currents_[0];
+    int_t* const r = &S_.r_[0];
+    const double_t* const P21 = &V_.P21_[0];
+    const double_t* const P22 = &V_.P22_[0];
+    const double_t* const half_Ti = &V_.half_Ti_[0];
+    char* const spiked = &V_.spiked_[0];
+
+    for ( long_t lag = from ; lag < to ; ++lag )
+    {
+      const double t = Time(Time::step(origin.get_steps()+lag+1)).get_ms();
+
+      if ( B_.clock_.get_value(lag) > 0.1 )
+      {
+        // Integration spike arrive
+        for ( size_t i = 0; i < n; ++i )
+        {
+          y1[i] = 0.0;
+          y2[i] = 0.0;
+          cur[i] = 0.0;
+        }
+        S_.ti_ = t;
+      }
+      if ( B_.encoding_.get_value(lag) > 0.1 )
+      {
+        // Encoding spike arrive
+        for ( size_t i = 0; i < n; ++i )
+        {
+          y3[i] = P_.V_reset_;
+          y1[i] = 1.0;
+        }
+      }
+
+      // wavelet times relative to the last clock spike, shared by all channels
+      const double_t t_mid = t + h/2.0 - S_.ti_;
+      const double_t t_end = t + h - S_.ti_;
+      const double_t y0 = S_.y0_;
+
+      for ( size_t i = 0; i < n; ++i )
+      {
+        const double_t Vm0 = y3[i];
+
+        if ( r[i] == 0 )
+        {
+          // neuron not refractory
+          y3[i] = V_.P33_ * y3[i] + V_.P31_ * y1[i] * std::abs(y2[i]);
+          y1[i] = V_.P33_ * y1[i];
+
+          //Simpson's method for v integration
+          double_t tt_m = t_mid - half_Ti[i];
+          tt_m = P22[i] * tt_m * tt_m;
+          double_t tt_e = t_end - half_Ti[i];
+          tt_e = P22[i] * tt_e * tt_e;
+
+          const double_t c_mid = y0 * P21[i] * (1.0 + tt_m) * std::exp(tt_m/2.0);
+          const double_t c_end = y0 * P21[i] * (1.0 + tt_e) * std::exp(tt_e/2.0);
+          y2[i] += (cur[i] + 4.0 * c_mid + c_end) * h / 6.0;
+          cur[i] = c_end;
+
+          // lower bound of membrane potential
+          y3[i] = ( y3[i] < P_.LowerBound_ ? P_.LowerBound_ : y3[i]);
+          y2[i] = ( y2[i] < P_.LowerBound_ ? P_.LowerBound_ : y2[i]);
+          y1[i] = ( y1[i] < P_.LowerBound_ ? P_.LowerBound_ : y1[i]);
+        }
+        else // neuron is absolute refractory
+          --r[i];
+
+        spiked[i] = Vm0 < P_.Theta_ && y3[i] >= P_.Theta_;
+      }
+
+      // resets and spike emission, kept out of the integration loop
+      for ( size_t i = 0; i < n; ++i )
+      {
+        if ( !spiked[i] )
+          continue;
+
+        r[i]  = V_.RefractoryCounts_;
+        y3[i] = P_.U0_;
+        y2[i] = 0.0;
+        y1[i] = 0.0;
+
+        SpikeEvent se;
+        network()->send(*V_.senders_[i], se, lag);
+      }
+
+      // set new input current
+      S_.y0_ = B_.currents_.get_value(lag);
+
+      // log state data
+      B_.logger_.record_data(origin.get_steps() + lag);
+    }
+  }
+
+  void mynest::freq_sensor_bank::handle(SpikeEvent& e)
+  {
+    assert(e.get_delay() > 0);
+
+    RingBuffer& buf = e.get_rport() == 1 ? B_.clock_ : B_.encoding_;
+    buf.add_value(e.get_rel_delivery_steps(network()->get_slice_origin()),
+                  e.get_weight() * e.get_multiplicity());
+  }
+
+  void mynest::freq_sensor_bank::handle(CurrentEvent& e)
+  {
+    assert(e.get_delay() > 0);
+
+    const double_t I = e.get_current();
+    const double_t w = e.get_weight();
+
+    B_.currents_.add_value(e.get_rel_delivery_steps(network()->get_slice_origin()), w * I);
+  }
+
+  void mynest::freq_sensor_bank::handle(DataLoggingRequest& e)
+  {
+    B_.logger_.handle(e);
+  }
+
+  /* ----------------------------------------------------------------
+   * Checkpointing, see checkpoint.h
+   * ---------------------------------------------------------------- */
+
+  void mynest::freq_sensor_bank::save_checkpoint(CheckpointWriter& w, bool with_buffers)
+  {
+    w.put(S_.y0_);
+    w.put(S_.ti_);
+    w.put(S_.y1_);
+    w.put(S_.y2_);
+    w.put(S_.y3_);
+    w.put(S_.currents_);
+    w.put(S_.r_);
+
+    if ( with_buffers )
+    {
+      w.put(B_.clock_);
+      w.put(B_.encoding_);
+      w.put(B_.currents_);
+    }
+  }
+
+  void mynest::freq_sensor_bank::load_checkpoint(CheckpointReader& r, bool with_buffers)
+  {
+    r.get(S_.y0_);
+    r.get(S_.ti_);
+    r.get(S_.y1_);
+    r.get(S_.y2_);
+    r.get(S_.y3_);
+    r.get(S_.currents_);
+    r.get(S_.r_);
+
+    if ( with_buffers )
+    {
+      r.get(B_.clock_);
+      r.get(B_.encoding_);
+      r.get(B_.currents_);
+    }
+  }
+
+} // namespace
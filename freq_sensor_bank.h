@@ -0,0 +1,345 @@
+/*
+ *  freq_sensor_bank.h
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef FREQ_SENSOR_BANK_H
+#define FREQ_SENSOR_BANK_H
+
+#include "nest.h"
+#include "event.h"
+#include "node.h"
+#include "ring_buffer.h"
+#include "connection.h"
+#include "universal_data_logger.h"
+#include "recordables_map.h"
+#include "checkpoint.h"
+
+#include <vector>
+
+/* BeginDocumentation
+Name: freq_sensor_bank - Bank of iaf_freq_sensor channels sharing one input.
+
+Description:
+
+  freq_sensor_bank holds N iaf_freq_sensor channels in a single node. All
+  channels share the input current, the clock spikes and the encoding
+  spikes, and differ only in their wavelet parameters Sigma and Ti. Each
+  input event is buffered once for the whole bank instead of once per
+  neuron, and all channels are updated in one loop over contiguous
+  per-channel arrays.
+
+  The dynamics of each channel are identical to iaf_freq_sensor.
+
+  Spikes of channel i are sent with the node given in senders[i] as
+  sender, so that downstream neurons and spike detectors see one gid per
+  channel. Any node can serve as sender, a parrot_neuron without inputs is
+  the natural choice. Outgoing connections of a channel are made from its
+  sender node. If senders is empty, all channels send from the bank itself.
+
+Parameters:
+
+  The following parameters are shared by all channels.
+
+  E_L        double - Resting membrane potential in mV.
+  C_m        double - Capacity of the membrane in pF
+  tau_m      double - Membrane time constant in ms.
+  t_ref      double - Duration of refractory period in ms.
+  V_th       double - Spike threshold in mV.
+  V_reset    double - Reset potential of the membrane in mV.
+  V_min      double - Absolute lower value for the membrane potential.
+
+  The following parameters are given per channel.
+
+  Sigma      array  - Wavelet scale factors in ms.
+  Ti         array  - Wavelet convolution lengths in ms.
+  senders    array  - Gids of the nodes that send the spikes of each channel.
+  V_m        array  - Membrane potentials in mV.
+  n_channels int    - Number of channels (read only).
+
+Receptor types:
+
+  1 - clock spikes, reset the wavelet integration
+  2 - encoding spikes, reset the membrane potential
+
+Remarks:
+
+  Spikes can only be sent from nodes on the same thread as the bank. The
+  sender nodes are looked up when the simulation starts, and a BadProperty
+  exception is raised if one of them lives on another thread or process.
+
+Sends: SpikeEvent
+
+Receives: SpikeEvent, CurrentEvent, DataLoggingRequest
+
+Author: Zhenzhong Wang
+SeeAlso: iaf_freq_sensor, parrot_neuron
+*/
+using namespace nest;
+namespace mynest
+{
+  class Network;
+
+  /**
+   * N iaf_freq_sensor channels sharing one input stream.
+   */
+  class freq_sensor_bank : public Node, public Checkpointable
+  {
+
+  public:
+
+    freq_sensor_bank();
+    freq_sensor_bank(const freq_sensor_bank&);
+
+    /**
+     * Import sets of overloaded virtual functions.
+     * @see Technical Issues / Virtual Functions: Overriding, Overloading, and Hiding
+     */
+
+    using Node::connect_sender;
+    using Node::handle;
+
+    port check_connection(Connection&, port);
+
+    void handle(SpikeEvent &);
+    void handle(CurrentEvent &);
+    void handle(DataLoggingRequest &);
+
+    port connect_sender(SpikeEvent&, port);
+    port connect_sender(CurrentEvent&, port);
+    port connect_sender(DataLoggingRequest &, port);
+
+    void get_status(DictionaryDatum &) const;
+    void set_status(const DictionaryDatum &);
+
+    void save_checkpoint(CheckpointWriter&, bool);
+    void load_checkpoint(CheckpointReader&, bool);
+
+  private:
+
+    void init_state_(const Node& proto);
+    void init_buffers_();
+    void calibrate();
+
+    void update(Time const &, const long_t, const long_t);
+
+    // The next two classes need to be friends to access the State_ class/member
+    friend class RecordablesMap<freq_sensor_bank>;
+    friend class UniversalDataLogger<freq_sensor_bank>;
+
+    // ----------------------------------------------------------------
+
+    struct Parameters_ {
+
+      /** Membrane time constant in ms. */
+      double_t Tau_;
+
+      /** Membrane capacitance in pF. */
+      double_t C_;
+
+      /** Refractory period in ms. */
+      double_t TauR_;
+
+      /** Resting potential in mV. */
+      double_t U0_;
+
+      /** External current in pA */
+      double_t I_e_;
+
+      /** Reset value of the membrane potential */
+      double_t V_reset_;
+
+      /** Threshold, RELATIVE TO RESTING POTENTIAL(!).
+          I.e. the real threshold is (U0_+Theta_). */
+      double_t Theta_;
+
+      /** Lower bound, RELATIVE TO RESTING POTENTIAL(!).
+          I.e. the real lower bound is (LowerBound_+U0_). */
+      double_t LowerBound_;
+
+      /** Wavelet scale factor of each channel **/
+      std::vector<double> Sigma_;
+
+      /** Wavelet convolution length of each channel **/
+      std::vector<double> Ti_;
+
+      /** Gids of the sender nodes of each channel **/
+      std::vector<long> senders_;
+
+      Parameters_();  //!< Sets default parameter values
+
+      size_t n_channels() const { return Sigma_.size(); }
+
+      void get(DictionaryDatum&) const;  //!< Store current values in dictionary
+
+      /** Set values from dictionary.
+       * @returns Change in reversal potential E_L, to be passed to State_::set()
+       */
+      double set(const DictionaryDatum&);
+
+    };
+
+    // ----------------------------------------------------------------
+
+    /**
+     * Per-channel state is kept in one array per variable, so that the
+     * update loop runs over contiguous memory.
+     */
+    struct State_ {
+      double_t y0_;                 //!< Constant current, shared
+      double_t ti_;                 //!< Time of last clock spike, shared
+      std::vector<double_t> y1_;    //s(t)
+      std::vector<double_t> y2_;    //v(t)
+      std::vector<double_t> y3_;    //!< Membrane potential RELATIVE TO RESTING POTENTIAL.
+      std::vector<double_t> currents_;
+      std::vector<int_t>    r_;     //!< Number of refractory steps remaining
+
+      State_();  //!< Default initialization
+
+      /** Resize the channel arrays, new channels start at rest */
+      void resize(size_t);
+
+      void get(DictionaryDatum&, const Parameters_&) const;
+
+      /** Set values from dictionary.
+       * @param dictionary to take data from
+       * @param current parameters
+       * @param Change in reversal potential E_L specified by this dict
+       */
+      void set(const DictionaryDatum&, const Parameters_&, double);
+
+    };
+
+    // ----------------------------------------------------------------
+
+    struct Buffers_ {
+
+      Buffers_(freq_sensor_bank&);
+      Buffers_(const Buffers_&, freq_sensor_bank&);
+
+      /** buffers and summs up incoming spikes/currents, once for all channels */
+      RingBuffer clock_;
+      RingBuffer encoding_;
+      RingBuffer currents_;
+
+      //! Logger for all analog data
+      UniversalDataLogger<freq_sensor_bank> logger_;
+
+    };
+
+    // ----------------------------------------------------------------
+
+    struct Variables_ {
+
+      int_t    RefractoryCounts_;
+      double_t P31_;
+      double_t P33_;
+
+      std::vector<double_t> P21_;     //!< Wavelet amplitude of each channel
+      std::vector<double_t> P22_;     //!< -1/Sigma^2 of each channel
+      std::vector<double_t> half_Ti_; //!< Wavelet center of each channel
+
+      std::vector<Node*> senders_;    //!< Resolved sender nodes
+      std::vector<char>  spiked_;     //!< Channels crossing threshold in this step
+
+    };
+
+    // Access functions for UniversalDataLogger -------------------------------
+
+    double_t get_y0_() const { return S_.y0_; }
+
+    // Data members -----------------------------------------------------------
+
+    /**
+     * @defgroup freq_sensor_bank_data
+     * Instances of private data structures for the different types
+     * of data pertaining to the model.
+     * @note The order of definitions is important for speed.
+     * @{
+     */
+    Parameters_ P_;
+    State_      S_;
+    Variables_  V_;
+    Buffers_    B_;
+    /** @} */
+
+    //! Mapping of recordables names to access functions
+    static RecordablesMap<freq_sensor_bank> recordablesMap_;
+  };
+
+  inline
+  port freq_sensor_bank::check_connection(Connection& c, port receptor_type)
+  {
+    SpikeEvent e;
+    e.set_sender(*this);
+    c.check_event(e);
+    return c.get_target()->connect_sender(e, receptor_type);
+  }
+
+  inline
+  port freq_sensor_bank::connect_sender(SpikeEvent&, port receptor_type)
+  {
+    if (receptor_type < 1 || receptor_type > 2)
+      throw IncompatibleReceptorType(receptor_type, get_name(), "SpikeEvent");
+    return receptor_type;
+  }
+
+  inline
+  port freq_sensor_bank::connect_sender(CurrentEvent&, port receptor_type)
+  {
+    if (receptor_type != 0)
+      throw UnknownReceptorType(receptor_type, get_name());
+    return 0;
+  }
+
+  inline
+  port freq_sensor_bank::connect_sender(DataLoggingRequest& dlr, port receptor_type)
+  {
+    if (receptor_type != 0)
+      throw UnknownReceptorType(receptor_type, get_name());
+    return B_.logger_.connect_logging_device(dlr, recordablesMap_);
+  }
+
+  inline
+  void freq_sensor_bank::get_status(DictionaryDatum &d) const
+  {
+    P_.get(d);
+    S_.get(d, P_);
+
+    (*d)[names::recordables] = recordablesMap_.get_list();
+  }
+
+  inline
+  void freq_sensor_bank::set_status(const DictionaryDatum &d)
+  {
+    Parameters_ ptmp = P_;            // temporary copy in case of errors
+    const double delta_EL = ptmp.set(d);         // throws if BadProperty
+    State_      stmp = S_;            // temporary copy in case of errors
+    stmp.resize(ptmp.n_channels());
+    stmp.set(d, ptmp, delta_EL);                 // throws if BadProperty
+
+    // if we get here, temporaries contain consistent set of properties
+    P_ = ptmp;
+    S_ = stmp;
+  }
+
+} // namespace
+
+#endif /* #ifndef FREQ_SENSOR_BANK_H */
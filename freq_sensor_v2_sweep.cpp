@@ -0,0 +1,417 @@
+/*
+ *  freq_sensor_v2_sweep.cpp
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "exceptions.h"
+#include "freq_sensor_v2_sweep.h"
+#include "network.h"
+#include "dict.h"
+#include "integerdatum.h"
+#include "doubledatum.h"
+#include "arraydatum.h"
+#include "dictutils.h"
+#include "numerics.h"
+#include "universal_data_logger_impl.h"
+
+#include <limits>
+
+nest::RecordablesMap<mynest::freq_sensor_v2_sweep> mynest::freq_sensor_v2_sweep::recordablesMap_;
+using namespace nest;
+
+namespace nest
+{
+
+  /*
+   * Override the create() method with one call to RecordablesMap::insert_()
+   * for each quantity to be recorded.
+   */
+  template <>
+  void RecordablesMap<mynest::freq_sensor_v2_sweep>::create()
+  {
+    // per-variant state is available through GetStatus
+    insert_("Ie", &mynest::freq_sensor_v2_sweep::get_Ie_);
+  }
+}
+
+namespace mynest
+{
+  /* ----------------------------------------------------------------
+   * Default constructors defining default parameters and state
+   * ---------------------------------------------------------------- */
+
+  mynest::freq_sensor_v2_sweep::Parameters_::Parameters_()
+    : C_         (   1.0   ),  // pF
+      TauR_      (   2.0   ),  // ms
+      U0_        (   0.0   ),  // mV
+      V_reset_   ( -10.0   ),  // mV, rel to U0_
+      Theta_     (  -1.0   ),  // mV, rel to U0_
+      LowerBound_(-std::numeric_limits<double_t>::infinity()),
+      clock_     (    0    ),
+      math_accuracy_( MATH_EXACT ),
+      Sigma_     ( 1, 30.0 ),
+      Tau_       ( 1, 30.0 ),  // ms
+      D_Int_     ( 1, 0.0  ),  // ms
+      senders_   ()
+  {}
+
+  mynest::freq_sensor_v2_sweep::State_::State_()
+    : Ie_   (0.0),
+      t_clk_(-std::numeric_limits<double_t>::infinity()),
+      u_    (1, 0.0),
+      v0_   (1, 0.0),
+      v1_   (1, 0.0),
+      s_    (1, 0.0),
+      r_    (1, 0)
+  {}
+
+  void mynest::freq_sensor_v2_sweep::State_::resize(size_t n)
+  {
+    u_.resize(n, 0.0);
+    v0_.resize(n, 0.0);
+    v1_.resize(n, 0.0);
+    s_.resize(n, 0.0);
+    r_.resize(n, 0);
+  }
+
+  /* ----------------------------------------------------------------
+   * Parameter and state extractions and manipulation functions
+   * ---------------------------------------------------------------- */
+
+  void mynest::freq_sensor_v2_sweep::Parameters_::get(DictionaryDatum &d) const
+  {
+    def<double>(d, names::E_L, U0_);   // Resting potential
+    def<double>(d, names::V_th, Theta_+U0_); // threshold value
+    def<double>(d, names::V_reset, V_reset_+U0_);
+    def<double>(d, names::V_min, LowerBound_+U0_);
+    def<double>(d, names::C_m, C_);
+    def<double>(d, names::t_ref, TauR_);
+    def<long>(d, "clock", clock_);
+    def<long>(d, "math_accuracy", math_accuracy_);
+    def<int>(d, "n_variants", n_variants());
+
+    ArrayDatum Sigma_ad(Sigma_);
+    ArrayDatum Tau_ad(Tau_);
+    ArrayDatum D_Int_ad(D_Int_);
+    ArrayDatum senders_ad(senders_);
+    def<ArrayDatum>(d, "Sigma", Sigma_ad);
+    def<ArrayDatum>(d, names::tau_m, Tau_ad);
+    def<ArrayDatum>(d, "D_Int", D_Int_ad);
+    def<ArrayDatum>(d, names::senders, senders_ad);
+  }
+
+  double mynest::freq_sensor_v2_sweep::Parameters_::set(const DictionaryDatum& d)
+  {
+    // if U0_ is changed, we need to adjust all variables defined relative to U0_
+    const double ELold = U0_;
+    updateValue<double>(d, names::E_L, U0_);
+    const double delta_EL = U0_ - ELold;
+
+    updateValue<double>(d, names::V_reset, V_reset_);
+    updateValue<double>(d, names::V_th, Theta_);
+    updateValue<double>(d, names::V_min, LowerBound_);
+
+    updateValue<double>(d, names::C_m, C_);
+    updateValue<double>(d, names::t_ref, TauR_);
+    updateValue<long>(d, "clock", clock_);
+    updateValue<long>(d, "math_accuracy", math_accuracy_);
+
+    updateValue<std::vector<double> >(d, "Sigma", Sigma_);
+    updateValue<std::vector<double> >(d, names::tau_m, Tau_);
+    updateValue<std::vector<double> >(d, "D_Int", D_Int_);
+    updateValue<std::vector<long> >(d, names::senders, senders_);
+
+    if ( Sigma_.empty() )
+      throw BadProperty("The sweep needs at least one variant.");
+
+    if ( Tau_.size() != Sigma_.size() || D_Int_.size() != Sigma_.size() )
+      throw BadProperty("Sigma, tau_m and D_Int must have one entry per variant.");
+
+    if ( !senders_.empty() && senders_.size() != Sigma_.size() )
+      throw BadProperty("senders must be empty or have one entry per variant.");
+
+    for ( size_t i = 0; i < Sigma_.size(); ++i )
+    {
+      if ( Tau_[i] <= 0.0 )
+        throw BadProperty("Membrane time constant must be > 0.");
+      if ( D_Int_[i] < 0.0 )
+        throw BadProperty("Integration time must be >= 0.");
+    }
+
+    if ( C_ <= 0.0 )
+      throw BadProperty("Capacitance must be > 0.");
+
+    if ( TauR_ < 0.0 )
+    	throw BadProperty("The refractory time t_ref can't be negative.");
+
+    if ( clock_ < 0 )
+        throw BadProperty("clock must be the gid of a sensor_clock or 0.");
+
+    if ( !math::valid_accuracy(math_accuracy_) )
+        throw BadProperty("math_accuracy must be 0, 1 or 2.");
+
+    return delta_EL;
+  }
+
+  void mynest::freq_sensor_v2_sweep::State_::get(DictionaryDatum &d, const Parameters_& p) const
+  {
+    std::vector<double> V_m(u_.begin(), u_.end());
+    ArrayDatum V_m_ad(V_m);
+    def<ArrayDatum>(d, names::V_m, V_m_ad); // Membrane potentials
+  }
+
+  void mynest::freq_sensor_v2_sweep::State_::set(const DictionaryDatum& d, const Parameters_& p, double delta_EL)
+  {
+    std::vector<double> V_m;
+    if ( updateValue<std::vector<double> >(d, names::V_m, V_m) )
+    {
+      if ( V_m.size() != u_.size() )
+        throw BadProperty("V_m must have one entry per variant.");
+      u_.assign(V_m.begin(), V_m.end());
+    }
+  }
+
+  mynest::freq_sensor_v2_sweep::Buffers_::Buffers_(freq_sensor_v2_sweep& n)
+    : logger_(n)
+  {}
+
+  mynest::freq_sensor_v2_sweep::Buffers_::Buffers_(const Buffers_ &, freq_sensor_v2_sweep& n)
+    : logger_(n)
+  {}
+
+
+  /* ----------------------------------------------------------------
+   * Default and copy constructor for node
+   * ---------------------------------------------------------------- */
+
+  mynest::freq_sensor_v2_sweep::freq_sensor_v2_sweep()
+    : Node(),
+      P_(),
+      S_(),
+      B_(*this)
+  {
+    recordablesMap_.create();
+  }
+
+  mynest::freq_sensor_v2_sweep::freq_sensor_v2_sweep(const freq_sensor_v2_sweep& n)
+    : Node(n),
+      P_(n.P_),
+      S_(n.S_),
+      B_(n.B_, *this)
+  {}
+
+  /* ----------------------------------------------------------------
+   * Node initialization functions
+   * ---------------------------------------------------------------- */
+
+  void mynest::freq_sensor_v2_sweep::init_state_(const Node& proto)
+  {
+    const freq_sensor_v2_sweep& pr = downcast<freq_sensor_v2_sweep>(proto);
+    S_ = pr.S_;
+  }
+
+  void mynest::freq_sensor_v2_sweep::init_buffers_()
+  {
+    B_.spikes_.clear();         // includes resize
+    B_.currents_.clear();
+
+    B_.logger_.reset();
+  }
+
+  void mynest::freq_sensor_v2_sweep::calibrate()
+  {
+    B_.logger_.init();  // ensures initialization in case mm connected after Simulate
+
+    switch ( P_.math_accuracy_ )
+    {
+    case MATH_1E12: V_.update_tier_ = &freq_sensor_v2_sweep::update_<MATH_1E12>; break;
+    case MATH_1E7:  V_.update_tier_ = &freq_sensor_v2_sweep::update_<MATH_1E7>; break;
+    default:        V_.update_tier_ = &freq_sensor_v2_sweep::update_<MATH_EXACT>; break;
+    }
+
+    const double h = Time::get_resolution().get_ms();
+    const size_t n = P_.n_variants();
+
+    // refractory period rounded to the grid, see iaf_freq_sensor_v2
+    const int_t refractory_counts = Time(Time::ms(P_.TauR_)).get_steps();
+    assert(refractory_counts >= 0);  // since t_ref_ >= 0, this can only fail in error
+
+    // the parameters and propagators of iaf_freq_sensor_v2, once per variant
+    V_.lane_p_.resize(n);
+    V_.lane_v_.resize(n);
+    for ( size_t i = 0; i < n; ++i )
+    {
+      FreqSensorV2Kernel::Parameters& p = V_.lane_p_[i];
+      p.Tau_ = P_.Tau_[i];
+      p.C_ = P_.C_;
+      p.V_reset_ = P_.V_reset_;
+      p.Theta_ = P_.Theta_;
+      p.LowerBound_ = P_.LowerBound_;
+      p.Sigma_ = P_.Sigma_[i];
+      p.D_Int_ = P_.D_Int_[i];
+      p.math_accuracy_ = P_.math_accuracy_;
+
+      FreqSensorV2Kernel::calibrate(p, V_.lane_v_[i], h);
+      V_.lane_v_[i].RefractoryCounts_ = refractory_counts;
+    }
+
+    // senders must live on the thread of the sweep, see freq_sensor_bank
+    V_.senders_.assign(n, this);
+    for ( size_t i = 0; i < P_.senders_.size(); ++i )
+    {
+      Node* s = network()->get_node(P_.senders_[i], get_thread());
+      if ( s->is_proxy() || s->get_thread() != get_thread() )
+        throw BadProperty("All senders must be local to the thread of the sweep.");
+      V_.senders_[i] = s;
+    }
+
+    // clock ticks from the instance of the clock on this thread
+    V_.clock_ = 0;
+    if ( P_.clock_ > 0 )
+    {
+      V_.clock_ = dynamic_cast<sensor_clock*>(network()->get_node(P_.clock_, get_thread()));
+      if ( V_.clock_ == 0 )
+        throw BadProperty("clock must be the gid of a sensor_clock or 0.");
+    }
+
+    S_.resize(n);
+  }
+
+  /* ----------------------------------------------------------------
+   * Update and spike handling functions
+   */
+
+  void mynest::freq_sensor_v2_sweep::update(Time const & origin, const long_t from, const long_t to)
+  {
+    (this->*V_.update_tier_)(origin, from, to);
+  }
+
+  template <int A>
+  void mynest::freq_sensor_v2_sweep::update_(Time const & origin, const long_t from, const long_t to)
+  {
+    assert(to >= 0 && (delay) from < Scheduler::get_min_delay());
+    assert(from < to);
+
+    const double h = Time::get_resolution().get_ms();
+    const size_t n = P_.n_variants();
+
+    for ( long_t lag = from ; lag < to ; ++lag )
+    {
+      const double t = Time(Time::step(origin.get_steps()+lag+1)).get_ms();
+      const bool clock = V_.clock_ != 0 ? V_.clock_->tick(origin, lag)
+                                        : B_.spikes_.get_value(lag) > 0.1;
+
+      FreqSensorV2Kernel::State s;
+      s.Ie_ = S_.Ie_;
+      for ( size_t i = 0; i < n; ++i )
+      {
+        s.u_ = S_.u_[i];
+        s.v0_ = S_.v0_[i];
+        s.v1_ = S_.v1_[i];
+        s.s_ = S_.s_[i];
+        s.r_ = S_.r_[i];
+        s.t_clk_ = S_.t_clk_;
+
+        const bool spike = FreqSensorV2Kernel::step<A>(V_.lane_p_[i], s, V_.lane_v_[i], t, h, clock);
+
+        S_.u_[i] = s.u_;
+        S_.v0_[i] = s.v0_;
+        S_.v1_[i] = s.v1_;
+        S_.s_[i] = s.s_;
+        S_.r_[i] = s.r_;
+
+        if ( spike )
+        {
+          SpikeEvent se;
+          network()->send(*V_.senders_[i], se, lag);
+        }
+      }
+      if ( clock )
+        S_.t_clk_ = t;
+
+      // set new input current
+      S_.Ie_ = B_.currents_.get_value(lag);
+
+      // log state data
+      B_.logger_.record_data(origin.get_steps() + lag);
+    }
+  }
+
+  void mynest::freq_sensor_v2_sweep::handle(SpikeEvent& e)
+  {
+    assert(e.get_delay() > 0);
+    B_.spikes_.add_value(e.get_rel_delivery_steps(network()->get_slice_origin()),
+                         e.get_weight() * e.get_multiplicity());
+  }
+
+  void mynest::freq_sensor_v2_sweep::handle(CurrentEvent& e)
+  {
+    assert(e.get_delay() > 0);
+
+    const double_t I = e.get_current();
+    const double_t w = e.get_weight();
+
+    B_.currents_.add_value(e.get_rel_delivery_steps(network()->get_slice_origin()), w * I);
+  }
+
+  void mynest::freq_sensor_v2_sweep::handle(DataLoggingRequest& e)
+  {
+    B_.logger_.handle(e);
+  }
+
+  /* ----------------------------------------------------------------
+   * Checkpointing, see checkpoint.h
+   * ---------------------------------------------------------------- */
+
+  void mynest::freq_sensor_v2_sweep::save_checkpoint(CheckpointWriter& w, bool with_buffers)
+  {
+    w.put(S_.Ie_);
+    w.put(S_.t_clk_);
+    w.put(S_.u_);
+    w.put(S_.v0_);
+    w.put(S_.v1_);
+    w.put(S_.s_);
+    w.put(S_.r_);
+
+    if ( with_buffers )
+    {
+      w.put(B_.spikes_);
+      w.put(B_.currents_);
+    }
+  }
+
+  void mynest::freq_sensor_v2_sweep::load_checkpoint(CheckpointReader& r, bool with_buffers)
+  {
+    r.get(S_.Ie_);
+    r.get(S_.t_clk_);
+    r.get(S_.u_);
+    r.get(S_.v0_);
+    r.get(S_.v1_);
+    r.get(S_.s_);
+    r.get(S_.r_);
+
+    if ( with_buffers )
+    {
+      r.get(B_.spikes_);
+      r.get(B_.currents_);
+    }
+  }
+
+} // namespace
@@ -0,0 +1,353 @@
+/*
+ *  freq_sensor_v2_sweep.h
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef FREQ_SENSOR_V2_SWEEP_H
+#define FREQ_SENSOR_V2_SWEEP_H
+
+#include "nest.h"
+#include "event.h"
+#include "node.h"
+#include "ring_buffer.h"
+#include "connection.h"
+#include "universal_data_logger.h"
+#include "recordables_map.h"
+#include "checkpoint.h"
+#include "sensor_clock.h"
+#include "iaf_freq_sensor_v2_kernel.h"
+
+#include <vector>
+
+/* BeginDocumentation
+Name: freq_sensor_v2_sweep - K variants of iaf_freq_sensor_v2 in lockstep.
+
+Description:
+
+  freq_sensor_v2_sweep simulates K variants of iaf_freq_sensor_v2 that
+  receive identical input and differ in Sigma, tau_m and D_Int, as used
+  when sweeping these parameters. The input current and the clock are
+  received and buffered once for all variants, and the variants are
+  advanced together in one loop.
+
+  Each variant is stepped by the kernel of iaf_freq_sensor_v2
+  (iaf_freq_sensor_v2_kernel.h), so its dynamics are those of
+  iaf_freq_sensor_v2 with the same parameters. The cost per variant and
+  step is that of the neuron; the sweep saves the delivery of the input
+  events to K neurons and their per-node overhead.
+
+  Spikes of variant i are sent with the node given in senders[i] as
+  sender, so that spike detectors see one gid per variant. Any node can
+  serve as sender, a parrot_neuron without inputs is the natural choice.
+  If senders is empty, all variants send from the sweep node itself.
+
+Parameters:
+
+  The following parameters are shared by all variants.
+
+  E_L        double - Resting membrane potential in mV.
+  C_m        double - Capacity of the membrane in pF
+  t_ref      double - Duration of refractory period in ms.
+  V_th       double - Spike threshold in mV.
+  V_reset    double - Reset potential of the membrane in mV.
+  V_min      double - Absolute lower value for the membrane potential.
+  clock      int    - Gid of a sensor_clock whose ticks replace the clock
+                      spikes, 0 (default) to use clock spikes.
+  math_accuracy int - exp of the wavelet: 0 std::exp (default), 1 relative
+                      error below 1e-12, 2 below 1e-7, see module_math.h.
+
+  The following parameters are given per variant.
+
+  Sigma      array  - Wavelet scale factors.
+  tau_m      array  - Membrane time constants in ms.
+  D_Int      array  - Wavelet convolution delays in ms.
+  senders    array  - Gids of the nodes that send the spikes of each variant.
+  V_m        array  - Membrane potentials in mV.
+  n_variants int    - Number of variants (read only).
+
+Remarks:
+
+  Spikes can only be sent from nodes on the same thread as the sweep
+  node, see freq_sensor_bank.
+
+Sends: SpikeEvent
+
+Receives: SpikeEvent, CurrentEvent, DataLoggingRequest
+
+Author: Zhenzhong Wang
+SeeAlso: iaf_freq_sensor_v2, freq_sensor_bank, parrot_neuron
+*/
+using namespace nest;
+namespace mynest
+{
+  class Network;
+
+  /**
+   * K iaf_freq_sensor_v2 variants sharing one input stream.
+   */
+  class freq_sensor_v2_sweep : public Node, public Checkpointable
+  {
+
+  public:
+
+    freq_sensor_v2_sweep();
+    freq_sensor_v2_sweep(const freq_sensor_v2_sweep&);
+
+    /**
+     * Import sets of overloaded virtual functions.
+     * @see Technical Issues / Virtual Functions: Overriding, Overloading, and Hiding
+     */
+
+    using Node::connect_sender;
+    using Node::handle;
+
+    port check_connection(Connection&, port);
+
+    void handle(SpikeEvent &);
+    void handle(CurrentEvent &);
+    void handle(DataLoggingRequest &);
+
+    port connect_sender(SpikeEvent&, port);
+    port connect_sender(CurrentEvent&, port);
+    port connect_sender(DataLoggingRequest &, port);
+
+    void get_status(DictionaryDatum &) const;
+    void set_status(const DictionaryDatum &);
+
+    void save_checkpoint(CheckpointWriter&, bool);
+    void load_checkpoint(CheckpointReader&, bool);
+
+  private:
+
+    void init_state_(const Node& proto);
+    void init_buffers_();
+    void calibrate();
+
+    void update(Time const &, const long_t, const long_t);
+
+    /** update() for MathAccuracy A, see Variables_::update_tier_. */
+    template <int A>
+    void update_(Time const &, const long_t, const long_t);
+
+    // The next two classes need to be friends to access the State_ class/member
+    friend class RecordablesMap<freq_sensor_v2_sweep>;
+    friend class UniversalDataLogger<freq_sensor_v2_sweep>;
+
+    // ----------------------------------------------------------------
+
+    struct Parameters_ {
+
+      /** Membrane capacitance in pF. */
+      double_t C_;
+
+      /** Refractory period in ms. */
+      double_t TauR_;
+
+      /** Resting potential in mV. */
+      double_t U0_;
+
+      /** Reset value of the membrane potential */
+      double_t V_reset_;
+
+      /** Threshold, as in iaf_freq_sensor_v2 */
+      double_t Theta_;
+
+      /** Lower bound, as in iaf_freq_sensor_v2 */
+      double_t LowerBound_;
+
+      /** Gid of a sensor_clock, 0 for clock spikes **/
+      long_t clock_;
+
+      /** MathAccuracy of the wavelet **/
+      long_t math_accuracy_;
+
+      /** Wavelet scale factor of each variant **/
+      std::vector<double> Sigma_;
+
+      /** Membrane time constant of each variant in ms **/
+      std::vector<double> Tau_;
+
+      /** Wavelet convolution delay of each variant in ms **/
+      std::vector<double> D_Int_;
+
+      /** Gids of the sender nodes of each variant **/
+      std::vector<long> senders_;
+
+      Parameters_();  //!< Sets default parameter values
+
+      size_t n_variants() const { return Sigma_.size(); }
+
+      void get(DictionaryDatum&) const;  //!< Store current values in dictionary
+
+      /** Set values from dictionary.
+       * @returns Change in reversal potential E_L, to be passed to State_::set()
+       */
+      double set(const DictionaryDatum&);
+
+    };
+
+    // ----------------------------------------------------------------
+
+    /**
+     * Per-variant state, one array per variable. The update copies the
+     * state of a variant into a FreqSensorV2Kernel::State for its step.
+     */
+    struct State_ {
+      double_t Ie_;                 //!< Input current, shared
+      double_t t_clk_;              //!< Time of last clock spike, shared
+      std::vector<double_t> u_;     //!< Membrane voltage
+      std::vector<double_t> v0_;    //!< Real-time v
+      std::vector<double_t> v1_;    //!< Buffered v
+      std::vector<double_t> s_;     //!< S_enc synaptic current
+      std::vector<int_t>    r_;     //!< Number of refractory steps remaining
+
+      State_();  //!< Default initialization
+
+      /** Resize the variant arrays, new variants start at rest */
+      void resize(size_t);
+
+      void get(DictionaryDatum&, const Parameters_&) const;
+
+      /** Set values from dictionary.
+       * @param dictionary to take data from
+       * @param current parameters
+       * @param Change in reversal potential E_L specified by this dict
+       */
+      void set(const DictionaryDatum&, const Parameters_&, double);
+
+    };
+
+    // ----------------------------------------------------------------
+
+    struct Buffers_ {
+
+      Buffers_(freq_sensor_v2_sweep&);
+      Buffers_(const Buffers_&, freq_sensor_v2_sweep&);
+
+      /** buffers and summs up incoming spikes/currents, once for all variants */
+      RingBuffer spikes_;
+      RingBuffer currents_;
+
+      //! Logger for all analog data
+      UniversalDataLogger<freq_sensor_v2_sweep> logger_;
+
+    };
+
+    // ----------------------------------------------------------------
+
+    struct Variables_ {
+
+      /** Kernel parameters and propagators of each variant */
+      std::vector<FreqSensorV2Kernel::Parameters> lane_p_;
+      std::vector<FreqSensorV2Kernel::Variables> lane_v_;
+
+      std::vector<Node*> senders_;    //!< Resolved sender nodes
+
+      /** Clock instance of this thread, 0 for clock spikes */
+      sensor_clock* clock_;
+
+      /** update_ for the tier of math_accuracy, chosen by calibrate() so
+          that the steps do not choose it again. */
+      void (freq_sensor_v2_sweep::*update_tier_)(Time const&, const long_t, const long_t);
+
+    };
+
+    // Access functions for UniversalDataLogger -------------------------------
+
+    double_t get_Ie_() const { return S_.Ie_; }
+
+    // Data members -----------------------------------------------------------
+
+    /**
+     * @defgroup freq_sensor_v2_sweep_data
+     * Instances of private data structures for the different types
+     * of data pertaining to the model.
+     * @note The order of definitions is important for speed.
+     * @{
+     */
+    Parameters_ P_;
+    State_      S_;
+    Variables_  V_;
+    Buffers_    B_;
+    /** @} */
+
+    //! Mapping of recordables names to access functions
+    static RecordablesMap<freq_sensor_v2_sweep> recordablesMap_;
+  };
+
+  inline
+  port freq_sensor_v2_sweep::check_connection(Connection& c, port receptor_type)
+  {
+    SpikeEvent e;
+    e.set_sender(*this);
+    c.check_event(e);
+    return c.get_target()->connect_sender(e, receptor_type);
+  }
+
+  inline
+  port freq_sensor_v2_sweep::connect_sender(SpikeEvent&, port receptor_type)
+  {
+    if (receptor_type != 0)
+      throw UnknownReceptorType(receptor_type, get_name());
+    return 0;
+  }
+
+  inline
+  port freq_sensor_v2_sweep::connect_sender(CurrentEvent&, port receptor_type)
+  {
+    if (receptor_type != 0)
+      throw UnknownReceptorType(receptor_type, get_name());
+    return 0;
+  }
+
+  inline
+  port freq_sensor_v2_sweep::connect_sender(DataLoggingRequest& dlr, port receptor_type)
+  {
+    if (receptor_type != 0)
+      throw UnknownReceptorType(receptor_type, get_name());
+    return B_.logger_.connect_logging_device(dlr, recordablesMap_);
+  }
+
+  inline
+  void freq_sensor_v2_sweep::get_status(DictionaryDatum &d) const
+  {
+    P_.get(d);
+    S_.get(d, P_);
+
+    (*d)[names::recordables] = recordablesMap_.get_list();
+  }
+
+  inline
+  void freq_sensor_v2_sweep::set_status(const DictionaryDatum &d)
+  {
+    Parameters_ ptmp = P_;            // temporary copy in case of errors
+    const double delta_EL = ptmp.set(d);         // throws if BadProperty
+    State_      stmp = S_;            // temporary copy in case of errors
+    stmp.resize(ptmp.n_variants());
+    stmp.set(d, ptmp, delta_EL);                 // throws if BadProperty
+
+    // if we get here, temporaries contain consistent set of properties
+    P_ = ptmp;
+    S_ = stmp;
+  }
+
+} // namespace
+
+#endif /* #ifndef FREQ_SENSOR_V2_SWEEP_H */
@@ -22,6 +22,7 @@
 
 #include "exceptions.h"
 #include "glif_psc_alpha_multi.h"
+#include "glif_psc_alpha_multi_kernel.h"
 #include "network.h"
 #include "dict.h"
 #include "integerdatum.h"
@@ -38,6 +39,29 @@
 
 nest::RecordablesMap<mynest::glif_psc_alpha_multi> mynest::glif_psc_alpha_multi::recordablesMap_;
 
+#ifdef MYMODULE_PROFILE
+namespace
+{
+  const char* const profile_names[] =
+    { "steps", "refractory_steps", "ion_channel_iterations", "update_cycles" };
+}
+
+mynest::ProfileCounters mynest::glif_psc_alpha_multi::profile_(profile_names, 4);
+#endif
+
+namespace
+{
+  // Spike weights of one lag, receptor i reads B_.spikes_[i].
+  struct SpikeInput
+  {
+    std::vector<nest::RingBuffer>& b;
+    const nest::long_t lag;
+
+    SpikeInput(std::vector<nest::RingBuffer>& b, nest::long_t lag) : b(b), lag(lag) {}
+    double operator[](size_t i) const { return b[i].get_value(lag); }
+  };
+}
+
 namespace nest
 {
   // Override the create() method with one call to RecordablesMap::insert_() 
@@ -68,7 +92,9 @@ mynest::glif_psc_alpha_multi::Parameters_::Parameters_()
     i_L_                 (  0.0    ),
     num_of_ionchannels_  (   0     ),
     num_of_receptors_    (   0     ),
-    has_connections_     ( false   )
+    has_connections_     ( false   ),
+    math_accuracy_       ( MATH_EXACT ),
+    mean_conductance_    ( false   )
 
 {
   A_k_.clear();
@@ -83,7 +109,6 @@ mynest::glif_psc_alpha_multi::Parameters_::Parameters_()
 mynest::glif_psc_alpha_multi::State_::State_()
   : y0_   (0.0),  
     y3_   (0.0),
-    y4_   (0.0),
     r_    (0)
 {
   y1_syn_.clear();
@@ -109,14 +134,16 @@ void mynest::glif_psc_alpha_multi::Parameters_::get(DictionaryDatum &d) const
   def<double>(d, "i_L",           i_L_);
   def<int>   (d, "n_synapses",   num_of_receptors_);
   def<bool>  (d, names::has_connections, has_connections_);
-
-  ArrayDatum A_k_ad(A_k_);
-  ArrayDatum l_k_ad(l_k_);
-  ArrayDatum mu_k_ad(mu_k_);
-  ArrayDatum g_k_ad(g_k_);
-  ArrayDatum E_k_ad(E_k_);
-  ArrayDatum tau_syn_r_ad(tau_syn_r_);
-  ArrayDatum tau_syn_f_ad(tau_syn_f_);
+  def<long>  (d, "math_accuracy", math_accuracy_);
+  def<bool>  (d, "mean_conductance", mean_conductance_);
+
+  ArrayDatum A_k_ad(A_k_.to_vector());
+  ArrayDatum l_k_ad(l_k_.to_vector());
+  ArrayDatum mu_k_ad(mu_k_.to_vector());
+  ArrayDatum g_k_ad(g_k_.to_vector());
+  ArrayDatum E_k_ad(E_k_.to_vector());
+  ArrayDatum tau_syn_r_ad(tau_syn_r_.to_vector());
+  ArrayDatum tau_syn_f_ad(tau_syn_f_.to_vector());
   def<ArrayDatum>(d,"A_k", A_k_ad);
   def<ArrayDatum>(d,"l_k", l_k_ad);
   def<ArrayDatum>(d,"mu_k", mu_k_ad);
@@ -268,6 +295,11 @@ double mynest::glif_psc_alpha_multi::Parameters_::set(const DictionaryDatum& d)
   if ( TauR_ < 0. )
   	throw BadProperty("The refractory time t_ref can't be negative.");
 
+  updateValue<long>(d, "math_accuracy", math_accuracy_);
+  if ( !math::valid_accuracy(math_accuracy_) )
+    throw BadProperty("math_accuracy must be 0, 1 or 2.");
+  updateValue<bool>(d, "mean_conductance", mean_conductance_);
+
   if ( V_reset_ >= Theta_ )
     throw BadProperty("Reset potential must be smaller than threshold.");
 
@@ -297,7 +329,7 @@ mynest::glif_psc_alpha_multi::Buffers_::Buffers_(const Buffers_ &, glif_psc_alph
  * ---------------------------------------------------------------- */
 
 mynest::glif_psc_alpha_multi::glif_psc_alpha_multi()
-  : Archiving_Node(), 
+  : Archiving_Node_Ext(), 
     P_(), 
     S_(),
     B_(*this)
@@ -306,7 +338,7 @@ mynest::glif_psc_alpha_multi::glif_psc_alpha_multi()
 }
 
 mynest::glif_psc_alpha_multi::glif_psc_alpha_multi(const glif_psc_alpha_multi& n)
-  : Archiving_Node(n), 
+  : Archiving_Node_Ext(n), 
     P_(n.P_), 
     S_(n.S_),
     B_(n.B_, *this)
@@ -329,13 +361,20 @@ void mynest::glif_psc_alpha_multi::init_buffers_()
 
   B_.logger_.reset();
 
-  Archiving_Node::clear_history();
+  Archiving_Node_Ext::clear_history();
 }
 
 void mynest::glif_psc_alpha_multi::calibrate()
 {
   B_.logger_.init();  // ensures initialization in case mm connected after Simulate
 
+  switch ( P_.math_accuracy_ )
+  {
+  case MATH_1E12: V_.update_tier_ = &glif_psc_alpha_multi::update_<MATH_1E12>; break;
+  case MATH_1E7:  V_.update_tier_ = &glif_psc_alpha_multi::update_<MATH_1E7>; break;
+  default:        V_.update_tier_ = &glif_psc_alpha_multi::update_<MATH_EXACT>; break;
+  }
+
   const double h = Time::get_resolution().get_ms();
 
   P_.receptor_types_.resize(P_.num_of_receptors_);
@@ -358,38 +397,14 @@ void mynest::glif_psc_alpha_multi::calibrate()
   S_.y4_.resize(P_.num_of_ionchannels_);
   
   for (size_t i=0; i< P_.num_of_ionchannels_; ++i)
-  {
-      V_.Y40_[i]=std::exp(P_.mu_k_[i]/P_.l_k_[i]);
-      S_.y4_[i]=0.0;
-      V_.P40_[i]=P_.A_k_[i]/P_.l_k_[i];
-      V_.P44_[i]=std::exp(-h/P_.l_k_[i]);
-  }
-  V_.minus_h_Cm_ = -h / P_.C_;
-  //V_.PSCInitialValues_.resize(P_.num_of_receptors_);
+    S_.y4_[i]=0.0;
 
   B_.spikes_.resize(P_.num_of_receptors_);
-
-  //V_.P33_ = std::exp(-h/P_.Tau_);
-  //V_.P30_ = 1.0/P_.C_*(1.0-V_.P33_);
-
-
   for (size_t i=0; i < P_.num_of_receptors_; i++)
-  {
-    V_.P11_syn_[i] = std::exp(-h/P_.tau_syn_r_[i]);
-    V_.P22_syn_[i] = std::exp(-h/P_.tau_syn_f_[i]);
-    V_.P21_syn_[i] = 1.0-V_.P22_syn_[i];
-
-    //V_.P11_syn_[i] = V_.P22_syn_[i] =std::exp(-h/P_.tau_syn_[i]);
-    //V_.P21_syn_[i] = h*V_.P11_syn_[i];
-    //V_.P31_syn_[i] = 1/P_.C_ * ((V_.P11_syn_[i]-V_.P33_)/(-1/P_.tau_syn_[i]- -1/P_.Tau_)- h*V_.P11_syn_[i])
-      ///(-1/P_.Tau_ - -1/P_.tau_syn_[i]);
-    //V_.P32_syn_[i] = 1/P_.C_*(V_.P33_-V_.P11_syn_[i])/(-1/P_.Tau_ - -1/P_.tau_syn_[i]);
-
-    //V_.PSCInitialValues_[i] = 1.0 * numerics::e/P_.tau_syn_[i];
     B_.spikes_[i].resize();
-  }
 
-  
+  GlifPscAlphaMultiKernel::calibrate(P_, V_, h);
+
   Time r=Time::ms(P_.TauR_);
   V_.RefractoryCounts_=r.get_steps();
   
@@ -398,71 +413,26 @@ void mynest::glif_psc_alpha_multi::calibrate()
 }
 
 void mynest::glif_psc_alpha_multi::update(Time const& origin, const long_t from, const long_t to)
+{
+  (this->*V_.update_tier_)(origin, from, to);
+}
+
+template <int A>
+void mynest::glif_psc_alpha_multi::update_(Time const& origin, const long_t from, const long_t to)
 {
   assert(to >= 0 && (delay) from < Scheduler::get_min_delay());
   assert(from < to);
+  MYMODULE_PROFILE_START(prof_start);
 
   for ( long_t lag = from ; lag < to ; ++lag )
   {
-    if ( S_.r_ == 0 )
-    {
-      // neuron not refractory
-      //S_.y3_ = V_.P30_*(S_.y0_ + P_.I_e_) + V_.P33_*S_.y3_;
-      //S_.current_= 0.0;
-      S_.current_ = S_.y0_ + P_.I_e_;
-      for (size_t i=0; i < P_.num_of_receptors_; i++){
-        //S_.y3_ += V_.P31_syn_[i]*S_.y1_syn_[i] + V_.P32_syn_[i]*S_.y2_syn_[i];
-        //S_.y3_ += V_.P30_*S_.y2_syn_[i];
-        S_.current_ += S_.y2_syn_[i];
-      }
-
-    }
-    else
-    { // neuron is absolute refractory
-      --S_.r_;
-      S_.current_=0.0;
-    }
-
-    double gall=P_.g_L_;
-    double iall=P_.i_L_;
-    double tmp1,tmp2;
-    for (size_t i=0; i < P_.num_of_ionchannels_; i++)
-    {
-        tmp1=1+S_.y4_[i];
-        tmp2= V_.P40_[i]*S_.y4_[i]/(tmp1*tmp1)+P_.g_k_[i];
-        gall+=tmp2;
-        iall+=tmp2*P_.E_k_[i];
-        S_.y4_[i] = S_.y4_[i]*V_.P44_[i];
-    }
-    
-    double pt=std::exp(gall*V_.minus_h_Cm_);
-    S_.y3_ = pt * S_.y3_ + (iall+S_.current_)/gall * (1.0-pt);
-
-    // lower bound of membrane potential
-    S_.y3_ = ( S_.y3_<P_.LowerBound_ ? P_.LowerBound_ : S_.y3_); 
+#ifdef MYMODULE_PROFILE
+    if ( S_.r_ != 0 )
+      MYMODULE_PROFILE_COUNT(profile_, get_thread(), PROF_REFRACTORY, 1);
+#endif
 
-    for (size_t i=0; i < P_.num_of_receptors_; i++)
-    {      
-      // alpha shape PSCs
-      S_.y2_syn_[i] = V_.P21_syn_[i] * S_.y1_syn_[i] + V_.P22_syn_[i] * S_.y2_syn_[i];
-      S_.y1_syn_[i] *= V_.P11_syn_[i];
-
-      // collect spikes
-      //S_.y1_syn_[i] += V_.PSCInitialValues_[i] * B_.spikes_[i].get_value(lag);   
-      S_.y1_syn_[i] += B_.spikes_[i].get_value(lag);   
-    }
-
-    if (S_.y3_ >= P_.Theta_ && S_.r_==0)  // threshold crossing
+    if ( GlifPscAlphaMultiKernel::step<A>(P_, S_, V_, SpikeInput(B_.spikes_, lag)) )
     {
-      S_.r_ = V_.RefractoryCounts_;
-      //S_.y3_= P_.V_reset_; 
-      for(size_t i=0; i<P_.num_of_ionchannels_; ++i)
-          S_.y4_[i]=V_.Y40_[i];
-
-      // A supra-threshold membrane potential should never be observable.
-      // The reset at the time of threshold crossing enables accurate integration
-      // independent of the computation step size, see [2,3] for details.
-
       set_spiketime(Time::step(origin.get_steps()+lag+1));
       SpikeEvent se;
       network()->send(*this, se, lag);
@@ -473,7 +443,11 @@ void mynest::glif_psc_alpha_multi::update(Time const& origin, const long_t from,
 
     // log state data
     B_.logger_.record_data(origin.get_steps() + lag);
-  }  
+  }
+
+  MYMODULE_PROFILE_COUNT(profile_, get_thread(), PROF_ION_CHANNELS, (to - from) * P_.num_of_ionchannels_);
+  MYMODULE_PROFILE_COUNT(profile_, get_thread(), PROF_STEPS, to - from);
+  MYMODULE_PROFILE_STOP(profile_, get_thread(), PROF_UPDATE_CYCLES, prof_start);
 }
 
 port mynest::glif_psc_alpha_multi::connect_sender(SpikeEvent&, port receptor_type)
@@ -514,4 +488,42 @@ void mynest::glif_psc_alpha_multi::handle(DataLoggingRequest& e)
   B_.logger_.handle(e);
 }
 
+/* ----------------------------------------------------------------
+ * Checkpointing, see checkpoint.h
+ * ---------------------------------------------------------------- */
+
+void mynest::glif_psc_alpha_multi::save_checkpoint(CheckpointWriter& w, bool with_buffers)
+{
+  w.put(S_.y0_);
+  w.put(S_.y1_syn_);
+  w.put(S_.y2_syn_);
+  w.put(S_.y3_);
+  w.put(S_.y4_);
+  w.put(S_.current_);
+  w.put(S_.r_);
+
+  if ( with_buffers )
+  {
+    w.put(B_.spikes_);
+    w.put(B_.currents_);
+  }
+}
+
+void mynest::glif_psc_alpha_multi::load_checkpoint(CheckpointReader& r, bool with_buffers)
+{
+  r.get(S_.y0_);
+  r.get(S_.y1_syn_);
+  r.get(S_.y2_syn_);
+  r.get(S_.y3_);
+  r.get(S_.y4_);
+  r.get(S_.current_);
+  r.get(S_.r_);
+
+  if ( with_buffers )
+  {
+    r.get(B_.spikes_);
+    r.get(B_.currents_);
+  }
+}
+
 } // namespace
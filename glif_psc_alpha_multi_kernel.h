@@ -0,0 +1,273 @@
+/*
+ *  glif_psc_alpha_multi_kernel.h
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef GLIF_PSC_ALPHA_MULTI_KERNEL_H
+#define GLIF_PSC_ALPHA_MULTI_KERNEL_H
+
+#include "neuron_kernel.h"
+#include "module_math.h"
+
+#include <limits>
+#include <vector>
+
+namespace mynest
+{
+
+  /**
+   * Update of glif_psc_alpha_multi, see neuron_kernel.h.
+   *
+   * The ion channel arrays hold num_of_ionchannels_ entries and the
+   * synapse arrays num_of_receptors_ entries; calibrate() and step() only
+   * index them. i_L_ is the leak current that makes U0 the resting
+   * potential, glif_psc_alpha_multi computes it when E_L, g_L or g_k
+   * are set.
+   *
+   * Membrane update. With the channel conductances
+   *
+   *   g_k(t) = g_k + A_k/l_k y_k/(1+y_k)^2,   y_k(t) = y_k(0) exp(-t/l_k),
+   *
+   * the membrane follows C dV/dt = I(t) - g(t) V, g = g_L + sum g_k and
+   * I = i_L + I_in + sum g_k E_k, with the input I_in constant over a
+   * step. Both schemes below use the propagator of a constant
+   * conductance, V(h) = e^{-G} V(0) + (1 - e^{-G}) I/g with G = h g/C;
+   * they differ in the g and I they put in.
+   *
+   * mean_conductance_ false (default): g and I at the start of the step,
+   * the exponential Euler method. Its local error is O(h^2), to leading
+   * order h^2/(2C) |dg/dt| |V - I/g| plus G h/2 |d(I/g)/dt|, which is
+   * large right after a spike, when the y_k are reset and decay fast.
+   *
+   * mean_conductance_ true: g and I averaged over the step. The mean has
+   * a closed form, since dt = -l_k dy/y,
+   *
+   *   (1/h) int_0^h y/(1+y)^2 dt = l_k/h (1/(1+y(h)) - 1/(1+y(0))),
+   *
+   * and the mean channel conductance is g_k + A_k/h (...), so G is the
+   * exact integral of g/C and the homogeneous part is exact.
+   * What remains is that I/g is weighted by g instead of g e^{G(t)-G(h)},
+   * which gives a local error of at most G^2 h/12 max|d(I/g)/dt| to
+   * leading order, O(h^3), and a global error of O(h^2). The cost is one
+   * division per channel more than exponential Euler.
+   */
+  struct GlifPscAlphaMultiKernel
+  {
+    struct Parameters
+    {
+      double C_;           //!< Membrane capacitance in pF
+      double I_e_;         //!< External current in pA
+      double Theta_;
+      double LowerBound_;
+      size_t num_of_ionchannels_;
+      std::vector<double> A_k_;
+      std::vector<double> l_k_;
+      std::vector<double> mu_k_;
+      std::vector<double> g_k_;
+      std::vector<double> E_k_;
+      double g_L_;
+      double i_L_;
+      std::vector<double> tau_syn_r_;
+      std::vector<double> tau_syn_f_;
+      size_t num_of_receptors_;
+      long math_accuracy_;  //!< MathAccuracy of exp in step()
+      bool mean_conductance_;  //!< Average g over the step, see above
+
+      Parameters()
+        : C_(1.0), I_e_(0.0), Theta_(4.5),
+          LowerBound_(-std::numeric_limits<double>::infinity()),
+          num_of_ionchannels_(0), g_L_(0.3), i_L_(0.0), num_of_receptors_(0),
+          math_accuracy_(MATH_EXACT), mean_conductance_(false)
+      {}
+    };
+
+    struct State
+    {
+      double y0_;                   //!< Input current
+      std::vector<double> y1_syn_;
+      std::vector<double> y2_syn_;  //!< Synaptic currents
+      double y3_;                   //!< Membrane potential
+      std::vector<double> y4_;      //!< Ion channel activations
+      double current_;              //!< Total current of the last step
+      int    r_;                    //!< Number of refractory steps remaining
+
+      State()
+        : y0_(0.0), y3_(0.0), current_(0.0), r_(0)
+      {}
+    };
+
+    struct Variables
+    {
+      int    RefractoryCounts_;
+      std::vector<double> P11_syn_;
+      std::vector<double> P21_syn_;
+      std::vector<double> P22_syn_;
+      std::vector<double> P44_;
+      std::vector<double> P40_;
+      std::vector<double> Y40_;
+      double minus_h_Cm_;
+      double inv_h_;
+    };
+
+    /** Size the arrays of the structs above, channels start closed. */
+    static void resize(const Parameters& p, State& s, Variables& v)
+    {
+      s.y1_syn_.assign(p.num_of_receptors_, 0.0);
+      s.y2_syn_.assign(p.num_of_receptors_, 0.0);
+      s.y4_.assign(p.num_of_ionchannels_, 0.0);
+      v.P11_syn_.resize(p.num_of_receptors_);
+      v.P21_syn_.resize(p.num_of_receptors_);
+      v.P22_syn_.resize(p.num_of_receptors_);
+      v.P40_.resize(p.num_of_ionchannels_);
+      v.P44_.resize(p.num_of_ionchannels_);
+      v.Y40_.resize(p.num_of_ionchannels_);
+    }
+
+    template <class P, class V>
+    static void calibrate(const P& p, V& v, double h)
+    {
+      for ( size_t i = 0; i < p.num_of_ionchannels_; ++i )
+      {
+        v.Y40_[i] = std::exp(p.mu_k_[i]/p.l_k_[i]);
+        v.P40_[i] = p.A_k_[i]/p.l_k_[i];
+        v.P44_[i] = std::exp(-h/p.l_k_[i]);
+      }
+      v.minus_h_Cm_ = -h / p.C_;
+      v.inv_h_ = 1.0 / h;
+
+      for ( size_t i = 0; i < p.num_of_receptors_; i++ )
+      {
+        v.P11_syn_[i] = std::exp(-h/p.tau_syn_r_[i]);
+        v.P22_syn_[i] = std::exp(-h/p.tau_syn_f_[i]);
+        v.P21_syn_[i] = 1.0-v.P22_syn_[i];
+      }
+    }
+
+    /**
+     * One step.
+     * @param A MathAccuracy of p.math_accuracy_, chosen by the caller
+     *          once for many steps.
+     * @param in Spike weights of this step per receptor, in[i] for
+     *           receptor i+1. Any type with operator[] will do.
+     */
+    template <int A, class P, class S, class V, class In>
+    static bool step(const P& p, S& s, const V& v, const In& in)
+    {
+      if ( s.r_ == 0 )
+      {
+        // neuron not refractory
+        s.current_ = s.y0_ + p.I_e_;
+        for ( size_t i = 0; i < p.num_of_receptors_; i++ )
+          s.current_ += s.y2_syn_[i];
+      }
+      else
+      { // neuron is absolute refractory
+        --s.r_;
+        s.current_ = 0.0;
+      }
+
+      double gall = p.g_L_;
+      double iall = p.i_L_;
+      if ( p.mean_conductance_ )
+      {
+        for ( size_t i = 0; i < p.num_of_ionchannels_; i++ )
+        {
+          const double y_end = s.y4_[i]*v.P44_[i];
+          const double tmp2 = p.A_k_[i] * v.inv_h_ * (1.0/(1.0+y_end) - 1.0/(1.0+s.y4_[i]))
+                              + p.g_k_[i];
+          gall += tmp2;
+          iall += tmp2*p.E_k_[i];
+          s.y4_[i] = y_end;
+        }
+      }
+      else
+      {
+        for ( size_t i = 0; i < p.num_of_ionchannels_; i++ )
+        {
+          const double tmp1 = 1+s.y4_[i];
+          const double tmp2 = v.P40_[i]*s.y4_[i]/(tmp1*tmp1)+p.g_k_[i];
+          gall += tmp2;
+          iall += tmp2*p.E_k_[i];
+          s.y4_[i] = s.y4_[i]*v.P44_[i];
+        }
+      }
+
+      const double pt = math::exp<A>(gall*v.minus_h_Cm_);
+      s.y3_ = pt * s.y3_ + (iall+s.current_)/gall * (1.0-pt);
+
+      // lower bound of membrane potential
+      s.y3_ = ( s.y3_<p.LowerBound_ ? p.LowerBound_ : s.y3_);
+
+      for ( size_t i = 0; i < p.num_of_receptors_; i++ )
+      {
+        // alpha shape PSCs
+        s.y2_syn_[i] = v.P21_syn_[i] * s.y1_syn_[i] + v.P22_syn_[i] * s.y2_syn_[i];
+        s.y1_syn_[i] *= v.P11_syn_[i];
+
+        // collect spikes
+        s.y1_syn_[i] += in[i];
+      }
+
+      if ( s.y3_ >= p.Theta_ && s.r_ == 0 )  // threshold crossing
+      {
+        s.r_ = v.RefractoryCounts_;
+        for ( size_t i = 0; i < p.num_of_ionchannels_; ++i )
+          s.y4_[i] = v.Y40_[i];
+        return true;
+      }
+      return false;
+    }
+
+    /**
+     * n steps, appends the steps k with a spike.
+     * @param spikes_in Spike weights, num_of_receptors_ per step.
+     * @param current Input current read at the end of each step in pA.
+     */
+    static size_t run(const Parameters& p, State& s, const Variables& v, size_t n,
+                      const double* spikes_in, const double* current,
+                      std::vector<size_t>& spikes)
+    {
+      switch ( p.math_accuracy_ )
+      {
+      case MATH_1E12: return run_<MATH_1E12>(p, s, v, n, spikes_in, current, spikes);
+      case MATH_1E7:  return run_<MATH_1E7>(p, s, v, n, spikes_in, current, spikes);
+      default:        return run_<MATH_EXACT>(p, s, v, n, spikes_in, current, spikes);
+      }
+    }
+
+    template <int A>
+    static size_t run_(const Parameters& p, State& s, const Variables& v, size_t n,
+                       const double* spikes_in, const double* current,
+                       std::vector<size_t>& spikes)
+    {
+      const size_t n0 = spikes.size();
+      for ( size_t k = 0; k < n; ++k )
+      {
+        if ( step<A>(p, s, v, spikes_in + k * p.num_of_receptors_) )
+          spikes.push_back(k);
+        s.y0_ = current[k];
+      }
+      return spikes.size() - n0;
+    }
+  };
+
+} // namespace
+
+#endif /* #ifndef GLIF_PSC_ALPHA_MULTI_KERNEL_H */
@@ -30,9 +30,22 @@
 #include "numerics.h"
 #include "universal_data_logger_impl.h"
 
+#include <algorithm>
 #include <limits>
 
 nest::RecordablesMap<mynest::iaf_freq_sensor> mynest::iaf_freq_sensor::recordablesMap_;
+
+std::vector<mynest::iaf_freq_sensor::WaveletTables_> mynest::iaf_freq_sensor::wavelet_tables_;
+
+#ifdef MYMODULE_PROFILE
+namespace
+{
+  const char* const profile_names[] =
+    { "steps", "refractory_steps", "update_currents_calls", "update_cycles" };
+}
+
+mynest::ProfileCounters mynest::iaf_freq_sensor::profile_(profile_names, 4);
+#endif
 using namespace nest;
 
 namespace nest
@@ -71,7 +84,8 @@ namespace mynest
       LowerBound_(-std::numeric_limits<double_t>::infinity()),
       Sigma_     (  30.0   ),
       Ti_        (  50.0   ),   // ms
-      num_of_receptors_ ( 2 )
+      num_of_receptors_ ( 2 ),
+      clock_     (    0    )
   {}
 
   mynest::iaf_freq_sensor::State_::State_()
@@ -101,6 +115,7 @@ namespace mynest
     def<double>(d, "Sigma", Sigma_);
     def<double>(d, "Ti", Ti_);
     def<int>(d, "n_synapses", num_of_receptors_);
+    def<long>(d, "clock", clock_);
   }
 
   double mynest::iaf_freq_sensor::Parameters_::set(const DictionaryDatum& d)
@@ -118,6 +133,7 @@ namespace mynest
     updateValue<double>(d, names::C_m, C_);
     updateValue<double>(d, names::tau_m, Tau_);
     updateValue<double>(d, names::t_ref, TauR_);
+    updateValue<long>(d, "clock", clock_);
     updateValue<double>(d, "Sigma", Sigma_);
     updateValue<double>(d, "Ti", Ti_);
 
@@ -134,6 +150,9 @@ namespace mynest
     if ( TauR_ < 0.0 )
     	throw BadProperty("The refractory time t_ref can't be negative.");
 
+    if ( clock_ < 0 )
+        throw BadProperty("clock must be the gid of a sensor_clock or 0.");
+
     return delta_EL;
   }
 
@@ -161,20 +180,44 @@ namespace mynest
    * ---------------------------------------------------------------- */
 
   mynest::iaf_freq_sensor::iaf_freq_sensor()
-    : Archiving_Node(),
+    : Archiving_Node_Ext(),
       P_(),
       S_(),
       B_(*this)
   {
     recordablesMap_.create();
+    V_.wavelet_ = no_wavelet;
   }
 
   mynest::iaf_freq_sensor::iaf_freq_sensor(const iaf_freq_sensor& n)
-    : Archiving_Node(n),
+    : Archiving_Node_Ext(n),
       P_(n.P_),
       S_(n.S_),
       B_(n.B_, *this)
-  {}
+  {
+    // instances are created serially, calibrate() runs in parallel; the
+    // tables are kept when the number of threads drops
+    const size_t threads = network()->get_num_threads();
+    if ( wavelet_tables_.size() < threads )
+      wavelet_tables_.resize(threads);
+    V_.wavelet_ = no_wavelet;
+  }
+
+  mynest::iaf_freq_sensor::~iaf_freq_sensor()
+  {
+    release_wavelet_();
+  }
+
+  void mynest::iaf_freq_sensor::release_wavelet_()
+  {
+    if ( V_.wavelet_ == no_wavelet )
+      return;
+
+    WaveletTables_& w = wavelet_tables_[get_thread()];
+    if ( --w.users_[V_.wavelet_] == 0 )
+      w.tables_[V_.wavelet_].clear();
+    V_.wavelet_ = no_wavelet;
+  }
 
   /* ----------------------------------------------------------------
    * Node initialization functions
@@ -193,7 +236,7 @@ namespace mynest
 
     B_.logger_.reset();
 
-    Archiving_Node::clear_history();
+    Archiving_Node_Ext::clear_history();
   }
 
   void mynest::iaf_freq_sensor::calibrate()
@@ -211,11 +254,34 @@ namespace mynest
     }
 
     // these P are independent
-    V_.P21_ = 2.0 / (std::sqrt(3.0*P_.Sigma_) * std::pow(numerics::pi,0.25) * P_.Sigma_ );
-    V_.P22_ = - 1.0 / (P_.Sigma_ * P_.Sigma_);
+    FreqSensorKernel::calibrate(P_, V_, h);
 
-    V_.P33_ = std::exp(-h/P_.Tau_);
-    V_.P31_ = P_.Tau_ /P_.C_ * (1.0 - V_.P33_);
+    // share the wavelet table with the other neurons of this thread
+    WaveletTables_& w = wavelet_tables_[get_thread()];
+    if ( V_.wavelet_ == no_wavelet || !w.tables_[V_.wavelet_].matches(P_, V_, h) )
+    {
+      release_wavelet_();
+
+      size_t slot = w.tables_.size();
+      for ( size_t i = 0; i < w.tables_.size() && V_.wavelet_ == no_wavelet; ++i )
+        if ( w.users_[i] == 0 )
+          slot = std::min(slot, i);
+        else if ( w.tables_[i].matches(P_, V_, h) )
+          V_.wavelet_ = i;
+
+      if ( V_.wavelet_ == no_wavelet )
+      {
+        if ( slot == w.tables_.size() )
+        {
+          w.tables_.push_back(FreqSensorKernel::WaveletTable(P_, V_, h));
+          w.users_.push_back(0);
+        }
+        else
+          w.tables_[slot] = FreqSensorKernel::WaveletTable(P_, V_, h);
+        V_.wavelet_ = slot;
+      }
+      ++w.users_[V_.wavelet_];
+    }
 
     // TauR specifies the length of the absolute refractory period as
     // a double_t in ms. The grid based iaf_freq_sensor can only handle refractory
@@ -239,89 +305,47 @@ namespace mynest
 
     V_.RefractoryCounts_ = Time(Time::ms(P_.TauR_)).get_steps();
     assert(V_.RefractoryCounts_ >= 0);  // since t_ref_ >= 0, this can only fail in error
+
+    // clock ticks from the instance of the clock on this thread
+    V_.clock_ = 0;
+    if ( P_.clock_ > 0 )
+    {
+      V_.clock_ = dynamic_cast<sensor_clock*>(network()->get_node(P_.clock_, get_thread()));
+      if ( V_.clock_ == 0 )
+        throw BadProperty("clock must be the gid of a sensor_clock or 0.");
+    }
   }
 
   /* ----------------------------------------------------------------
    * Update and spike handling functions
    */
 
-  inline
-  void mynest::iaf_freq_sensor::update_currents_(const double_t t)
-  {
-      double tt_s = t - S_.ti_-P_.Ti_/2.0;
-      tt_s = V_.P22_ * tt_s * tt_s;
-      S_.currents_ = S_.y0_ * V_.P21_ * (1.0 + tt_s)*std::exp(tt_s/2.0);
-  }
-
   void mynest::iaf_freq_sensor::update(Time const & origin, const long_t from, const long_t to)
   {
     assert(to >= 0 && (delay) from < Scheduler::get_min_delay());
     assert(from < to);
+    MYMODULE_PROFILE_START(prof_start);
 
-    double dt,t;
     const double h = Time::get_resolution().get_ms();
-    double Vm0;
-
-    double dk;
-    double t_h,v_h;
+    FreqSensorKernel::WaveletTable& wavelet = wavelet_tables_[get_thread()].tables_[V_.wavelet_];
 
     for ( long_t lag = from ; lag < to ; ++lag )
     {
-      t = Time(Time::step(origin.get_steps()+lag+1)).get_ms();
-      if(B_.spikes_[0].get_value(lag) > 0.1)
-      {
-          // Integration spike arrive 
-          S_.y1_ = 0.0;
-          S_.y2_ = 0.0;
-          S_.currents_ = 0.0;
-          S_.ti_ = t;
-          //S_.y3_ = P_.V_reset_;
-          //S_.y1_ = 1.0;
-      }
-      if(B_.spikes_[1].get_value(lag) > 0.1)
-      {
-          // Encoding spike arrive 
-          //S_.y2_ = 0.0;
-          //S_.currents_ = 0.0;
-          //S_.ti_ = t;
-          S_.y3_ = P_.V_reset_;
-          S_.y1_ = 1.0;
-      }
-      Vm0 = S_.y3_;
+      const double t = Time(Time::step(origin.get_steps()+lag+1)).get_ms();
+      const bool clock = V_.clock_ != 0 ? V_.clock_->tick(origin, lag)
+                                        : B_.spikes_[0].get_value(lag) > 0.1;
 
+#ifdef MYMODULE_PROFILE
       if ( S_.r_ == 0 )
+        MYMODULE_PROFILE_COUNT(profile_, get_thread(), PROF_CURRENT_CALLS, 2);
+      else
+        MYMODULE_PROFILE_COUNT(profile_, get_thread(), PROF_REFRACTORY, 1);
+#endif
+
+      if ( FreqSensorKernel::step(P_, S_, V_, t, h,
+                                  clock,
+                                  B_.spikes_[1].get_value(lag) > 0.1, wavelet) )
       {
-        // neuron not refractory
-        S_.y3_ = V_.P33_ * S_.y3_ + V_.P31_ * S_.y1_ * std::abs(S_.y2_);
-        S_.y1_ = V_.P33_ * S_.y1_;
-
-        //Simpson's method for v integration
-        dk = S_.currents_;
-        update_currents_(t+h/2.0);
-        dk += 4.0 * S_.currents_;
-        update_currents_(t+h);
-        dk += S_.currents_;
-        S_.y2_ += dk * h / 6.0;
-
-        // lower bound of membrane potential
-        S_.y3_ = ( S_.y3_ < P_.LowerBound_ ? P_.LowerBound_ : S_.y3_);
-        S_.y2_ = ( S_.y2_ < P_.LowerBound_ ? P_.LowerBound_ : S_.y2_);
-        S_.y1_ = ( S_.y1_ < P_.LowerBound_ ? P_.LowerBound_ : S_.y1_);
-
-      }
-      else // neuron is absolute refractory
-        --S_.r_;
-
-      if ( Vm0 < P_.Theta_ && S_.y3_ >= P_.Theta_)
-      {
-        S_.r_  = V_.RefractoryCounts_;
-        S_.y3_ = P_.U0_;
-        S_.y2_ = 0.0;
-        S_.y1_ = 0.0;
-        // A supra-threshold membrane potential should never be observable.
-        // The reset at the time of threshold crossing enables accurate integration
-        // independent of the computation step size, see [2,3] for details.
-
         set_spiketime(Time::step(origin.get_steps()+lag+1));
         SpikeEvent se;
         network()->send(*this, se, lag);
@@ -333,6 +357,9 @@ namespace mynest
       // log state data
       B_.logger_.record_data(origin.get_steps() + lag);
     }
+
+    MYMODULE_PROFILE_COUNT(profile_, get_thread(), PROF_STEPS, to - from);
+    MYMODULE_PROFILE_STOP(profile_, get_thread(), PROF_UPDATE_CYCLES, prof_start);
   }
 
   port mynest::iaf_freq_sensor::connect_sender(SpikeEvent&, port receptor_type)
@@ -370,4 +397,42 @@ namespace mynest
     B_.logger_.handle(e);
   }
 
+  /* ----------------------------------------------------------------
+   * Checkpointing, see checkpoint.h
+   * ---------------------------------------------------------------- */
+
+  void mynest::iaf_freq_sensor::save_checkpoint(CheckpointWriter& w, bool with_buffers)
+  {
+    w.put(S_.y0_);
+    w.put(S_.y1_);
+    w.put(S_.y2_);
+    w.put(S_.y3_);
+    w.put(S_.currents_);
+    w.put(S_.ti_);
+    w.put(S_.r_);
+
+    if ( with_buffers )
+    {
+      w.put(B_.spikes_);
+      w.put(B_.currents_);
+    }
+  }
+
+  void mynest::iaf_freq_sensor::load_checkpoint(CheckpointReader& r, bool with_buffers)
+  {
+    r.get(S_.y0_);
+    r.get(S_.y1_);
+    r.get(S_.y2_);
+    r.get(S_.y3_);
+    r.get(S_.currents_);
+    r.get(S_.ti_);
+    r.get(S_.r_);
+
+    if ( with_buffers )
+    {
+      r.get(B_.spikes_);
+      r.get(B_.currents_);
+    }
+  }
+
 } // namespace
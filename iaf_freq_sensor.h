@@ -25,11 +25,15 @@
 
 #include "nest.h"
 #include "event.h"
-#include "archiving_node.h"
+#include "archiving_node_ext.h"
 #include "ring_buffer.h"
 #include "connection.h"
 #include "universal_data_logger.h"
 #include "recordables_map.h"
+#include "checkpoint.h"
+#include "profile_counters.h"
+#include "sensor_clock.h"
+#include "iaf_freq_sensor_kernel.h"
 
 /* BeginDocumentation
 Name: iaf_freq_sensor - Leaky integrate-and-fire neuron model.
@@ -66,6 +70,12 @@ Description:
 
 Remarks:
 
+  The wavelet depends only on the time since the clock spike, which is
+  on the time grid. Its values are computed once per thread for all
+  neurons with the same Sigma, Ti and resolution, and each neuron only
+  scales them by its input current. A table is freed with the last neuron
+  using it.
+
   The present implementation uses individual variables for the
   components of the state vector and the non-zero matrix elements of
   the propagator.  Because the propagator is a lower triangular matrix
@@ -97,6 +107,8 @@ Parameters:
   tau_syn_in_f double - Falling time of the inhibitory synaptic alpha function in ms.
   I_e        double - Constant external input current in pA.
   V_min      double - Absolute lower value for the membrane potential.
+  clock      int    - Gid of a sensor_clock whose ticks replace the clock
+                      spikes, 0 (default) to use clock spikes.
  
 Note:
   tau_m != tau_syn_{ex,in} is required by the current implementation to avoid a
@@ -129,13 +141,14 @@ namespace mynest
   /**
    * Leaky integrate-and-fire neuron with alpha-shaped PSCs.
    */
-  class iaf_freq_sensor : public Archiving_Node
+  class iaf_freq_sensor : public Archiving_Node_Ext, public Checkpointable
   {
     
   public:
     
     iaf_freq_sensor();
     iaf_freq_sensor(const iaf_freq_sensor&);
+    ~iaf_freq_sensor();
 
     /**
      * Import sets of overloaded virtual functions.
@@ -158,6 +171,9 @@ namespace mynest
     void get_status(DictionaryDatum &) const;
     void set_status(const DictionaryDatum &);
 
+    void save_checkpoint(CheckpointWriter&, bool);
+    void load_checkpoint(CheckpointReader&, bool);
+
   private:
 
     void init_state_(const Node& proto);
@@ -210,6 +226,9 @@ namespace mynest
       size_t num_of_receptors_;
       std::vector<long> receptor_types_;
       
+      /** Gid of a sensor_clock, 0 for clock spikes **/
+      long_t clock_;
+
       Parameters_();  //!< Sets default parameter values
 
       void get(DictionaryDatum&) const;  //!< Store current values in dictionary
@@ -272,16 +291,20 @@ namespace mynest
 	  weight one has an amplitude of 1 mV.
        */
       int_t    RefractoryCounts_;
+
+      /** Clock instance of this thread, 0 for clock spikes */
+      sensor_clock* clock_;
     
       double_t P21_;
       double_t P22_;
       double_t P31_;
       double_t P33_;
 
-    };
+      /** Index of the wavelet table in wavelet_tables_[thread],
+          no_wavelet before the first calibrate(). */
+      size_t   wavelet_;
 
-    //ODE
-    void update_currents_(const double_t);
+    };
 
     // Access functions for UniversalDataLogger -------------------------------
 
@@ -310,6 +333,30 @@ namespace mynest
     
     //! Mapping of recordables names to access functions
     static RecordablesMap<iaf_freq_sensor> recordablesMap_;
+
+    static const size_t no_wavelet = static_cast<size_t>(-1);
+
+    /**
+     * Wavelet tables of one thread, shared by the instances on the thread.
+     * Only calibrate() and the destructor change them; calibrate() runs
+     * on the thread of the instance, the destructor serially.
+     */
+    struct WaveletTables_ {
+      std::vector<FreqSensorKernel::WaveletTable> tables_;
+      std::vector<size_t> users_;  //!< Instances per table, 0 for a free slot
+    };
+
+    /** Stop using the wavelet table, the last user clears it. */
+    void release_wavelet_();
+
+    //! Wavelet tables per thread, grown at Create so threads never resize it
+    static std::vector<WaveletTables_> wavelet_tables_;
+
+#ifdef MYMODULE_PROFILE
+    //! Hot-path counters of all instances, see profile_counters.h
+    enum ProfileCounter_ { PROF_STEPS, PROF_REFRACTORY, PROF_CURRENT_CALLS, PROF_UPDATE_CYCLES };
+    static ProfileCounters profile_;
+#endif
   };
 
   inline
@@ -350,9 +397,13 @@ namespace mynest
   {
     P_.get(d);
     S_.get(d, P_);
-    Archiving_Node::get_status(d);
+    Archiving_Node_Ext::get_status(d);
   
     (*d)[names::recordables] = recordablesMap_.get_list();
+
+#ifdef MYMODULE_PROFILE
+    profile_.get(d);
+#endif
   }
   
   inline
@@ -367,7 +418,7 @@ namespace mynest
     // write them back to (P_, S_) before we are also sure that 
     // the properties to be set in the parent class are internally 
     // consistent.
-    Archiving_Node::set_status(d);
+    Archiving_Node_Ext::set_status(d);
   
     // if we get here, temporaries contain consistent set of properties
     P_ = ptmp;
@@ -0,0 +1,279 @@
+/*
+ *  iaf_freq_sensor_kernel.h
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef IAF_FREQ_SENSOR_KERNEL_H
+#define IAF_FREQ_SENSOR_KERNEL_H
+
+#include "neuron_kernel.h"
+
+#include <limits>
+#include <vector>
+
+namespace mynest
+{
+
+  /**
+   * Update of iaf_freq_sensor, see neuron_kernel.h. Two inputs: clock
+   * spikes restart the wavelet integration, encoding spikes reset the
+   * membrane potential.
+   */
+  struct FreqSensorKernel
+  {
+    struct Parameters
+    {
+      double Tau_;         //!< Membrane time constant in ms
+      double C_;           //!< Membrane capacitance in pF
+      double U0_;          //!< Resting potential in mV
+      double V_reset_;
+      double Theta_;
+      double LowerBound_;
+      double Sigma_;       //!< Wavelet scale factor
+      double Ti_;          //!< Wavelet convolution length in ms
+
+      Parameters()
+        : Tau_(30.0), C_(1.0), U0_(0.0), V_reset_(-10.0), Theta_(-1.0),
+          LowerBound_(-std::numeric_limits<double>::infinity()),
+          Sigma_(30.0), Ti_(50.0)
+      {}
+    };
+
+    struct State
+    {
+      double y0_;        //!< Input current
+      double y1_;        //!< s(t)
+      double y2_;        //!< v(t)
+      double y3_;        //!< Membrane potential
+      double currents_;  //!< Wavelet current at the end of the last step
+      double ti_;        //!< Time of the last clock spike
+      int    r_;         //!< Number of refractory steps remaining
+
+      State()
+        : y0_(0.0), y1_(0.0), y2_(0.0), y3_(0.0), currents_(0.0),
+          ti_(-std::numeric_limits<double>::infinity()), r_(0)
+      {}
+    };
+
+    struct Variables
+    {
+      int    RefractoryCounts_;
+      double P21_;
+      double P22_;
+      double P31_;
+      double P33_;
+    };
+
+    template <class P, class V>
+    static void calibrate(const P& p, V& v, double h)
+    {
+      v.P21_ = 2.0 / (std::sqrt(3.0*p.Sigma_) * std::pow(kernel_pi,0.25) * p.Sigma_ );
+      v.P22_ = - 1.0 / (p.Sigma_ * p.Sigma_);
+
+      v.P33_ = std::exp(-h/p.Tau_);
+      v.P31_ = p.Tau_ /p.C_ * (1.0 - v.P33_);
+    }
+
+    /** Wavelet for unit input current, dt ms after the clock spike. */
+    template <class P, class V>
+    static double wavelet(const P& p, const V& v, double dt)
+    {
+      double tt_s = dt - p.Ti_/2.0;
+      tt_s = v.P22_ * tt_s * tt_s;
+      return v.P21_ * (1.0 + tt_s)*std::exp(tt_s/2.0);
+    }
+
+    /** Wavelet current at time t, stored in s.currents_. */
+    template <class P, class S, class V>
+    static void update_currents(const P& p, S& s, const V& v, double t)
+    {
+      s.currents_ = s.y0_ * wavelet(p, v, t - s.ti_);
+    }
+
+    /**
+     * wavelet() on the grid dt = j h/2, for neurons that share Sigma, Ti
+     * and h and receive their clock spikes on the time grid. The table
+     * grows on demand up to the time where the wavelet underflows to 0.
+     */
+    class WaveletTable
+    {
+    public:
+
+      template <class P, class V>
+      WaveletTable(const P& p, const V& v, double h)
+        : P21_(v.P21_), P22_(v.P22_), Ti_(p.Ti_), h_(h),
+          end_(2 * static_cast<size_t>((Ti_/2.0 + std::sqrt(-1500.0/P22_)) / h_) + 2)
+      {}
+
+      template <class P, class V>
+      bool matches(const P& p, const V& v, double h) const
+      {
+        return P21_ == v.P21_ && P22_ == v.P22_ && Ti_ == p.Ti_ && h_ == h;
+      }
+
+      /** Wavelet at dt rounded to the grid, 0 after the table ends. */
+      double operator()(double dt)
+      {
+        if ( !(dt < (end_ - 1) * h_ / 2.0) )
+          return 0.0;  // also before the first clock spike, where dt is inf
+        const size_t j = static_cast<size_t>(dt * 2.0 / h_ + 0.5);
+        if ( j >= g_.size() )
+          grow_(j);
+        return g_[j];
+      }
+
+      /** Drop the tabulated values, they are computed again on demand. */
+      void clear()
+      {
+        std::vector<double>().swap(g_);
+      }
+
+    private:
+
+      void grow_(size_t j)
+      {
+        size_t n = 2 * g_.size();
+        if ( n <= j )
+          n = j + 1;
+        if ( n > end_ )
+          n = end_;
+        for ( size_t i = g_.size(); i < n; ++i )
+        {
+          double tt_s = i * h_ / 2.0 - Ti_/2.0;
+          tt_s = P22_ * tt_s * tt_s;
+          g_.push_back(P21_ * (1.0 + tt_s)*std::exp(tt_s/2.0));
+        }
+      }
+
+      double P21_;
+      double P22_;
+      double Ti_;
+      double h_;
+      size_t end_;
+      std::vector<double> g_;
+    };
+
+    /**
+     * Step ending at time t in ms.
+     * @param clock True if a clock spike arrives in this step.
+     * @param encoding True if an encoding spike arrives in this step.
+     */
+    template <class P, class S, class V>
+    static bool step(const P& p, S& s, const V& v, double t, double h,
+                     bool clock, bool encoding)
+    {
+      Direct_<P, V> w(p, v);
+      return step(p, s, v, t, h, clock, encoding, w);
+    }
+
+    /**
+     * As above, with the wavelet for unit current taken from w(dt),
+     * e.g. a WaveletTable.
+     */
+    template <class P, class S, class V, class W>
+    static bool step(const P& p, S& s, const V& v, double t, double h,
+                     bool clock, bool encoding, W& w)
+    {
+      if ( clock )
+      {
+        // Integration spike arrive
+        s.y1_ = 0.0;
+        s.y2_ = 0.0;
+        s.currents_ = 0.0;
+        s.ti_ = t;
+      }
+      if ( encoding )
+      {
+        // Encoding spike arrive
+        s.y3_ = p.V_reset_;
+        s.y1_ = 1.0;
+      }
+      const double Vm0 = s.y3_;
+
+      if ( s.r_ == 0 )
+      {
+        // neuron not refractory
+        s.y3_ = v.P33_ * s.y3_ + v.P31_ * s.y1_ * std::abs(s.y2_);
+        s.y1_ = v.P33_ * s.y1_;
+
+        //Simpson's method for v integration
+        double dk = s.currents_;
+        s.currents_ = s.y0_ * w(t+h/2.0 - s.ti_);
+        dk += 4.0 * s.currents_;
+        s.currents_ = s.y0_ * w(t+h - s.ti_);
+        dk += s.currents_;
+        s.y2_ += dk * h / 6.0;
+
+        // lower bound of membrane potential
+        s.y3_ = ( s.y3_ < p.LowerBound_ ? p.LowerBound_ : s.y3_);
+        s.y2_ = ( s.y2_ < p.LowerBound_ ? p.LowerBound_ : s.y2_);
+        s.y1_ = ( s.y1_ < p.LowerBound_ ? p.LowerBound_ : s.y1_);
+      }
+      else // neuron is absolute refractory
+        --s.r_;
+
+      if ( Vm0 < p.Theta_ && s.y3_ >= p.Theta_)
+      {
+        s.r_  = v.RefractoryCounts_;
+        s.y3_ = p.U0_;
+        s.y2_ = 0.0;
+        s.y1_ = 0.0;
+        return true;
+      }
+      return false;
+    }
+
+    /**
+     * n steps from step first on, appends the steps k with a spike.
+     * @param clock Weight of clock spikes in each step, > 0.1 counts.
+     * @param encoding Weight of encoding spikes in each step, > 0.1 counts.
+     * @param current Input current read at the end of each step in pA.
+     */
+    static size_t run(const Parameters& p, State& s, const Variables& v, double h,
+                      long first, size_t n, const double* clock, const double* encoding,
+                      const double* current, std::vector<size_t>& spikes)
+    {
+      const size_t n0 = spikes.size();
+      for ( size_t k = 0; k < n; ++k )
+      {
+        if ( step(p, s, v, (first + static_cast<long>(k) + 1) * h, h,
+                  clock[k] > 0.1, encoding[k] > 0.1) )
+          spikes.push_back(k);
+        s.y0_ = current[k];
+      }
+      return spikes.size() - n0;
+    }
+
+  private:
+
+    template <class P, class V>
+    struct Direct_
+    {
+      const P& p;
+      const V& v;
+
+      Direct_(const P& p, const V& v) : p(p), v(v) {}
+      double operator()(double dt) const { return wavelet(p, v, dt); }
+    };
+  };
+
+} // namespace
+
+#endif /* #ifndef IAF_FREQ_SENSOR_KERNEL_H */
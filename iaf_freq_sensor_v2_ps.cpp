@@ -0,0 +1,521 @@
+/*
+ *  iaf_freq_sensor_v2_ps.cpp
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "exceptions.h"
+#include "iaf_freq_sensor_v2_ps.h"
+#include "network.h"
+#include "dict.h"
+#include "integerdatum.h"
+#include "doubledatum.h"
+#include "dictutils.h"
+#include "numerics.h"
+#include "universal_data_logger_impl.h"
+
+#include <limits>
+
+nest::RecordablesMap<mynest::iaf_freq_sensor_v2_ps> mynest::iaf_freq_sensor_v2_ps::recordablesMap_;
+using namespace nest;
+
+namespace nest
+{
+
+  /*
+   * Override the create() method with one call to RecordablesMap::insert_()
+   * for each quantity to be recorded.
+   */
+  template <>
+  void RecordablesMap<mynest::iaf_freq_sensor_v2_ps>::create()
+  {
+    // use standard names whereever you can for consistency!
+    insert_(names::V_m, &mynest::iaf_freq_sensor_v2_ps::get_V_m_);
+    insert_("V0"      , &mynest::iaf_freq_sensor_v2_ps::get_V0_);
+    insert_("V1"      , &mynest::iaf_freq_sensor_v2_ps::get_V1_);
+    insert_("Syn"     , &mynest::iaf_freq_sensor_v2_ps::get_Syn_);
+    insert_("Ie"      , &mynest::iaf_freq_sensor_v2_ps::get_Ie_);
+  }
+}
+
+namespace mynest
+{
+  /* ----------------------------------------------------------------
+   * Default constructors defining default parameters and state
+   * ---------------------------------------------------------------- */
+
+  mynest::iaf_freq_sensor_v2_ps::Parameters_::Parameters_()
+    : Tau_       (  30.0   ),  // ms
+      C_         (   1.0   ),  // pF
+      TauR_      (   2.0   ),  // ms
+      U0_        (   0.0   ),  // mV
+      I_e_       (   0.0   ),  // pA
+      V_reset_   ( -10.0   ),  // mV, rel to U0_
+      Theta_     (  -1.0   ),  // mV, rel to U0_
+      LowerBound_(-std::numeric_limits<double_t>::infinity()),
+      Sigma_     (  30.0   ),
+      D_Int_     (  0.0   ),  // ms
+      checkpoint_spikes_(false)
+  {}
+
+  mynest::iaf_freq_sensor_v2_ps::State_::State_()
+    : u_    (0.0),
+      v0_   (0.0),
+      v1_   (0.0),
+      s_    (0.0),
+      Ie_   (0.0),
+      t_clk_   (-std::numeric_limits<double_t>::infinity()),
+      is_refractory_ (false),
+      last_spike_step_ (-1),
+      last_spike_offset_ (0.0)
+  {}
+
+  /* ----------------------------------------------------------------
+   * Parameter and state extractions and manipulation functions
+   * ---------------------------------------------------------------- */
+
+  void mynest::iaf_freq_sensor_v2_ps::Parameters_::get(DictionaryDatum &d) const
+  {
+    def<double>(d, names::E_L, U0_);   // Resting potential
+    def<double>(d, names::I_e, I_e_);
+    def<double>(d, names::V_th, Theta_+U0_); // threshold value
+    def<double>(d, names::V_reset, V_reset_+U0_);
+    def<double>(d, names::V_min, LowerBound_+U0_);
+    def<double>(d, names::C_m, C_);
+    def<double>(d, names::tau_m, Tau_);
+    def<double>(d, names::t_ref, TauR_);
+    def<double>(d, "Sigma", Sigma_);
+    def<double>(d, "D_Int", D_Int_);
+    def<bool>(d, "checkpoint_spikes", checkpoint_spikes_);
+  }
+
+  double mynest::iaf_freq_sensor_v2_ps::Parameters_::set(const DictionaryDatum& d)
+  {
+    // if U0_ is changed, we need to adjust all variables defined relative to U0_
+    const double ELold = U0_;
+    updateValue<double>(d, names::E_L, U0_);
+    const double delta_EL = U0_ - ELold;
+
+    updateValue<double>(d, names::V_reset, V_reset_);
+    updateValue<double>(d, names::V_th, Theta_);
+    updateValue<double>(d, names::V_min, LowerBound_);
+
+    updateValue<double>(d, names::I_e, I_e_);
+    updateValue<double>(d, names::C_m, C_);
+    updateValue<double>(d, names::tau_m, Tau_);
+    updateValue<double>(d, names::t_ref, TauR_);
+    updateValue<double>(d, "Sigma", Sigma_);
+    updateValue<double>(d, "D_Int", D_Int_);
+    updateValue<bool>(d, "checkpoint_spikes", checkpoint_spikes_);
+
+    if ( C_ <= 0.0 )
+      throw BadProperty("Capacitance must be > 0.");
+
+    if ( Tau_ <= 0.0 )
+      throw BadProperty("Membrane time constant must be > 0.");
+
+    if ( Sigma_ <= 0.0 )
+      throw BadProperty("Sigma must be > 0.");
+
+    if ( D_Int_ < 0.0 )
+        throw BadProperty("Integration time must be >= 0.");
+
+    if ( TauR_ < 0.0 )
+    	throw BadProperty("The refractory time t_ref can't be negative.");
+
+    return delta_EL;
+  }
+
+  void mynest::iaf_freq_sensor_v2_ps::State_::get(DictionaryDatum &d, const Parameters_& p) const
+  {
+    def<double>(d, names::V_m, u_); // Membrane potential
+  }
+
+  void mynest::iaf_freq_sensor_v2_ps::State_::set(const DictionaryDatum& d, const Parameters_& p, double delta_EL)
+  {
+    updateValue<double>(d, names::V_m, u_);
+  }
+
+  mynest::iaf_freq_sensor_v2_ps::Buffers_::Buffers_(iaf_freq_sensor_v2_ps& n)
+    : logger_(n)
+  {}
+
+  mynest::iaf_freq_sensor_v2_ps::Buffers_::Buffers_(const Buffers_ &, iaf_freq_sensor_v2_ps& n)
+    : logger_(n)
+  {}
+
+
+  /* ----------------------------------------------------------------
+   * Default and copy constructor for node
+   * ---------------------------------------------------------------- */
+
+  mynest::iaf_freq_sensor_v2_ps::iaf_freq_sensor_v2_ps()
+    : Archiving_Node_Ext(),
+      P_(),
+      S_(),
+      B_(*this)
+  {
+    recordablesMap_.create();
+  }
+
+  mynest::iaf_freq_sensor_v2_ps::iaf_freq_sensor_v2_ps(const iaf_freq_sensor_v2_ps& n)
+    : Archiving_Node_Ext(n),
+      P_(n.P_),
+      S_(n.S_),
+      B_(n.B_, *this)
+  {}
+
+  /* ----------------------------------------------------------------
+   * Node initialization functions
+   * ---------------------------------------------------------------- */
+
+  void mynest::iaf_freq_sensor_v2_ps::init_state_(const Node& proto)
+  {
+    const iaf_freq_sensor_v2_ps& pr = downcast<iaf_freq_sensor_v2_ps>(proto);
+    S_ = pr.S_;
+  }
+
+  void mynest::iaf_freq_sensor_v2_ps::init_buffers_()
+  {
+    B_.events_.resize();
+    B_.events_.clear();
+    B_.pending_.clear();
+    B_.currents_.clear();        // includes resize
+
+    B_.logger_.reset();
+
+    Archiving_Node_Ext::clear_history();
+  }
+
+  void mynest::iaf_freq_sensor_v2_ps::calibrate()
+  {
+    B_.logger_.init();  // ensures initialization in case mm connected after Simulate
+
+    V_.h_ms_ = Time::get_resolution().get_ms();
+
+    V_.P2_ = 2.0 / (std::sqrt(3.0 * P_.Sigma_) * std::pow(numerics::pi, 0.25) * P_.Sigma_);
+    V_.inv_Tau_ = 1.0 / P_.Tau_;
+    V_.inv_2Sigma2_ = 0.5 / (P_.Sigma_ * P_.Sigma_);
+
+    // The refractory period is rounded to the grid as in iaf_freq_sensor_v2,
+    // but it starts at the precise spike time, see emit_spike_().
+    V_.RefractoryCounts_ = Time(Time::ms(P_.TauR_)).get_steps();
+    assert(V_.RefractoryCounts_ >= 0);  // since t_ref_ >= 0, this can only fail in error
+  }
+
+  /* ----------------------------------------------------------------
+   * Update and spike handling functions
+   */
+
+  inline
+  double_t mynest::iaf_freq_sensor_v2_ps::u_at_(const double_t dt) const
+  {
+    return std::exp(-dt * V_.inv_Tau_) * (S_.u_ + S_.s_ * S_.v1_ * dt / P_.C_);
+  }
+
+  inline
+  double_t mynest::iaf_freq_sensor_v2_ps::F_(const double_t x) const
+  {
+    return x * std::exp(-x * x * V_.inv_2Sigma2_);
+  }
+
+  void mynest::iaf_freq_sensor_v2_ps::propagate_(const long_t T, const long_t lag,
+                                                 const double_t from_offset,
+                                                 const double_t to_offset)
+  {
+    const double_t dt = from_offset - to_offset;
+    if ( S_.is_refractory_ || dt <= 0.0 )
+      return;
+
+    // u(t) has at most one extremum, at t_ext = Tau - u(0)/k. A crossing
+    // that lies before the extremum is found even if u has fallen below
+    // threshold again at the end of the interval.
+    double_t t_cross = dt;
+    bool crossed = false;
+    if ( S_.u_ < P_.Theta_ )
+    {
+      const double_t k = S_.s_ * S_.v1_ / P_.C_;
+      if ( k != 0.0 )
+      {
+        const double_t t_ext = P_.Tau_ - S_.u_ / k;
+        if ( t_ext > 0.0 && t_ext < dt && u_at_(t_ext) >= P_.Theta_ )
+        {
+          t_cross = t_ext;
+          crossed = true;
+        }
+      }
+      if ( !crossed )
+        crossed = u_at_(dt) >= P_.Theta_;
+    }
+
+    // the wavelet convolution is exact, since F_ is its primitive
+    const double_t t_from = Time(Time::step(T+1)).get_ms() - from_offset;
+    const bool has_clock = S_.t_clk_ > -std::numeric_limits<double_t>::infinity();
+    const double_t a = t_from - S_.t_clk_ - P_.D_Int_;
+
+    if ( crossed )
+    {
+      // locate the threshold crossing by bisection on the analytical trajectory
+      const double_t tol = 1e-12 * V_.h_ms_;
+      double_t lo = 0.0;
+      double_t hi = t_cross;
+      while ( hi - lo > tol )
+      {
+        const double_t mid = 0.5 * (lo + hi);
+        if ( u_at_(mid) >= P_.Theta_ )
+          hi = mid;
+        else
+          lo = mid;
+      }
+
+      if ( has_clock )
+        S_.v0_ += V_.P2_ * S_.Ie_ * (F_(a + hi) - F_(a));
+
+      emit_spike_(T, lag, from_offset - hi);
+
+      // without refractory period, the neuron continues right away
+      propagate_(T, lag, from_offset - hi, to_offset);
+      return;
+    }
+
+    if ( has_clock )
+      S_.v0_ += V_.P2_ * S_.Ie_ * (F_(a + dt) - F_(a));
+
+    S_.u_ = u_at_(dt);
+    S_.s_ *= std::exp(-dt * V_.inv_Tau_);
+
+    // lower bound of membrane potential
+    S_.u_ = ( S_.u_ < P_.LowerBound_ ? P_.LowerBound_ : S_.u_);
+  }
+
+  void mynest::iaf_freq_sensor_v2_ps::emit_spike_(const long_t T, const long_t lag,
+                                                  const double_t offset)
+  {
+    S_.last_spike_step_ = T + 1;
+    S_.last_spike_offset_ = offset;
+
+    S_.u_  = P_.V_reset_;
+    S_.s_  = 0.0;
+    S_.v1_ = 0.0;
+
+    // the refractory period ends at the same offset RefractoryCounts_
+    // steps later, see update()
+    if ( V_.RefractoryCounts_ > 0 )
+      S_.is_refractory_ = true;
+
+    set_spiketime(Time::step(S_.last_spike_step_));
+    SpikeEvent se;
+    se.set_offset(offset);
+    network()->send(*this, se, lag);
+  }
+
+  void mynest::iaf_freq_sensor_v2_ps::update(Time const & origin, const long_t from, const long_t to)
+  {
+    assert(to >= 0 && (delay) from < Scheduler::get_min_delay());
+    assert(from < to);
+
+    // at start of slice, tell input queue to prepare for delivery
+    if ( from == 0 )
+    {
+      B_.events_.prepare_delivery();
+
+      if ( !P_.checkpoint_spikes_ )
+        B_.pending_.clear();
+
+      size_t j = 0;
+      for ( size_t i = 0; i < B_.pending_.size(); ++i )
+        if ( B_.pending_[i].stamp_ >= origin.get_steps() )
+          B_.pending_[j++] = B_.pending_[i];
+      B_.pending_.resize(j);
+    }
+
+    double_t ev_offset;
+    double_t ev_weight;
+    bool     end_of_refract;  // no pseudo events are queued
+
+    for ( long_t lag = from ; lag < to ; ++lag )
+    {
+      // the step covers (T, T+1], offsets are measured from its end
+      const long_t T = origin.get_steps() + lag;
+      double_t last_offset = V_.h_ms_;
+
+      // The refractory period ends in this step at the offset of the spike
+      // that started it. It is computed from the spike instead of being
+      // queued in events_, so that it survives a checkpoint. A period
+      // that should have ended already, after t_ref was shortened, ends
+      // at the start of the step.
+      bool refract_ends = S_.is_refractory_ && T >= refractory_end_();
+      const double_t refract_offset =
+        T == refractory_end_() ? S_.last_spike_offset_ : V_.h_ms_;
+
+      while ( B_.events_.get_next_spike(T, ev_offset, ev_weight, end_of_refract) )
+      {
+        if ( refract_ends && ev_offset <= refract_offset )
+        {
+          last_offset = refract_offset;
+          S_.is_refractory_ = false;
+          refract_ends = false;
+        }
+
+        propagate_(T, lag, last_offset, ev_offset);
+        last_offset = ev_offset;
+
+        if ( ev_weight > 0.1 )
+        {
+          // Clock input at its precise time, reset v0_, v1_, s_
+          S_.v1_ = std::abs(S_.v0_);
+          S_.v0_ = 0.0;
+          S_.u_ = P_.V_reset_;
+          S_.s_ = 1.0;
+          S_.t_clk_ = Time(Time::step(T+1)).get_ms() - ev_offset;
+        }
+      }
+
+      if ( refract_ends )
+      {
+        last_offset = refract_offset;
+        S_.is_refractory_ = false;
+      }
+
+      propagate_(T, lag, last_offset, 0.0);
+
+      // set new input current
+      S_.Ie_ = B_.currents_.get_value(lag);
+
+      // log state data
+      B_.logger_.record_data(origin.get_steps() + lag);
+    }
+  }
+
+  void mynest::iaf_freq_sensor_v2_ps::handle(SpikeEvent& e)
+  {
+    assert(e.get_delay() > 0);
+
+    /* We need to compute the absolute time stamp of the delivery time
+       of the spike, since spikes might spend longer than min_delay_
+       in the queue.  The time is computed according to Time Memo, Rule 3.
+    */
+    const long_t Tdeliver = e.get_stamp().get_steps() + e.get_delay() - 1;
+    const PendingSpike_ s = { Tdeliver, e.get_offset(),
+                              e.get_weight() * e.get_multiplicity() };
+    B_.events_.add_spike(e.get_rel_delivery_steps(network()->get_slice_origin()),
+                         s.stamp_, s.offset_, s.weight_);
+    if ( P_.checkpoint_spikes_ )
+      B_.pending_.push_back(s);
+  }
+
+  void mynest::iaf_freq_sensor_v2_ps::handle(CurrentEvent& e)
+  {
+    assert(e.get_delay() > 0);
+    const double_t I = e.get_current();
+    const double_t w = e.get_weight();
+    B_.currents_.add_value(e.get_rel_delivery_steps(network()->get_slice_origin()), w * I);
+  }
+
+  void mynest::iaf_freq_sensor_v2_ps::handle(DataLoggingRequest& e)
+  {
+    B_.logger_.handle(e);
+  }
+
+  /* ----------------------------------------------------------------
+   * Checkpointing, see checkpoint.h
+   * ---------------------------------------------------------------- */
+
+  void mynest::iaf_freq_sensor_v2_ps::save_checkpoint(CheckpointWriter& w, bool with_buffers)
+  {
+    w.put(S_.u_);
+    w.put(S_.v0_);
+    w.put(S_.v1_);
+    w.put(S_.s_);
+    w.put(S_.Ie_);
+    w.put(S_.t_clk_);
+    w.put(S_.is_refractory_);
+    w.put(S_.last_spike_step_);
+    w.put(S_.last_spike_offset_);
+
+    if ( with_buffers )
+    {
+      w.put(B_.currents_);
+
+      if ( !P_.checkpoint_spikes_ )
+        throw BadProperty("iaf_freq_sensor_v2_ps can save its queued spikes "
+                          "only with checkpoint_spikes true.");
+
+      // spikes not delivered yet, the others are dropped with the next slice
+      const long_t now = network()->get_time().get_steps();
+      size_t n = 0;
+      for ( size_t i = 0; i < B_.pending_.size(); ++i )
+        if ( B_.pending_[i].stamp_ >= now )
+          ++n;
+      w.put(n);
+      for ( size_t i = 0; i < B_.pending_.size(); ++i )
+        if ( B_.pending_[i].stamp_ >= now )
+        {
+          w.put(B_.pending_[i].stamp_);
+          w.put(B_.pending_[i].offset_);
+          w.put(B_.pending_[i].weight_);
+        }
+    }
+  }
+
+  void mynest::iaf_freq_sensor_v2_ps::load_checkpoint(CheckpointReader& r, bool with_buffers)
+  {
+    r.get(S_.u_);
+    r.get(S_.v0_);
+    r.get(S_.v1_);
+    r.get(S_.s_);
+    r.get(S_.Ie_);
+    r.get(S_.t_clk_);
+    r.get(S_.is_refractory_);
+    r.get(S_.last_spike_step_);
+    r.get(S_.last_spike_offset_);
+
+    if ( with_buffers )
+    {
+      r.get(B_.currents_);
+
+      // the spikes are read into locals, so they are checked as well
+      const long_t n = static_cast<long_t>(r.read());
+      if ( n < 0 )
+        throw BadProperty("Checkpoint record does not match the size of the node.");
+      if ( !r.checking() )
+      {
+        B_.events_.clear();
+        B_.pending_.clear();
+      }
+      const long_t origin = network()->get_slice_origin().get_steps();
+      for ( long_t i = 0; i < n; ++i )
+      {
+        PendingSpike_ s;
+        s.stamp_ = static_cast<long_t>(r.read());
+        s.offset_ = r.read();
+        s.weight_ = r.read();
+        if ( s.stamp_ < origin )
+          throw BadProperty("Checkpoint holds spikes delivered before the current time.");
+        if ( !r.checking() )
+        {
+          if ( P_.checkpoint_spikes_ )
+            B_.pending_.push_back(s);
+          B_.events_.add_spike(s.stamp_ - origin, s.stamp_, s.offset_, s.weight_);
+        }
+      }
+    }
+  }
+
+} // namespace
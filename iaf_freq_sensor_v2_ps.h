@@ -0,0 +1,397 @@
+/*
+ *  iaf_freq_sensor_v2_ps.h
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef IAF_FREQ_SENSOR_V2_PS_H
+#define IAF_FREQ_SENSOR_V2_PS_H
+
+#include "nest.h"
+#include "event.h"
+#include "archiving_node_ext.h"
+#include "ring_buffer.h"
+#include "slice_ring_buffer.h"
+#include "connection.h"
+#include "universal_data_logger.h"
+#include "recordables_map.h"
+#include "checkpoint.h"
+
+#include <vector>
+
+/* BeginDocumentation
+Name: iaf_freq_sensor_v2_ps - Frequency sensor neuron with precise spike timing.
+
+Description:
+
+  iaf_freq_sensor_v2_ps is the precise-spike variant of iaf_freq_sensor_v2.
+  The sensor encodes the frequency content of its input current in the
+  phase of its output spike relative to the clock input, so quantizing
+  clock resets and threshold crossings to the computation grid forces
+  very small resolutions in iaf_freq_sensor_v2.
+
+  This model handles clock spikes at their precise arrival time within a
+  time step and emits spikes at the precise time of threshold crossing.
+  Between events the dynamics are solved analytically:
+
+    u(t)  = exp(-t/tau_m) * (u(0) + s(0) * v1 * t / C_m)
+    s(t)  = exp(-t/tau_m) * s(0)
+    v0(t) = v0(0) + P2 * Ie * [F(t - t_clk - D_Int)]_0^t,
+            F(x) = x * exp(-x^2 / (2 Sigma^2))
+
+  F is the primitive of the Mexican hat wavelet used by iaf_freq_sensor_v2,
+  so the wavelet convolution is exact for the piecewise constant input
+  current and no quadrature is needed. Threshold crossings are located by
+  bisection on the analytical membrane trajectory.
+
+  The input current is piecewise constant on the computation grid, as for
+  all CurrentEvent inputs. The refractory period is rounded to the grid,
+  as in iaf_freq_sensor_v2, but starts at the precise spike time.
+
+Parameters:
+
+  The parameters are those of iaf_freq_sensor_v2, and checkpoint_spikes.
+
+  V_m        double - Membrane potential in mV
+  E_L        double - Resting membrane potential in mV.
+  C_m        double - Capacity of the membrane in pF
+  tau_m      double - Membrane time constant in ms.
+  t_ref      double - Duration of refractory period in ms.
+  V_th       double - Spike threshold in mV.
+  V_reset    double - Reset potential of the membrane in mV.
+  V_min      double - Absolute lower value for the membrane potential.
+  Sigma      double - Wavelet scale factor in ms.
+  D_Int      double - Wavelet convolution delay in ms.
+  checkpoint_spikes bool - Keep a copy of the queued input spikes for
+                      SaveCheckpoint, see remarks (default false).
+
+Remarks:
+
+  Clock spikes are recognized by a weight larger than 0.1, as in
+  iaf_freq_sensor_v2. Spikes sent by grid-based models arrive with offset
+  zero, so the model can be clocked by any spike source.
+
+  The queue of precise input spikes cannot be read without delivering
+  the spikes. SaveCheckpoint with buffers therefore needs
+  checkpoint_spikes true, set before the spikes to be saved are sent;
+  otherwise it fails for this model. The copy costs memory and time per
+  spike, so it is off by default.
+
+References:
+  [1] Morrison A, Straube S, Plesser H E, & Diesmann M (2007) Exact subthreshold
+      integration with continuous spike times in discrete time neural network
+      simulations. Neural Computation 19:47-79
+
+Sends: SpikeEvent
+
+Receives: SpikeEvent, CurrentEvent, DataLoggingRequest
+
+Author: Zhenzhong Wang
+SeeAlso: iaf_freq_sensor_v2, iaf_psc_alpha_canon
+*/
+using namespace nest;
+namespace mynest
+{
+  class Network;
+
+  /**
+   * Frequency sensor neuron with precise clock resets and spike times.
+   */
+  class iaf_freq_sensor_v2_ps : public Archiving_Node_Ext, public Checkpointable
+  {
+
+  public:
+
+    iaf_freq_sensor_v2_ps();
+    iaf_freq_sensor_v2_ps(const iaf_freq_sensor_v2_ps&);
+
+    /**
+     * Import sets of overloaded virtual functions.
+     * @see Technical Issues / Virtual Functions: Overriding, Overloading, and Hiding
+     */
+
+    using Node::connect_sender;
+    using Node::handle;
+
+    port check_connection(Connection&, port);
+
+    void handle(SpikeEvent &);
+    void handle(CurrentEvent &);
+    void handle(DataLoggingRequest &);
+
+    port connect_sender(SpikeEvent&, port);
+    port connect_sender(CurrentEvent&, port);
+    port connect_sender(DataLoggingRequest &, port);
+
+    /**
+     * Spikes are emitted with precise offsets.
+     */
+    bool is_off_grid() const { return true; }
+
+    void get_status(DictionaryDatum &) const;
+    void set_status(const DictionaryDatum &);
+
+    void save_checkpoint(CheckpointWriter&, bool);
+    void load_checkpoint(CheckpointReader&, bool);
+
+  private:
+
+    void init_state_(const Node& proto);
+    void init_buffers_();
+    void calibrate();
+
+    void update(Time const &, const long_t, const long_t);
+
+    // The next two classes need to be friends to access the State_ class/member
+    friend class RecordablesMap<iaf_freq_sensor_v2_ps>;
+    friend class UniversalDataLogger<iaf_freq_sensor_v2_ps>;
+
+    // ----------------------------------------------------------------
+
+    struct Parameters_ {
+
+      /** Membrane time constant in ms. */
+      double_t Tau_;
+
+      /** Membrane capacitance in pF. */
+      double_t C_;
+
+      /** Refractory period in ms. */
+      double_t TauR_;
+
+      /** Resting potential in mV. */
+      double_t U0_;
+
+      /** External current in pA */
+      double_t I_e_;
+
+      /** Reset value of the membrane potential */
+      double_t V_reset_;
+
+      /** Threshold, RELATIVE TO RESTING POTENTIAL(!).
+          I.e. the real threshold is (U0_+Theta_). */
+      double_t Theta_;
+
+      /** Lower bound, RELATIVE TO RESTING POTENTIAL(!).
+          I.e. the real lower bound is (LowerBound_+U0_). */
+      double_t LowerBound_;
+
+      /** Wavelet scale factor **/
+      double_t Sigma_;
+
+      /** Wavelet convolution delay **/
+      double_t D_Int_;
+
+      /** Keep B_.pending_ for checkpoints */
+      bool checkpoint_spikes_;
+
+      Parameters_();  //!< Sets default parameter values
+
+      void get(DictionaryDatum&) const;  //!< Store current values in dictionary
+
+      /** Set values from dictionary.
+       * @returns Change in reversal potential E_L, to be passed to State_::set()
+       */
+      double set(const DictionaryDatum&);
+
+    };
+
+    // ----------------------------------------------------------------
+
+    struct State_ {
+      double_t u_;  //membrane voltage
+      double_t v0_; //real-time v
+      double_t v1_; //bufferred v
+      double_t s_;  //S_enc synaptic current
+      double_t Ie_; //Constant current
+      double_t t_clk_; //precise time of last clock spike in ms
+
+      bool     is_refractory_;  //!< True while the neuron is refractory
+      long_t   last_spike_step_;    //!< Time stamp of the last spike
+      double_t last_spike_offset_;  //!< Offset of the last spike
+
+      State_();  //!< Default initialization
+
+      void get(DictionaryDatum&, const Parameters_&) const;
+
+      /** Set values from dictionary.
+       * @param dictionary to take data from
+       * @param current parameters
+       * @param Change in reversal potential E_L specified by this dict
+       */
+      void set(const DictionaryDatum&, const Parameters_&, double);
+
+    };
+
+    // ----------------------------------------------------------------
+
+    struct PendingSpike_ {
+      long_t   stamp_;   //!< Step the spike is delivered in
+      double_t offset_;
+      double_t weight_;
+    };
+
+    struct Buffers_ {
+
+      Buffers_(iaf_freq_sensor_v2_ps&);
+      Buffers_(const Buffers_&, iaf_freq_sensor_v2_ps&);
+
+      /** Clock spikes with their precise offsets */
+      SliceRingBuffer events_;
+      RingBuffer currents_;
+
+      /** Copy of the spikes in events_, which cannot be read without
+          delivering them, for checkpoints. Kept only with
+          checkpoint_spikes_, delivered spikes are dropped at the start
+          of each slice. */
+      std::vector<PendingSpike_> pending_;
+
+      //! Logger for all analog data
+      UniversalDataLogger<iaf_freq_sensor_v2_ps> logger_;
+
+    };
+
+    // ----------------------------------------------------------------
+
+    struct Variables_ {
+
+      double_t h_ms_;  //!< Time resolution in ms
+      int_t    RefractoryCounts_;
+
+      double_t P2_;    //!< Wavelet amplitude
+      double_t inv_Tau_;
+      double_t inv_2Sigma2_;
+
+    };
+
+    /**
+     * Propagate the state from offset from_offset to offset to_offset
+     * within the step ending at stamp T+1, emitting a spike if the
+     * membrane potential crosses the threshold in between.
+     */
+    void propagate_(const long_t T, const long_t lag,
+                    const double_t from_offset, const double_t to_offset);
+
+    /** Step in which the refractory period of the last spike ends. */
+    long_t refractory_end_() const
+    {
+      return S_.last_spike_step_ - 1 + V_.RefractoryCounts_;
+    }
+
+    /** Membrane potential dt ms after the current state. */
+    double_t u_at_(const double_t dt) const;
+
+    /** Primitive of the wavelet, see documentation. */
+    double_t F_(const double_t x) const;
+
+    void emit_spike_(const long_t T, const long_t lag, const double_t offset);
+
+    // Access functions for UniversalDataLogger -------------------------------
+
+    //! Read out the real membrane potential
+    double_t get_V_m_() const { return S_.u_;}
+    double_t get_V0_() const {return S_.v0_;}
+    double_t get_V1_() const {return S_.v1_;}
+    double_t get_Syn_() const {return S_.s_;}
+    double_t get_Ie_() const {return S_.Ie_;}
+
+    // Data members -----------------------------------------------------------
+
+    /**
+     * @defgroup iaf_freq_sensor_v2_ps_data
+     * Instances of private data structures for the different types
+     * of data pertaining to the model.
+     * @note The order of definitions is important for speed.
+     * @{
+     */
+    Parameters_ P_;
+    State_      S_;
+    Variables_  V_;
+    Buffers_    B_;
+    /** @} */
+
+    //! Mapping of recordables names to access functions
+    static RecordablesMap<iaf_freq_sensor_v2_ps> recordablesMap_;
+  };
+
+  inline
+  port iaf_freq_sensor_v2_ps::check_connection(Connection& c, port receptor_type)
+  {
+    SpikeEvent e;
+    e.set_sender(*this);
+    c.check_event(e);
+    return c.get_target()->connect_sender(e, receptor_type);
+  }
+
+  inline
+  port iaf_freq_sensor_v2_ps::connect_sender(SpikeEvent&, port receptor_type)
+  {
+    if (receptor_type != 0)
+      throw UnknownReceptorType(receptor_type, get_name());
+    return 0;
+  }
+
+  inline
+  port iaf_freq_sensor_v2_ps::connect_sender(CurrentEvent&, port receptor_type)
+  {
+    if (receptor_type != 0)
+      throw UnknownReceptorType(receptor_type, get_name());
+    return 0;
+  }
+
+  inline
+  port iaf_freq_sensor_v2_ps::connect_sender(DataLoggingRequest& dlr, port receptor_type)
+  {
+    if (receptor_type != 0)
+      throw UnknownReceptorType(receptor_type, get_name());
+    return B_.logger_.connect_logging_device(dlr, recordablesMap_);
+  }
+
+  inline
+  void iaf_freq_sensor_v2_ps::get_status(DictionaryDatum &d) const
+  {
+    P_.get(d);
+    S_.get(d, P_);
+    Archiving_Node_Ext::get_status(d);
+
+    (*d)[names::recordables] = recordablesMap_.get_list();
+  }
+
+  inline
+  void iaf_freq_sensor_v2_ps::set_status(const DictionaryDatum &d)
+  {
+    Parameters_ ptmp = P_;            // temporary copy in case of errors
+    const double delta_EL = ptmp.set(d);         // throws if BadProperty
+    State_      stmp = S_;            // temporary copy in case of errors
+    stmp.set(d, ptmp, delta_EL);                 // throws if BadProperty
+
+    // We now know that (ptmp, stmp) are consistent. We do not
+    // write them back to (P_, S_) before we are also sure that
+    // the properties to be set in the parent class are internally
+    // consistent.
+    Archiving_Node_Ext::set_status(d);
+
+    // if we get here, temporaries contain consistent set of properties
+    P_ = ptmp;
+    S_ = stmp;
+  }
+
+} // namespace
+
+#endif /* #ifndef IAF_FREQ_SENSOR_V2_PS_H */
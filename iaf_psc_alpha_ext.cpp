@@ -33,6 +33,16 @@
 #include <limits>
 
 nest::RecordablesMap<mynest::iaf_psc_alpha_ext> mynest::iaf_psc_alpha_ext::recordablesMap_;
+
+#ifdef MYMODULE_PROFILE
+namespace
+{
+  const char* const profile_names[] =
+    { "steps", "refractory_steps", "update_cycles" };
+}
+
+mynest::ProfileCounters mynest::iaf_psc_alpha_ext::profile_(profile_names, 3);
+#endif
 using namespace nest;
 
 namespace nest
@@ -185,7 +195,7 @@ namespace mynest
    * ---------------------------------------------------------------- */
 
   mynest::iaf_psc_alpha_ext::iaf_psc_alpha_ext()
-    : Archiving_Node(),
+    : Archiving_Node_Ext(),
       P_(),
       S_(),
       B_(*this)
@@ -194,7 +204,7 @@ namespace mynest
   }
 
   mynest::iaf_psc_alpha_ext::iaf_psc_alpha_ext(const iaf_psc_alpha_ext& n)
-    : Archiving_Node(n),
+    : Archiving_Node_Ext(n),
       P_(n.P_),
       S_(n.S_),
       B_(n.B_, *this)
@@ -218,7 +228,7 @@ namespace mynest
 
     B_.logger_.reset();
 
-    Archiving_Node::clear_history();
+    Archiving_Node_Ext::clear_history();
   }
 
   void mynest::iaf_psc_alpha_ext::calibrate()
@@ -287,6 +297,7 @@ namespace mynest
   {
     assert(to >= 0 && (delay) from < Scheduler::get_min_delay());
     assert(from < to);
+    MYMODULE_PROFILE_START(prof_start);
 
     for ( long_t lag = from ; lag < to ; ++lag )
     {
@@ -299,8 +310,11 @@ namespace mynest
         // lower bound of membrane potential
         S_.y3_ = ( S_.y3_ < P_.LowerBound_ ? P_.LowerBound_ : S_.y3_);
       }
-      else // neuron is absolute refractory
+      else
+      { // neuron is absolute refractory
         --S_.r_;
+        MYMODULE_PROFILE_COUNT(profile_, get_thread(), PROF_REFRACTORY, 1);
+      }
 
       // alpha shape EPSCs
       S_.y2_ex_  = V_.P21_ex_ * S_.y1_ex_ + V_.P22_ex_ * S_.y2_ex_;
@@ -340,6 +354,9 @@ namespace mynest
       // log state data
       B_.logger_.record_data(origin.get_steps() + lag);
     }
+
+    MYMODULE_PROFILE_COUNT(profile_, get_thread(), PROF_STEPS, to - from);
+    MYMODULE_PROFILE_STOP(profile_, get_thread(), PROF_UPDATE_CYCLES, prof_start);
   }
 
   void mynest::iaf_psc_alpha_ext::handle(SpikeEvent& e)
@@ -369,4 +386,44 @@ namespace mynest
     B_.logger_.handle(e);
   }
 
+  /* ----------------------------------------------------------------
+   * Checkpointing, see checkpoint.h
+   * ---------------------------------------------------------------- */
+
+  void mynest::iaf_psc_alpha_ext::save_checkpoint(CheckpointWriter& w, bool with_buffers)
+  {
+    w.put(S_.y0_);
+    w.put(S_.y1_ex_);
+    w.put(S_.y2_ex_);
+    w.put(S_.y1_in_);
+    w.put(S_.y2_in_);
+    w.put(S_.y3_);
+    w.put(S_.r_);
+
+    if ( with_buffers )
+    {
+      w.put(B_.ex_spikes_);
+      w.put(B_.in_spikes_);
+      w.put(B_.currents_);
+    }
+  }
+
+  void mynest::iaf_psc_alpha_ext::load_checkpoint(CheckpointReader& r, bool with_buffers)
+  {
+    r.get(S_.y0_);
+    r.get(S_.y1_ex_);
+    r.get(S_.y2_ex_);
+    r.get(S_.y1_in_);
+    r.get(S_.y2_in_);
+    r.get(S_.y3_);
+    r.get(S_.r_);
+
+    if ( with_buffers )
+    {
+      r.get(B_.ex_spikes_);
+      r.get(B_.in_spikes_);
+      r.get(B_.currents_);
+    }
+  }
+
 } // namespace
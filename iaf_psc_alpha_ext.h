@@ -25,11 +25,13 @@
 
 #include "nest.h"
 #include "event.h"
-#include "archiving_node.h"
+#include "archiving_node_ext.h"
 #include "ring_buffer.h"
 #include "connection.h"
 #include "universal_data_logger.h"
 #include "recordables_map.h"
+#include "checkpoint.h"
+#include "profile_counters.h"
 
 /* BeginDocumentation
 Name: iaf_psc_alpha_ext - Leaky integrate-and-fire neuron model.
@@ -129,7 +131,7 @@ namespace mynest
   /**
    * Leaky integrate-and-fire neuron with alpha-shaped PSCs.
    */
-  class iaf_psc_alpha_ext : public Archiving_Node
+  class iaf_psc_alpha_ext : public Archiving_Node_Ext, public Checkpointable
   {
     
   public:
@@ -158,6 +160,9 @@ namespace mynest
     void get_status(DictionaryDatum &) const;
     void set_status(const DictionaryDatum &);
 
+    void save_checkpoint(CheckpointWriter&, bool);
+    void load_checkpoint(CheckpointReader&, bool);
+
   private:
 
     void init_state_(const Node& proto);
@@ -321,6 +326,12 @@ namespace mynest
     
     //! Mapping of recordables names to access functions
     static RecordablesMap<iaf_psc_alpha_ext> recordablesMap_;
+
+#ifdef MYMODULE_PROFILE
+    //! Hot-path counters of all instances, see profile_counters.h
+    enum ProfileCounter_ { PROF_STEPS, PROF_REFRACTORY, PROF_UPDATE_CYCLES };
+    static ProfileCounters profile_;
+#endif
   };
 
   inline
@@ -361,9 +372,13 @@ namespace mynest
   {
     P_.get(d);
     S_.get(d, P_);
-    Archiving_Node::get_status(d);
+    Archiving_Node_Ext::get_status(d);
   
     (*d)[names::recordables] = recordablesMap_.get_list();
+
+#ifdef MYMODULE_PROFILE
+    profile_.get(d);
+#endif
   }
   
   inline
@@ -378,7 +393,7 @@ namespace mynest
     // write them back to (P_, S_) before we are also sure that 
     // the properties to be set in the parent class are internally 
     // consistent.
-    Archiving_Node::set_status(d);
+    Archiving_Node_Ext::set_status(d);
   
     // if we get here, temporaries contain consistent set of properties
     P_ = ptmp;
@@ -38,6 +38,16 @@
 
 nest::RecordablesMap<mynest::iaf_psc_alpha_multi_ext> mynest::iaf_psc_alpha_multi_ext::recordablesMap_;
 
+#ifdef MYMODULE_PROFILE
+namespace
+{
+  const char* const profile_names[] =
+    { "steps", "refractory_steps", "update_cycles" };
+}
+
+mynest::ProfileCounters mynest::iaf_psc_alpha_multi_ext::profile_(profile_names, 3);
+#endif
+
 namespace nest
 {
   // Override the create() method with one call to RecordablesMap::insert_() 
@@ -98,8 +108,8 @@ void mynest::iaf_psc_alpha_multi_ext::Parameters_::get(DictionaryDatum &d) const
   def<int>(d,"n_synapses", num_of_receptors_);
   def<bool>(d, names::has_connections, has_connections_);
   
-  ArrayDatum tau_syn_r_ad(tau_syn_r_);
-  ArrayDatum tau_syn_f_ad(tau_syn_f_);
+  ArrayDatum tau_syn_r_ad(tau_syn_r_.to_vector());
+  ArrayDatum tau_syn_f_ad(tau_syn_f_.to_vector());
   def<ArrayDatum>(d,"tau_syn_r", tau_syn_r_ad);
   def<ArrayDatum>(d,"tau_syn_f", tau_syn_f_ad);
 
@@ -205,7 +215,7 @@ mynest::iaf_psc_alpha_multi_ext::Buffers_::Buffers_(const Buffers_ &, iaf_psc_al
  * ---------------------------------------------------------------- */
 
 mynest::iaf_psc_alpha_multi_ext::iaf_psc_alpha_multi_ext()
-  : Archiving_Node(), 
+  : Archiving_Node_Ext(), 
     P_(), 
     S_(),
     B_(*this)
@@ -214,7 +224,7 @@ mynest::iaf_psc_alpha_multi_ext::iaf_psc_alpha_multi_ext()
 }
 
 mynest::iaf_psc_alpha_multi_ext::iaf_psc_alpha_multi_ext(const iaf_psc_alpha_multi_ext& n)
-  : Archiving_Node(n), 
+  : Archiving_Node_Ext(n), 
     P_(n.P_), 
     S_(n.S_),
     B_(n.B_, *this)
@@ -237,7 +247,7 @@ void mynest::iaf_psc_alpha_multi_ext::init_buffers_()
 
   B_.logger_.reset();
 
-  Archiving_Node::clear_history();
+  Archiving_Node_Ext::clear_history();
 }
 
 void mynest::iaf_psc_alpha_multi_ext::calibrate()
@@ -295,6 +305,7 @@ void mynest::iaf_psc_alpha_multi_ext::update(Time const& origin, const long_t fr
 {
   assert(to >= 0 && (delay) from < Scheduler::get_min_delay());
   assert(from < to);
+  MYMODULE_PROFILE_START(prof_start);
 
   for ( long_t lag = from ; lag < to ; ++lag )
   {
@@ -314,8 +325,11 @@ void mynest::iaf_psc_alpha_multi_ext::update(Time const& origin, const long_t fr
       // lower bound of membrane potential
       S_.y3_ = ( S_.y3_<P_.LowerBound_ ? P_.LowerBound_ : S_.y3_); 
     }
-    else // neuron is absolute refractory
+    else
+    { // neuron is absolute refractory
       --S_.r_;
+      MYMODULE_PROFILE_COUNT(profile_, get_thread(), PROF_REFRACTORY, 1);
+    }
 
     for (size_t i=0; i < P_.num_of_receptors_; i++)
     {      
@@ -347,6 +361,9 @@ void mynest::iaf_psc_alpha_multi_ext::update(Time const& origin, const long_t fr
     // log state data
     B_.logger_.record_data(origin.get_steps() + lag);
   }  
+
+  MYMODULE_PROFILE_COUNT(profile_, get_thread(), PROF_STEPS, to - from);
+  MYMODULE_PROFILE_STOP(profile_, get_thread(), PROF_UPDATE_CYCLES, prof_start);
 }
 
 port mynest::iaf_psc_alpha_multi_ext::connect_sender(SpikeEvent&, port receptor_type)
@@ -387,4 +404,40 @@ void mynest::iaf_psc_alpha_multi_ext::handle(DataLoggingRequest& e)
   B_.logger_.handle(e);
 }
 
+/* ----------------------------------------------------------------
+ * Checkpointing, see checkpoint.h
+ * ---------------------------------------------------------------- */
+
+void mynest::iaf_psc_alpha_multi_ext::save_checkpoint(CheckpointWriter& w, bool with_buffers)
+{
+  w.put(S_.y0_);
+  w.put(S_.y1_syn_);
+  w.put(S_.y2_syn_);
+  w.put(S_.y3_);
+  w.put(S_.current_);
+  w.put(S_.r_);
+
+  if ( with_buffers )
+  {
+    w.put(B_.spikes_);
+    w.put(B_.currents_);
+  }
+}
+
+void mynest::iaf_psc_alpha_multi_ext::load_checkpoint(CheckpointReader& r, bool with_buffers)
+{
+  r.get(S_.y0_);
+  r.get(S_.y1_syn_);
+  r.get(S_.y2_syn_);
+  r.get(S_.y3_);
+  r.get(S_.current_);
+  r.get(S_.r_);
+
+  if ( with_buffers )
+  {
+    r.get(B_.spikes_);
+    r.get(B_.currents_);
+  }
+}
+
 } // namespace
@@ -25,11 +25,14 @@
 
 #include "nest.h"
 #include "event.h"
-#include "archiving_node.h"
+#include "archiving_node_ext.h"
 #include "ring_buffer.h"
 #include "connection.h"
 #include "universal_data_logger.h"
 #include "recordables_map.h"
+#include "checkpoint.h"
+#include "profile_counters.h"
+#include "neuron_arena.h"
 
   /* BeginDocumentation
 Name: iaf_psc_alpha_multi_ext - Leaky integrate-and-fire neuron model with multiple ports.
@@ -60,7 +63,7 @@ namespace mynest
   /**
    * Leaky integrate-and-fire neuron with alpha-shaped PSCs.
    */
-  class iaf_psc_alpha_multi_ext : public Archiving_Node
+  class iaf_psc_alpha_multi_ext : public Archiving_Node_Ext, public Checkpointable
   {
     
   public:
@@ -89,6 +92,9 @@ namespace mynest
     void get_status(DictionaryDatum &) const;
     void set_status(const DictionaryDatum &);
 
+    void save_checkpoint(CheckpointWriter&, bool);
+    void load_checkpoint(CheckpointReader&, bool);
+
   private:
 
     void init_state_(const Node& proto);
@@ -135,8 +141,8 @@ namespace mynest
       double_t LowerBound_;
 
       /** Time constants of synaptic currents in ms. */
-      std::vector<double_t> tau_syn_r_;
-      std::vector<double_t> tau_syn_f_;
+      ArenaArray tau_syn_r_;
+      ArenaArray tau_syn_f_;
       
       // type is long because other types are not put through in GetStatus
       std::vector<long> receptor_types_;
@@ -162,8 +168,8 @@ namespace mynest
      */
     struct State_ {
       double_t     y0_; //!< Constant current
-      std::vector<double_t>  y1_syn_;  
-      std::vector<double_t>  y2_syn_;
+      ArenaArray  y1_syn_;  
+      ArenaArray  y2_syn_;
       double_t     y3_; //!< This is the membrane potential RELATIVE TO RESTING POTENTIAL.
       double_t     current_; //! This is the current in a time step. This is only here to allow logging
       
@@ -204,12 +210,12 @@ namespace mynest
      * Internal variables of the model.
      */
     struct Variables_ {
-      std::vector<double_t> PSCInitialValues_;
+      ArenaArray PSCInitialValues_;
       int_t       RefractoryCounts_;
       
-      std::vector<double_t> P11_syn_;
-      std::vector<double_t> P21_syn_;
-      std::vector<double_t> P22_syn_;
+      ArenaArray P11_syn_;
+      ArenaArray P21_syn_;
+      ArenaArray P22_syn_;
       //std::vector<double_t> P31_syn_;
       //std::vector<double_t> P32_syn_;
       
@@ -243,6 +249,12 @@ namespace mynest
 
     //! Mapping of recordables names to access functions
     static RecordablesMap<iaf_psc_alpha_multi_ext> recordablesMap_;
+
+#ifdef MYMODULE_PROFILE
+  //! Hot-path counters of all instances, see profile_counters.h
+  enum ProfileCounter_ { PROF_STEPS, PROF_REFRACTORY, PROF_UPDATE_CYCLES };
+  static ProfileCounters profile_;
+#endif
   };
 
 inline
@@ -276,9 +288,13 @@ void iaf_psc_alpha_multi_ext::get_status(DictionaryDatum &d) const
 {
   P_.get(d);
   S_.get(d, P_);
-  Archiving_Node::get_status(d);
+  Archiving_Node_Ext::get_status(d);
 
   (*d)[names::recordables] = recordablesMap_.get_list();
+
+#ifdef MYMODULE_PROFILE
+  profile_.get(d);
+#endif
 }
 
 inline
@@ -293,7 +309,7 @@ void iaf_psc_alpha_multi_ext::set_status(const DictionaryDatum &d)
   // write them back to (P_, S_) before we are also sure that 
   // the properties to be set in the parent class are internally 
   // consistent.
-  Archiving_Node::set_status(d);
+  Archiving_Node_Ext::set_status(d);
 
   // if we get here, temporaries contain consistent set of properties
   P_ = ptmp;
@@ -34,6 +34,16 @@
 
 
 nest::RecordablesMap<mynest::iaf_wsn_alpha> mynest::iaf_wsn_alpha::recordablesMap_;
+
+#ifdef MYMODULE_PROFILE
+namespace
+{
+  const char* const profile_names[] =
+    { "steps", "refractory_steps", "update_currents_calls", "update_cycles" };
+}
+
+mynest::ProfileCounters mynest::iaf_wsn_alpha::profile_(profile_names, 4);
+#endif
 using namespace nest;
 
 namespace nest
@@ -72,7 +82,9 @@ namespace mynest
       LowerBound_(-std::numeric_limits<double_t>::infinity()),
       Sigma_     (  30.0   ),
       Ti_        (  50.0   ),   // ms
-      num_of_receptors_ ( 2 )
+      num_of_receptors_ ( 2 ),
+      exact_     ( true    ),
+      clock_     (    0    )
   {}
 
   mynest::iaf_wsn_alpha::State_::State_()
@@ -82,6 +94,8 @@ namespace mynest
       Im_   (0.0),
       currents_ (0.0),
       ti_   (-std::numeric_limits<double_t>::infinity()),
+      ke_   (0.0),
+      kte_  (0.0),
       r_    (0)
   {}
 
@@ -102,6 +116,8 @@ namespace mynest
     def<double>(d, "Sigma", Sigma_);
     def<double>(d, "Ti", Ti_);
     def<int>(d, "n_synapses", num_of_receptors_);
+    def<bool>(d, "exact_integration", exact_);
+    def<long>(d, "clock", clock_);
   }
 
   double mynest::iaf_wsn_alpha::Parameters_::set(const DictionaryDatum& d)
@@ -119,9 +135,10 @@ namespace mynest
     updateValue<double>(d, names::C_m, C_);
     updateValue<double>(d, names::tau_m, Tau_);
     updateValue<double>(d, names::t_ref, TauR_);
+    updateValue<long>(d, "clock", clock_);
     updateValue<double>(d, "Sigma", Sigma_);
     updateValue<double>(d, "Ti", Ti_);
-
+    updateValue<bool>(d, "exact_integration", exact_);
 
     if ( C_ <= 0.0 )
       throw BadProperty("Capacitance must be > 0.");
@@ -129,12 +146,18 @@ namespace mynest
     if ( Tau_ <= 0.0 )
       throw BadProperty("Membrane time constant must be > 0.");
 
+    if ( Sigma_ <= 0.0 )
+        throw BadProperty("Wavelet scale Sigma must be > 0.");
+
     if ( Ti_ < 0.0 )
         throw BadProperty("Integration time must be >= 0.");
 
     if ( TauR_ < 0.0 )
     	throw BadProperty("The refractory time t_ref can't be negative.");
 
+    if ( clock_ < 0 )
+        throw BadProperty("clock must be the gid of a sensor_clock or 0.");
+
     return delta_EL;
   }
 
@@ -162,7 +185,7 @@ namespace mynest
    * ---------------------------------------------------------------- */
 
   mynest::iaf_wsn_alpha::iaf_wsn_alpha()
-    : Archiving_Node(),
+    : Archiving_Node_Ext(),
       P_(),
       S_(),
       B_(*this)
@@ -171,7 +194,7 @@ namespace mynest
   }
 
   mynest::iaf_wsn_alpha::iaf_wsn_alpha(const iaf_wsn_alpha& n)
-    : Archiving_Node(n),
+    : Archiving_Node_Ext(n),
       P_(n.P_),
       S_(n.S_),
       B_(n.B_, *this)
@@ -194,7 +217,7 @@ namespace mynest
 
     B_.logger_.reset();
 
-    Archiving_Node::clear_history();
+    Archiving_Node_Ext::clear_history();
   }
 
   void mynest::iaf_wsn_alpha::calibrate()
@@ -216,6 +239,14 @@ namespace mynest
     V_.P33_ = std::exp(-h/P_.Tau_);
     V_.P32_ = P_.Tau_ / P_.C_ * ( 1.0 - V_.P33_ );
 
+    // The kernel x(t) = t*exp(-t/Sigma) is the second state of the linear
+    // system e' = -e/Sigma, x' = e - x/Sigma. Over one step h
+    //   e(t+h) = PK e(t),  x(t+h) = PK (x(t) + h e(t)),
+    // and the integral of P2*x over the step is PV1 x(t) + PV2 e(t).
+    V_.PK_ = std::exp(-h/P_.Sigma_);
+    V_.PV1_ = V_.P2_ * P_.Sigma_ * (1.0 - V_.PK_);
+    V_.PV2_ = V_.P2_ * P_.Sigma_ * (P_.Sigma_ * (1.0 - V_.PK_) - h * V_.PK_);
+
     // TauR specifies the length of the absolute refractory period as
     // a double_t in ms. The grid based iaf_wsn_alpha can only handle refractory
     // periods that are integer multiples of the computation step size (h).
@@ -238,6 +269,15 @@ namespace mynest
 
     V_.RefractoryCounts_ = Time(Time::ms(P_.TauR_)).get_steps();
     assert(V_.RefractoryCounts_ >= 0);  // since t_ref_ >= 0, this can only fail in error
+
+    // clock ticks from the instance of the clock on this thread
+    V_.clock_ = 0;
+    if ( P_.clock_ > 0 )
+    {
+      V_.clock_ = dynamic_cast<sensor_clock*>(network()->get_node(P_.clock_, get_thread()));
+      if ( V_.clock_ == 0 )
+        throw BadProperty("clock must be the gid of a sensor_clock or 0.");
+    }
   }
 
   /* ----------------------------------------------------------------
@@ -247,6 +287,7 @@ namespace mynest
   inline
   double_t mynest::iaf_wsn_alpha::update_currents_(const double_t t,const double_t Ie)
   {
+      MYMODULE_PROFILE_COUNT(profile_, get_thread(), PROF_CURRENT_CALLS, 1);
       double tt_s = (t - S_.ti_);
 
       return tt_s * V_.P2_ * std::exp(-tt_s/P_.Sigma_)*Ie;
@@ -256,6 +297,7 @@ namespace mynest
   {
     assert(to >= 0 && (delay) from < Scheduler::get_min_delay());
     assert(from < to);
+    MYMODULE_PROFILE_START(prof_start);
 
     double t;
     const double h = Time::get_resolution().get_ms();
@@ -264,13 +306,17 @@ namespace mynest
     for ( long_t lag = from ; lag < to ; ++lag )
     {
       t = Time(Time::step(origin.get_steps()+lag+1)).get_ms();
-      if(B_.spikes_[0].get_value(lag) > 0.1)
+      const bool clock = V_.clock_ != 0 ? V_.clock_->tick(origin, lag)
+                                        : B_.spikes_[0].get_value(lag) > 0.1;
+      if(clock)
       {
           // Integration spike arrive 
           S_.s_ = 0.0;
           S_.v_ = 0.0;
           S_.currents_ = 0.0;
           S_.ti_ = t;
+          S_.ke_ = 1.0;
+          S_.kte_ = 0.0;
           //S_.y3_ = P_.V_reset_;
           //S_.y1_ = 1.0;
       }
@@ -291,13 +337,22 @@ namespace mynest
         S_.u_ = V_.P33_ * S_.u_ + V_.P32_ * S_.s_ * std::abs(S_.v_);
         S_.s_ = V_.P33_ * S_.s_;
 
-        //Simpson's method for v integration
-        double_t steps[3]={0.0,h/2.0,h};
-        double_t weights[3]={h/6.0,4.0*h/6.0,h/6.0};
-        for(int j=0;j<3;j++){
-            S_.v_+=weights[j]*update_currents_(t+steps[j],S_.currents_);
+        if ( P_.exact_ )
+        {
+          // exact integral of the wavelet current over the step
+          S_.v_ += (V_.PV1_ * S_.kte_ + V_.PV2_ * S_.ke_) * S_.currents_;
+          S_.Im_ = V_.P2_ * S_.kte_ * S_.currents_;
+        }
+        else
+        {
+          //Simpson's method for v integration
+          double_t steps[3]={0.0,h/2.0,h};
+          double_t weights[3]={h/6.0,4.0*h/6.0,h/6.0};
+          for(int j=0;j<3;j++){
+              S_.v_+=weights[j]*update_currents_(t+steps[j],S_.currents_);
+          }
+          S_.Im_ = update_currents_(t,S_.currents_);
         }
-        S_.Im_ = update_currents_(t,S_.currents_);
 
         // lower bound of membrane potential
         S_.u_ = ( S_.u_ < P_.LowerBound_ ? P_.LowerBound_ : S_.u_);
@@ -305,8 +360,15 @@ namespace mynest
         S_.s_ = ( S_.s_ < P_.LowerBound_ ? P_.LowerBound_ : S_.s_);
 
       }
-      else // neuron is absolute refractory
+      else
+      { // neuron is absolute refractory
         --S_.r_;
+        MYMODULE_PROFILE_COUNT(profile_, get_thread(), PROF_REFRACTORY, 1);
+      }
+
+      // the kernel advances in refractory steps as well
+      S_.kte_ = V_.PK_ * (S_.kte_ + h * S_.ke_);
+      S_.ke_ = V_.PK_ * S_.ke_;
 
       if ( Vm0 < P_.Theta_ && S_.u_ >= P_.Theta_)
       {
@@ -329,6 +391,9 @@ namespace mynest
       // log state data
       B_.logger_.record_data(origin.get_steps() + lag);
     }
+
+    MYMODULE_PROFILE_COUNT(profile_, get_thread(), PROF_STEPS, to - from);
+    MYMODULE_PROFILE_STOP(profile_, get_thread(), PROF_UPDATE_CYCLES, prof_start);
   }
 
   port mynest::iaf_wsn_alpha::connect_sender(SpikeEvent&, port receptor_type)
@@ -366,4 +431,46 @@ namespace mynest
     B_.logger_.handle(e);
   }
 
+  /* ----------------------------------------------------------------
+   * Checkpointing, see checkpoint.h
+   * ---------------------------------------------------------------- */
+
+  void mynest::iaf_wsn_alpha::save_checkpoint(CheckpointWriter& w, bool with_buffers)
+  {
+    w.put(S_.u_);
+    w.put(S_.v_);
+    w.put(S_.s_);
+    w.put(S_.Im_);
+    w.put(S_.currents_);
+    w.put(S_.ti_);
+    w.put(S_.ke_);
+    w.put(S_.kte_);
+    w.put(S_.r_);
+
+    if ( with_buffers )
+    {
+      w.put(B_.spikes_);
+      w.put(B_.currents_);
+    }
+  }
+
+  void mynest::iaf_wsn_alpha::load_checkpoint(CheckpointReader& r, bool with_buffers)
+  {
+    r.get(S_.u_);
+    r.get(S_.v_);
+    r.get(S_.s_);
+    r.get(S_.Im_);
+    r.get(S_.currents_);
+    r.get(S_.ti_);
+    r.get(S_.ke_);
+    r.get(S_.kte_);
+    r.get(S_.r_);
+
+    if ( with_buffers )
+    {
+      r.get(B_.spikes_);
+      r.get(B_.currents_);
+    }
+  }
+
 } // namespace
@@ -25,11 +25,14 @@
 
 #include "nest.h"
 #include "event.h"
-#include "archiving_node.h"
+#include "archiving_node_ext.h"
 #include "ring_buffer.h"
 #include "connection.h"
 #include "universal_data_logger.h"
 #include "recordables_map.h"
+#include "checkpoint.h"
+#include "profile_counters.h"
+#include "sensor_clock.h"
 
 /* BeginDocumentation
 Name: iaf_wsn_alpha - Leaky integrate-and-fire neuron model.
@@ -97,6 +100,10 @@ Parameters:
   tau_syn_in_f double - Falling time of the inhibitory synaptic alpha function in ms.
   I_e        double - Constant external input current in pA.
   V_min      double - Absolute lower value for the membrane potential.
+  clock      int    - Gid of a sensor_clock whose ticks replace the clock
+                      spikes, 0 (default) to use clock spikes.
+  exact_integration bool - Integrate the wavelet current exactly (default),
+                    or with Simpson's rule as in earlier versions.
  
 Note:
   tau_m != tau_syn_{ex,in} is required by the current implementation to avoid a
@@ -129,7 +136,7 @@ namespace mynest
   /**
    * Leaky integrate-and-fire neuron with alpha-shaped PSCs.
    */
-  class iaf_wsn_alpha : public Archiving_Node
+  class iaf_wsn_alpha : public Archiving_Node_Ext, public Checkpointable
   {
     
   public:
@@ -158,6 +165,9 @@ namespace mynest
     void get_status(DictionaryDatum &) const;
     void set_status(const DictionaryDatum &);
 
+    void save_checkpoint(CheckpointWriter&, bool);
+    void load_checkpoint(CheckpointReader&, bool);
+
   private:
 
     void init_state_(const Node& proto);
@@ -209,7 +219,13 @@ namespace mynest
       /** Synapse number, constant **/
       size_t num_of_receptors_;
       std::vector<long> receptor_types_;
+
+      /** Exact propagation of the wavelet integral instead of Simpson's rule **/
+      bool exact_;
       
+      /** Gid of a sensor_clock, 0 for clock spikes **/
+      long_t clock_;
+
       Parameters_();  //!< Sets default parameter values
 
       void get(DictionaryDatum&) const;  //!< Store current values in dictionary
@@ -232,6 +248,11 @@ namespace mynest
       double_t currents_;
       double_t ti_;
 
+      /** Wavelet kernel exp(-t/Sigma) and t*exp(-t/Sigma) at the time
+          since the last clock spike, for exact integration. */
+      double_t ke_;
+      double_t kte_;
+
       int_t    r_;  //!< Number of refractory steps remaining
 
       State_();  //!< Default initialization
@@ -272,11 +293,19 @@ namespace mynest
 	  weight one has an amplitude of 1 mV.
        */
       int_t    RefractoryCounts_;
+
+      /** Clock instance of this thread, 0 for clock spikes */
+      sensor_clock* clock_;
     
       double_t P2_;
       double_t P32_;
       double_t P33_;
 
+      // exact integration: kernel propagator and integral over one step
+      double_t PK_;
+      double_t PV1_;
+      double_t PV2_;
+
     };
 
     //ODE
@@ -309,6 +338,12 @@ namespace mynest
     
     //! Mapping of recordables names to access functions
     static RecordablesMap<iaf_wsn_alpha> recordablesMap_;
+
+#ifdef MYMODULE_PROFILE
+    //! Hot-path counters of all instances, see profile_counters.h
+    enum ProfileCounter_ { PROF_STEPS, PROF_REFRACTORY, PROF_CURRENT_CALLS, PROF_UPDATE_CYCLES };
+    static ProfileCounters profile_;
+#endif
   };
 
   inline
@@ -349,9 +384,13 @@ namespace mynest
   {
     P_.get(d);
     S_.get(d, P_);
-    Archiving_Node::get_status(d);
+    Archiving_Node_Ext::get_status(d);
   
     (*d)[names::recordables] = recordablesMap_.get_list();
+
+#ifdef MYMODULE_PROFILE
+    profile_.get(d);
+#endif
   }
   
   inline
@@ -366,7 +405,7 @@ namespace mynest
     // write them back to (P_, S_) before we are also sure that 
     // the properties to be set in the parent class are internally 
     // consistent.
-    Archiving_Node::set_status(d);
+    Archiving_Node_Ext::set_status(d);
   
     // if we get here, temporaries contain consistent set of properties
     P_ = ptmp;
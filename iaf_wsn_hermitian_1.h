@@ -25,11 +25,15 @@
 
 #include "nest.h"
 #include "event.h"
-#include "archiving_node.h"
+#include "archiving_node_ext.h"
 #include "ring_buffer.h"
 #include "connection.h"
 #include "universal_data_logger.h"
 #include "recordables_map.h"
+#include "checkpoint.h"
+#include "profile_counters.h"
+#include "sensor_clock.h"
+#include "neuron_arena.h"
 
 /* BeginDocumentation
 Name: iaf_wsn_hermitian_1 - Leaky integrate-and-fire neuron model.
@@ -97,6 +101,10 @@ Parameters:
   tau_syn_in_f double - Falling time of the inhibitory synaptic alpha function in ms.
   I_e        double - Constant external input current in pA.
   V_min      double - Absolute lower value for the membrane potential.
+  clock      int    - Gid of a sensor_clock whose ticks replace the clock
+                      spikes, 0 (default) to use clock spikes.
+  math_accuracy int - exp of the wavelet: 0 std::exp (default), 1 relative
+                      error below 1e-12, 2 below 1e-7, see module_math.h.
  
 Note:
   tau_m != tau_syn_{ex,in} is required by the current implementation to avoid a
@@ -129,7 +137,7 @@ namespace mynest
   /**
    * Leaky integrate-and-fire neuron with alpha-shaped PSCs.
    */
-  class iaf_wsn_hermitian_1 : public Archiving_Node
+  class iaf_wsn_hermitian_1 : public Archiving_Node_Ext, public Checkpointable
   {
     
   public:
@@ -158,6 +166,9 @@ namespace mynest
     void get_status(DictionaryDatum &) const;
     void set_status(const DictionaryDatum &);
 
+    void save_checkpoint(CheckpointWriter&, bool);
+    void load_checkpoint(CheckpointReader&, bool);
+
   private:
 
     void init_state_(const Node& proto);
@@ -166,6 +177,10 @@ namespace mynest
 
     void update(Time const &, const long_t, const long_t);
 
+    /** update() for MathAccuracy A, see Variables_::update_tier_. */
+    template <int A>
+    void update_(Time const &, const long_t, const long_t);
+
     // The next two classes need to be friends to access the State_ class/member
     friend class RecordablesMap<iaf_wsn_hermitian_1>;
     friend class UniversalDataLogger<iaf_wsn_hermitian_1>;
@@ -201,7 +216,7 @@ namespace mynest
       double_t LowerBound_;
 
       /** all sigmas **/
-      std::vector<double_t> Sigmas_;
+      ArenaArray Sigmas_;
 
       /** Wavelet convolution delay **/
       double_t D_Int_;
@@ -213,6 +228,12 @@ namespace mynest
       //size_t num_of_receptors_;
       //std::vector<long> receptor_types_;
 
+      /** Gid of a sensor_clock, 0 for clock spikes **/
+      long_t clock_;
+
+      /** Accuracy of exp in the wavelet, a MathAccuracy **/
+      long_t math_accuracy_;
+
       Parameters_();  //!< Sets default parameter values
 
       void get(DictionaryDatum&) const;  //!< Store current values in dictionary
@@ -228,7 +249,7 @@ namespace mynest
 
     struct State_ {
       double_t u_;  //membrane voltage
-      std::vector<double_t> v_;  //real-time v for all scales
+      ArenaArray v_;  //real-time v for all scales
       double_t vb_; //bufferred total v
       double_t s_;  //S_enc synaptic current
       double_t Ie_; //Constant current
@@ -276,15 +297,19 @@ namespace mynest
 	  weight one has an amplitude of 1 mV.
        */
       int_t    RefractoryCounts_;
+
+      /** Clock instance of this thread, 0 for clock spikes */
+      sensor_clock* clock_;
     
-      std::vector<double_t> P2_;
+      ArenaArray P2_;
       double_t P32_;
       double_t P33_;
 
-    };
+      /** update_ for the tier of math_accuracy, chosen by calibrate() so
+          that the steps do not choose it again. */
+      void (iaf_wsn_hermitian_1::*update_tier_)(Time const&, const long_t, const long_t);
 
-    //ODE
-    double_t get_Im_(const double_t, const size_t);
+    };
 
     // Access functions for UniversalDataLogger -------------------------------
 
@@ -315,6 +340,12 @@ namespace mynest
     
     //! Mapping of recordables names to access functions
     static RecordablesMap<iaf_wsn_hermitian_1> recordablesMap_;
+
+#ifdef MYMODULE_PROFILE
+    //! Hot-path counters of all instances, see profile_counters.h
+    enum ProfileCounter_ { PROF_STEPS, PROF_REFRACTORY, PROF_CURRENT_CALLS, PROF_UPDATE_CYCLES };
+    static ProfileCounters profile_;
+#endif
   };
 
   inline
@@ -355,9 +386,13 @@ namespace mynest
   {
     P_.get(d);
     S_.get(d, P_);
-    Archiving_Node::get_status(d);
+    Archiving_Node_Ext::get_status(d);
   
     (*d)[names::recordables] = recordablesMap_.get_list();
+
+#ifdef MYMODULE_PROFILE
+    profile_.get(d);
+#endif
   }
   
   inline
@@ -372,7 +407,7 @@ namespace mynest
     // write them back to (P_, S_) before we are also sure that 
     // the properties to be set in the parent class are internally 
     // consistent.
-    Archiving_Node::set_status(d);
+    Archiving_Node_Ext::set_status(d);
   
     // if we get here, temporaries contain consistent set of properties
     P_ = ptmp;
@@ -0,0 +1,211 @@
+/*
+ *  iaf_wsn_hermitian_1_kernel.h
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef IAF_WSN_HERMITIAN_1_KERNEL_H
+#define IAF_WSN_HERMITIAN_1_KERNEL_H
+
+#include "neuron_kernel.h"
+#include "module_math.h"
+
+#include <limits>
+#include <vector>
+
+namespace mynest
+{
+
+  /**
+   * Update of iaf_wsn_hermitian_1, see neuron_kernel.h. The wavelet
+   * integrals of all scales are restarted by clock spikes.
+   *
+   * The per-scale arrays Sigmas_, v_ and P2_ are accessed by index only,
+   * they must hold N_Sigmas_ entries before calibrate() and step().
+   */
+  struct WsnHermitian1Kernel
+  {
+    struct Parameters
+    {
+      double Tau_;         //!< Membrane time constant in ms
+      double C_;           //!< Membrane capacitance in pF
+      double V_reset_;
+      double Theta_;
+      double LowerBound_;
+      std::vector<double> Sigmas_;  //!< Wavelet scale factors
+      size_t N_Sigmas_;
+      double D_Int_;       //!< Wavelet convolution delay in ms
+      long math_accuracy_; //!< MathAccuracy of exp in Im()
+
+      Parameters()
+        : Tau_(30.0), C_(1.0), V_reset_(-10.0), Theta_(-1.0),
+          LowerBound_(-std::numeric_limits<double>::infinity()),
+          Sigmas_(), N_Sigmas_(0), D_Int_(0.0),
+          math_accuracy_(MATH_EXACT)
+      {}
+    };
+
+    struct State
+    {
+      double u_;               //!< Membrane voltage
+      std::vector<double> v_;  //!< Real-time v for all scales
+      double vb_;              //!< Buffered total v
+      double s_;               //!< S_enc synaptic current
+      double Ie_;              //!< Input current
+      double t_clk_;           //!< Last clock time
+      int    r_;               //!< Number of refractory steps remaining
+
+      State()
+        : u_(0.0), v_(), vb_(0.0), s_(0.0), Ie_(0.0),
+          t_clk_(-std::numeric_limits<double>::infinity()), r_(0)
+      {}
+    };
+
+    struct Variables
+    {
+      int    RefractoryCounts_;
+      std::vector<double> P2_;
+      double P32_;
+      double P33_;
+    };
+
+    /** Size the per-scale arrays of the structs above. */
+    static void resize(const Parameters& p, State& s, Variables& v)
+    {
+      s.v_.assign(p.N_Sigmas_, 0.0);
+      v.P2_.resize(p.N_Sigmas_);
+    }
+
+    template <class P, class V>
+    static void calibrate(const P& p, V& v, double h)
+    {
+      for ( size_t i = 0; i < p.N_Sigmas_; i++ )
+        v.P2_[i] = std::sqrt(2.0 * p.Sigmas_[i] / h) / std::pow(kernel_pi, 0.25);
+      v.P32_ = p.Tau_ / p.C_ * ( 1.0 -  std::exp(-h / p.Tau_) );
+      v.P33_ = std::exp(-h / p.Tau_);
+    }
+
+    /**
+     * Wavelet current of scale idx at time dt after the clock spike.
+     * @param A MathAccuracy of p.math_accuracy_, chosen by the caller.
+     */
+    template <int A, class P, class S, class V>
+    static double Im(const P& p, const S& s, const V& v, double dt, size_t idx)
+    {
+      const double ts = dt/p.Sigmas_[idx];
+      return v.P2_[idx] * ts * math::exp<A>(-ts*ts/2.0) * s.Ie_;
+    }
+
+    /**
+     * Step ending at time t in ms.
+     * @param A MathAccuracy of p.math_accuracy_, chosen by the caller
+     *          once for many steps.
+     * @param clock True if a clock spike arrives in this step.
+     */
+    template <int A, class P, class S, class V>
+    static bool step(const P& p, S& s, const V& v, double t, double h, bool clock)
+    {
+      if ( clock )
+      {
+        // Clock input, combine the scales and restart them
+        double vsum = 1.0;
+        if ( p.N_Sigmas_ > 1 )
+        {
+          vsum = 0.0;
+          for ( size_t i = 1; i < p.N_Sigmas_; ++i )
+          {
+            vsum += std::abs(s.v_[i]);
+            s.v_[i] = 0.0;
+          }
+          vsum = vsum/double(p.N_Sigmas_-1);
+        }
+        s.vb_ = std::sqrt(std::abs(s.v_[0])*vsum);
+        s.v_[0] = 0.0;
+        s.u_ = p.V_reset_;
+        s.s_ = 1.0;
+        s.t_clk_ = t;
+      }
+      const double Vm0 = s.u_;
+
+      if ( s.r_ == 0 )
+      {
+        // neuron not refractory
+        s.u_ = v.P32_ * s.s_ * s.vb_ + v.P33_ * s.u_;
+
+        //Simpson's method for v integration
+        const double dt = t - s.t_clk_ - p.D_Int_;
+        for ( size_t i = 0; i < p.N_Sigmas_; ++i )
+          s.v_[i] +=
+            (Im<A>(p, s, v, dt, i) + 4.0 * Im<A>(p, s, v, dt+h/2.0, i) + Im<A>(p, s, v, dt+h, i)) * h / 6.0;
+
+        s.s_ = v.P33_ * s.s_;
+
+        // lower bound of membrane potential
+        s.u_ = ( s.u_ < p.LowerBound_ ? p.LowerBound_ : s.u_);
+      }
+      else // neuron is absolute refractory
+        --s.r_;
+
+      if ( Vm0 < p.Theta_ && s.u_ >= p.Theta_)
+      {
+        s.r_  = v.RefractoryCounts_;
+        s.u_  = p.V_reset_;
+        s.s_  = 0.0;
+        s.vb_ = 0.0;
+        return true;
+      }
+      return false;
+    }
+
+    /**
+     * n steps from step first on, appends the steps k with a spike.
+     * @param clock Weight of clock spikes in each step, > 0.1 counts.
+     * @param current Input current read at the end of each step in pA.
+     */
+    static size_t run(const Parameters& p, State& s, const Variables& v, double h,
+                      long first, size_t n, const double* clock, const double* current,
+                      std::vector<size_t>& spikes)
+    {
+      switch ( p.math_accuracy_ )
+      {
+      case MATH_1E12: return run_<MATH_1E12>(p, s, v, h, first, n, clock, current, spikes);
+      case MATH_1E7:  return run_<MATH_1E7>(p, s, v, h, first, n, clock, current, spikes);
+      default:        return run_<MATH_EXACT>(p, s, v, h, first, n, clock, current, spikes);
+      }
+    }
+
+    template <int A>
+    static size_t run_(const Parameters& p, State& s, const Variables& v, double h,
+                       long first, size_t n, const double* clock, const double* current,
+                       std::vector<size_t>& spikes)
+    {
+      const size_t n0 = spikes.size();
+      for ( size_t k = 0; k < n; ++k )
+      {
+        if ( step<A>(p, s, v, (first + static_cast<long>(k) + 1) * h, h, clock[k] > 0.1) )
+          spikes.push_back(k);
+        s.Ie_ = current[k];
+      }
+      return spikes.size() - n0;
+    }
+  };
+
+} // namespace
+
+#endif /* #ifndef IAF_WSN_HERMITIAN_1_KERNEL_H */
@@ -22,6 +22,7 @@
 
 #include "exceptions.h"
 #include "iaf_wsn_hermitian_2.h"
+#include "iaf_wsn_hermitian_2_kernel.h"
 #include "network.h"
 #include "dict.h"
 #include "integerdatum.h"
@@ -33,6 +34,16 @@
 #include <limits>
 
 nest::RecordablesMap<mynest::iaf_wsn_hermitian_2> mynest::iaf_wsn_hermitian_2::recordablesMap_;
+
+#ifdef MYMODULE_PROFILE
+namespace
+{
+  const char* const profile_names[] =
+    { "steps", "refractory_steps", "get_Im_calls", "update_cycles" };
+}
+
+mynest::ProfileCounters mynest::iaf_wsn_hermitian_2::profile_(profile_names, 4);
+#endif
 using namespace nest;
 
 namespace nest
@@ -77,7 +88,9 @@ namespace mynest
       D_Int_     (  0.0   ),   // ms
       K_Ie_      (  1.0   ),   // no unit
       //num_of_receptors_ ( 2 ),
-      LowerBound_(-std::numeric_limits<double_t>::infinity())
+      LowerBound_(-std::numeric_limits<double_t>::infinity()),
+      clock_     (    0    ),
+      math_accuracy_( MATH_EXACT )
   {
       Sigmas_.clear();
   }
@@ -116,8 +129,10 @@ namespace mynest
     def<int>(d, "N_Sigmas", N_Sigmas_);
     //def<int>(d, "n_receptors", num_of_receptors_);
 
-    ArrayDatum Sigmas_ad(Sigmas_);
+    ArrayDatum Sigmas_ad(Sigmas_.to_vector());
     def<ArrayDatum>(d, "Sigmas", Sigmas_ad);
+    def<long>(d, "clock", clock_);
+    def<long>(d, "math_accuracy", math_accuracy_);
   }
 
   double mynest::iaf_wsn_hermitian_2::Parameters_::set(const DictionaryDatum& d)
@@ -135,6 +150,8 @@ namespace mynest
     updateValue<double>(d, names::C_m, C_);
     updateValue<double>(d, names::tau_m, Tau_);
     updateValue<double>(d, names::t_ref, TauR_);
+    updateValue<long>(d, "clock", clock_);
+    updateValue<long>(d, "math_accuracy", math_accuracy_);
 
     std::vector<double> sig_tmp;
     if(updateValue<std::vector<double> >(d, "Sigmas", sig_tmp))
@@ -163,6 +180,12 @@ namespace mynest
     if ( TauR_ < 0.0 )
     	throw BadProperty("The refractory time t_ref can't be negative.");
 
+    if ( clock_ < 0 )
+        throw BadProperty("clock must be the gid of a sensor_clock or 0.");
+
+    if ( !math::valid_accuracy(math_accuracy_) )
+        throw BadProperty("math_accuracy must be 0, 1 or 2.");
+
     return delta_EL;
   }
 
@@ -190,7 +213,7 @@ namespace mynest
    * ---------------------------------------------------------------- */
 
   mynest::iaf_wsn_hermitian_2::iaf_wsn_hermitian_2()
-    : Archiving_Node(),
+    : Archiving_Node_Ext(),
       P_(),
       S_(),
       B_(*this)
@@ -199,7 +222,7 @@ namespace mynest
   }
 
   mynest::iaf_wsn_hermitian_2::iaf_wsn_hermitian_2(const iaf_wsn_hermitian_2& n)
-    : Archiving_Node(n),
+    : Archiving_Node_Ext(n),
       P_(n.P_),
       S_(n.S_),
       B_(n.B_, *this)
@@ -222,13 +245,20 @@ namespace mynest
 
     B_.logger_.reset();
 
-    Archiving_Node::clear_history();
+    Archiving_Node_Ext::clear_history();
   }
 
   void mynest::iaf_wsn_hermitian_2::calibrate()
   {
     B_.logger_.init();  // ensures initialization in case mm connected after Simulate
 
+    switch ( P_.math_accuracy_ )
+    {
+    case MATH_1E12: V_.update_tier_ = &iaf_wsn_hermitian_2::update_<MATH_1E12>; break;
+    case MATH_1E7:  V_.update_tier_ = &iaf_wsn_hermitian_2::update_<MATH_1E7>; break;
+    default:        V_.update_tier_ = &iaf_wsn_hermitian_2::update_<MATH_EXACT>; break;
+    }
+
     const double h = Time::get_resolution().get_ms();
 
     //P_.receptor_types_.resize(P_.num_of_receptors_);
@@ -246,10 +276,7 @@ namespace mynest
     // these P are independent
     V_.P2_.clear();
     V_.P2_.resize(P_.N_Sigmas_);
-    for(size_t i=0;i<P_.N_Sigmas_;i++)
-        V_.P2_[i] = 2.0 / (std::sqrt(3.0 * P_.Sigmas_[i]/h) * std::pow(numerics::pi, 0.25));
-    V_.P32_ = P_.Tau_ / P_.C_ * ( 1.0 -  std::exp(-h / P_.Tau_) );
-    V_.P33_ = std::exp(-h / P_.Tau_);
+    WsnHermitian2Kernel::calibrate(P_, V_, h);
 
     // TauR specifies the length of the absolute refractory period as
     // a double_t in ms. The grid based iaf_wsn_hermitian_2 can only handle refractory
@@ -273,101 +300,50 @@ namespace mynest
 
     V_.RefractoryCounts_ = Time(Time::ms(P_.TauR_)).get_steps();
     assert(V_.RefractoryCounts_ >= 0);  // since t_ref_ >= 0, this can only fail in error
+
+    // clock ticks from the instance of the clock on this thread
+    V_.clock_ = 0;
+    if ( P_.clock_ > 0 )
+    {
+      V_.clock_ = dynamic_cast<sensor_clock*>(network()->get_node(P_.clock_, get_thread()));
+      if ( V_.clock_ == 0 )
+        throw BadProperty("clock must be the gid of a sensor_clock or 0.");
+    }
   }
 
   /* ----------------------------------------------------------------
    * Update and spike handling functions
    */
 
-  inline
-  double_t mynest::iaf_wsn_hermitian_2::get_Im_(const double_t dt, const size_t idx)
+  void mynest::iaf_wsn_hermitian_2::update(Time const & origin, const long_t from, const long_t to)
   {
-      double_t tt = dt*dt / (P_.Sigmas_[idx] * P_.Sigmas_[idx]);
-      return V_.P2_[idx] * (1.0-tt) * std::exp(-tt/2.0) * S_.Ie_;
+    (this->*V_.update_tier_)(origin, from, to);
   }
 
-  void mynest::iaf_wsn_hermitian_2::update(Time const & origin, const long_t from, const long_t to)
+  template <int A>
+  void mynest::iaf_wsn_hermitian_2::update_(Time const & origin, const long_t from, const long_t to)
   {
     assert(to >= 0 && (delay) from < Scheduler::get_min_delay());
     assert(from < to);
+    MYMODULE_PROFILE_START(prof_start);
 
-    double t,dt;
     const double h = Time::get_resolution().get_ms();
-    double Vm0;
 
     for ( long_t lag = from ; lag < to ; ++lag )
     {
-      t = Time(Time::step(origin.get_steps()+lag+1)).get_ms();
-      if(S_.t_clk_>0)
-          dt=t-S_.t_clk_;
-      else
-          dt=t;
-      if(B_.spikes_.get_value(lag) > 0.1)
-      {
-          // Clock input, reset v0_, v1_, s_, var_, ti_
-          double v0=std::abs(S_.v_[0]);
-          double vsum=0.0;
-          for(size_t i=0;i<P_.N_Sigmas_;++i)
-          {
-              vsum+=std::abs(S_.v_[i]);
-              S_.v_[i]=0.0;
-          }
-
-          //Calculate std
-          S_.Ivar_=S_.Ivar_/(dt-h);
-          S_.Imean_=S_.Ie_;
-          S_.Vth_Boost_=P_.K_Ie_ * std::sqrt(S_.Ivar_) + P_.Theta_;
-          //S_.vb_=vsum;
-          S_.vb_ = std::sqrt(vsum/double(P_.N_Sigmas_));
-          S_.u_ = P_.V_reset_;
-          S_.s_ = 1.0;
-          S_.t_clk_ = t;
-      }
-      else{
-        //Calculated running variance of Ie after three steps
-        if(dt/h>3.0){
-            double m_new = S_.Imean_ + (S_.Ie_-S_.Imean_)/dt;
-            S_.Ivar_=S_.Ivar_+(S_.Ie_-S_.Imean_)*(S_.Ie_-m_new);
-            S_.Imean_=m_new;
-        }
-      }
-      //S_.dt_=dt;
-
-      Vm0 = S_.u_;
+      const double t = Time(Time::step(origin.get_steps()+lag+1)).get_ms();
+      const bool clock = V_.clock_ != 0 ? V_.clock_->tick(origin, lag)
+                                        : B_.spikes_.get_value(lag) > 0.1;
 
+#ifdef MYMODULE_PROFILE
       if ( S_.r_ == 0 )
-      {
-        // neuron not refractory
-        S_.u_ = V_.P32_ * S_.s_ * S_.vb_ + V_.P33_ * S_.u_;
-
-        //Simpson's method for v integration
-        dt -= P_.D_Int_;
-        for(size_t i=0;i<P_.N_Sigmas_;++i)
-            S_.v_[i] +=
-                (get_Im_(dt,i) + 4.0 * get_Im_(dt+h/2.0,i) + get_Im_(dt+h,i)) * h / 6.0;
-
-        S_.s_ = V_.P33_ * S_.s_;
-
-
-        // lower bound of membrane potential
-        S_.u_ = ( S_.u_ < P_.LowerBound_ ? P_.LowerBound_ : S_.u_);
-
-      }
-      else // neuron is absolute refractory
-        --S_.r_;
-
+        MYMODULE_PROFILE_COUNT(profile_, get_thread(), PROF_CURRENT_CALLS, 3 * P_.N_Sigmas_);
+      else
+        MYMODULE_PROFILE_COUNT(profile_, get_thread(), PROF_REFRACTORY, 1);
+#endif
 
-      //if ( Vm0 < P_.Theta_ && S_.u_ >= P_.Theta_)
-      if ( Vm0 < S_.Vth_Boost_ && S_.u_ >= S_.Vth_Boost_)
+      if ( WsnHermitian2Kernel::step<A>(P_, S_, V_, t, h, clock) )
       {
-        S_.r_  = V_.RefractoryCounts_;
-        S_.u_  = P_.V_reset_;
-        S_.s_  = 0.0;
-        S_.vb_ = 0.0;
-        // A supra-threshold membrane potential should never be observable.
-        // The reset at the time of threshold crossing enables accurate integration
-        // independent of the computation step size, see [2,3] for details.
-
         set_spiketime(Time::step(origin.get_steps()+lag+1));
         SpikeEvent se;
         network()->send(*this, se, lag);
@@ -379,6 +355,9 @@ namespace mynest
       // log state data
       B_.logger_.record_data(origin.get_steps() + lag);
     }
+
+    MYMODULE_PROFILE_COUNT(profile_, get_thread(), PROF_STEPS, to - from);
+    MYMODULE_PROFILE_STOP(profile_, get_thread(), PROF_UPDATE_CYCLES, prof_start);
   }
 
   //port mynest::iaf_wsn_hermitian_2::connect_sender(SpikeEvent&, port receptor_type)
@@ -429,4 +408,48 @@ namespace mynest
     B_.logger_.handle(e);
   }
 
+  /* ----------------------------------------------------------------
+   * Checkpointing, see checkpoint.h
+   * ---------------------------------------------------------------- */
+
+  void mynest::iaf_wsn_hermitian_2::save_checkpoint(CheckpointWriter& w, bool with_buffers)
+  {
+    w.put(S_.u_);
+    w.put(S_.v_);
+    w.put(S_.vb_);
+    w.put(S_.Imean_);
+    w.put(S_.Ivar_);
+    w.put(S_.Vth_Boost_);
+    w.put(S_.s_);
+    w.put(S_.Ie_);
+    w.put(S_.t_clk_);
+    w.put(S_.r_);
+
+    if ( with_buffers )
+    {
+      w.put(B_.spikes_);
+      w.put(B_.currents_);
+    }
+  }
+
+  void mynest::iaf_wsn_hermitian_2::load_checkpoint(CheckpointReader& r, bool with_buffers)
+  {
+    r.get(S_.u_);
+    r.get(S_.v_);
+    r.get(S_.vb_);
+    r.get(S_.Imean_);
+    r.get(S_.Ivar_);
+    r.get(S_.Vth_Boost_);
+    r.get(S_.s_);
+    r.get(S_.Ie_);
+    r.get(S_.t_clk_);
+    r.get(S_.r_);
+
+    if ( with_buffers )
+    {
+      r.get(B_.spikes_);
+      r.get(B_.currents_);
+    }
+  }
+
 } // namespace
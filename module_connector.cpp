@@ -0,0 +1,241 @@
+/*
+ *  module_connector.cpp
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "module_connector.h"
+#include "exceptions.h"
+#include "nestmodule.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdint.h>
+
+namespace mynest
+{
+
+  std::vector<ModuleConnectorBase*> ModuleConnectorBase::registry_;
+
+  ModuleConnectorBase::ModuleConnectorBase(const ConnectorModel& cm)
+    : source_gid_(0),
+      syn_id_(getValue<long>(cm.network().get_synapsedict().lookup(cm.get_name())))
+  {
+#ifdef _OPENMP
+#pragma omp critical(mynest_module_connector_registry)
+#endif
+    registry_.push_back(this);
+  }
+
+  ModuleConnectorBase::~ModuleConnectorBase()
+  {
+#ifdef _OPENMP
+#pragma omp critical(mynest_module_connector_registry)
+#endif
+    {
+      std::vector<ModuleConnectorBase*>::iterator it =
+        std::find(registry_.begin(), registry_.end(), this);
+      if ( it != registry_.end() )
+        registry_.erase(it);
+    }
+  }
+
+  /* ----------------------------------------------------------------
+   * Bulk access to the connections of a synapse model
+   * ---------------------------------------------------------------- */
+
+  namespace
+  {
+    // tag at the start of column files, includes a format version
+    const char columns_tag[8] = { 'M', 'Y', 'S', 'Y', 'N', 'C', 'O', '1' };
+
+    size_t count_connections(synindex syn_id)
+    {
+      const std::vector<ModuleConnectorBase*>& reg = ModuleConnectorBase::get_registry();
+      size_t n = 0;
+      for ( size_t k = 0; k < reg.size(); ++k )
+        if ( reg[k]->get_syn_id() == syn_id )
+          n += reg[k]->n_connections();
+      return n;
+    }
+  }
+
+  void get_synapse_columns(synindex syn_id, SynapseColumns& c)
+  {
+    const std::vector<ModuleConnectorBase*>& reg = ModuleConnectorBase::get_registry();
+
+    // allocate once, then let each connector fill its rows
+    c.resize(count_connections(syn_id));
+
+    size_t row = 0;
+    for ( size_t k = 0; k < reg.size(); ++k )
+      if ( reg[k]->get_syn_id() == syn_id )
+      {
+        reg[k]->get_columns(c, row);
+        row += reg[k]->n_connections();
+      }
+  }
+
+  void set_synapse_columns(synindex syn_id, const SynapseColumns& c)
+  {
+    const std::vector<ModuleConnectorBase*>& reg = ModuleConnectorBase::get_registry();
+
+    if ( c.source.size() != c.size() || c.target.size() != c.size()
+         || c.trace.size() != c.size() )
+      throw BadProperty("All synapse columns must have the same length.");
+
+    if ( c.size() != count_connections(syn_id) )
+      throw BadProperty("Number of rows does not match the number of connections.");
+
+    // check all rows before changing anything
+    size_t row = 0;
+    for ( size_t k = 0; k < reg.size(); ++k )
+      if ( reg[k]->get_syn_id() == syn_id )
+      {
+        if ( !reg[k]->match_columns(c, row) )
+          throw BadProperty("Sources and targets do not match the connections.");
+        row += reg[k]->n_connections();
+      }
+
+    row = 0;
+    for ( size_t k = 0; k < reg.size(); ++k )
+      if ( reg[k]->get_syn_id() == syn_id )
+      {
+        reg[k]->set_columns(c, row);
+        row += reg[k]->n_connections();
+      }
+  }
+
+  void save_synapse_columns(synindex syn_id, const std::string& filename)
+  {
+    SynapseColumns c;
+    get_synapse_columns(syn_id, c);
+
+    std::ofstream out(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if ( !out )
+      throw IOError("Could not open " + filename + " for writing.");
+
+    const int64_t n = c.size();
+    out.write(columns_tag, sizeof(columns_tag));
+    out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+
+    // each column is stored contiguously, so a reader can map it directly
+    if ( n > 0 )
+    {
+      std::vector<int64_t> ids(n);
+      std::copy(c.source.begin(), c.source.end(), ids.begin());
+      out.write(reinterpret_cast<const char*>(&ids[0]), n * sizeof(int64_t));
+      std::copy(c.target.begin(), c.target.end(), ids.begin());
+      out.write(reinterpret_cast<const char*>(&ids[0]), n * sizeof(int64_t));
+      out.write(reinterpret_cast<const char*>(&c.weight[0]), n * sizeof(double));
+      out.write(reinterpret_cast<const char*>(&c.trace[0]), n * sizeof(double));
+    }
+
+    if ( !out )
+      throw IOError("Could not write " + filename + ".");
+  }
+
+  void load_synapse_columns(synindex syn_id, const std::string& filename)
+  {
+    std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary);
+    if ( !in )
+      throw IOError("Could not open " + filename + " for reading.");
+
+    char tag[sizeof(columns_tag)];
+    int64_t n = 0;
+    in.read(tag, sizeof(tag));
+    in.read(reinterpret_cast<char*>(&n), sizeof(n));
+    if ( !in || std::memcmp(tag, columns_tag, sizeof(tag)) != 0 || n < 0 )
+      throw IOError(filename + " is not a synapse column file.");
+
+    SynapseColumns c;
+    c.resize(n);
+
+    if ( n > 0 )
+    {
+      std::vector<int64_t> ids(n);
+      in.read(reinterpret_cast<char*>(&ids[0]), n * sizeof(int64_t));
+      std::copy(ids.begin(), ids.end(), c.source.begin());
+      in.read(reinterpret_cast<char*>(&ids[0]), n * sizeof(int64_t));
+      std::copy(ids.begin(), ids.end(), c.target.begin());
+      in.read(reinterpret_cast<char*>(&c.weight[0]), n * sizeof(double));
+      in.read(reinterpret_cast<char*>(&c.trace[0]), n * sizeof(double));
+
+      if ( !in )
+        throw IOError(filename + " is truncated.");
+    }
+
+    set_synapse_columns(syn_id, c);
+  }
+
+  size_t freeze_synapses(synindex syn_id)
+  {
+    const std::vector<ModuleConnectorBase*>& reg = ModuleConnectorBase::get_registry();
+
+    size_t n = 0;
+    for ( size_t k = 0; k < reg.size(); ++k )
+      if ( reg[k]->get_syn_id() == syn_id )
+        n += reg[k]->freeze();
+    return n;
+  }
+
+  size_t prune_synapses(synindex syn_id, double_t time)
+  {
+    if ( time < 0.0 )
+      throw BadProperty("The silent time must not be negative.");
+
+    const std::vector<ModuleConnectorBase*>& reg = ModuleConnectorBase::get_registry();
+    const double_t t_before = nest::NestModule::get_network().get_time().get_ms() - time;
+
+    size_t n = 0;
+    for ( size_t k = 0; k < reg.size(); ++k )
+      if ( reg[k]->get_syn_id() == syn_id )
+        n += reg[k]->prune(t_before);
+    return n;
+  }
+
+  void normalize_synapses(synindex syn_id, double_t norm, int order)
+  {
+    if ( order != 1 && order != 2 )
+      throw BadProperty("The order of the norm must be 1 or 2.");
+    if ( norm < 0.0 )
+      throw BadProperty("The norm must not be negative.");
+
+    const std::vector<ModuleConnectorBase*>& reg = ModuleConnectorBase::get_registry();
+
+    // one entry per gid, targets are found by index instead of a lookup
+    std::vector<double_t> scale(nest::NestModule::get_network().size(), 0.0);
+    for ( size_t k = 0; k < reg.size(); ++k )
+      if ( reg[k]->get_syn_id() == syn_id )
+        reg[k]->add_norms(scale, order);
+
+    for ( size_t g = 0; g < scale.size(); ++g )
+    {
+      const double_t current = order == 1 ? scale[g] : std::sqrt(scale[g]);
+      scale[g] = current > 0.0 ? norm / current : 1.0;
+    }
+
+    for ( size_t k = 0; k < reg.size(); ++k )
+      if ( reg[k]->get_syn_id() == syn_id )
+        reg[k]->scale_weights(scale);
+  }
+
+} // namespace
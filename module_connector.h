@@ -0,0 +1,356 @@
+/*
+ *  module_connector.h
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MODULE_CONNECTOR_H
+#define MODULE_CONNECTOR_H
+
+#include "nest.h"
+#include "node.h"
+#include "network.h"
+#include "generic_connector.h"
+#include "generic_connector_model.h"
+#include "common_synapse_properties.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+/* BeginDocumentation
+  Name: GetSynapseColumns - Read the plastic state of all connections of a
+   synapse model into typed arrays.
+
+  Synopsis:
+   /synapse_model GetSynapseColumns -> dict
+   /synapse_model dict SetSynapseColumns -> -
+   /synapse_model (filename) SaveSynapseColumns -> -
+   /synapse_model (filename) LoadSynapseColumns -> -
+   /synapse_model FreezeSynapses -> n
+   /synapse_model time PruneSynapses -> n
+   /synapse_model norm order NormalizeSynapses -> -
+
+  Description:
+   The plastic synapses of this module (stdp_synapse_ext, stdp_synapse_alpha,
+   stdp_synapse_multi and their copies) keep track of their connectors, so
+   that the state of all local connections of a synapse model can be read
+   and written in one pass, without building a dictionary per connection.
+
+   GetSynapseColumns returns a dictionary with the columns source, target
+   (int vectors), weight and trace (double vectors), one entry per local
+   connection. trace is the presynaptic trace Kplus of stdp_synapse_ext and
+   zero for the synapses without trace.
+
+   SetSynapseColumns writes weight and trace back. The rows must be given in
+   the order returned by GetSynapseColumns, source and target are checked
+   against the network and nothing is changed if they differ.
+
+   SaveSynapseColumns and LoadSynapseColumns do the same with a binary file.
+   The file holds an 8 byte tag, the number of rows n as 64 bit integer and
+   the columns source, target (64 bit integers), weight and trace (doubles),
+   each stored contiguously, so each column can be memory-mapped directly.
+
+   FreezeSynapses ends learning of all local connections of the synapse
+   model and returns the number of connections frozen. A frozen connection
+   only transmits with its current weight and delay, it no longer reads
+   the spike history of its target. The target stops keeping the history
+   for it, and once all its plastic inputs are frozen it keeps no history
+   at all. Only connections to neurons of this module are frozen, the
+   others stay plastic. Freezing cannot be undone, the parameter frozen of
+   a connection tells whether it is frozen. Use it after training, the
+   connections keep their size.
+
+   PruneSynapses removes the local connections of stdp_synapse_alpha and
+   stdp_synapse_multi whose weight has been at or below their parameter
+   Wprune for at least time ms, and returns the number removed. A
+   connection becomes silent when a presynaptic spike leaves its weight at
+   or below Wprune, SetStatus on it restarts the count. The connectors are
+   compacted and their memory is returned. Call it between Simulate calls
+   to prune periodically. Connection ids obtained before are invalid
+   afterwards. As with FreezeSynapses, connections to neurons of other
+   modules are kept.
+
+   NormalizeSynapses scales the weights of the local connections of the
+   synapse model so that the weights onto each target have the L1 (order
+   1) or L2 (order 2) norm norm. The scaled weights are clipped to Wmax of
+   their connection, so the norm of a target can end up below norm.
+   Targets whose weights are all zero are left alone. In NEST all
+   connections onto a neuron are local to the process of the neuron, so
+   the norm covers all of them.
+
+  Remarks:
+   Only connections local to the calling process are visited. With MPI,
+   give each process its own file name.
+
+  Author: Zhenzhong Wang
+  SeeAlso: GetConnections, GetStatus, SetStatus
+*/
+
+using namespace nest;
+
+namespace mynest
+{
+
+  /**
+   * Plastic state of a set of connections, one row per connection.
+   */
+  struct SynapseColumns
+  {
+    std::vector<long>   source;
+    std::vector<long>   target;
+    std::vector<double> weight;
+    std::vector<double> trace;
+
+    size_t size() const { return weight.size(); }
+
+    void resize(size_t n)
+    {
+      source.resize(n);
+      target.resize(n);
+      weight.resize(n);
+      trace.resize(n);
+    }
+  };
+
+  /**
+   * Non-template interface of ModuleConnector.
+   *
+   * All module connectors are listed in one registry in order of creation.
+   * Module-level operations use it to visit the connections of a synapse
+   * model without going through the connection dictionaries. Connectors
+   * are told apart by the id of their synapse model, which is looked up
+   * once when the connector is created.
+   */
+  class ModuleConnectorBase
+  {
+  public:
+
+    ModuleConnectorBase(const ConnectorModel& cm);
+    virtual ~ModuleConnectorBase();
+
+    /** Id of the synapse model of all connections in this connector. */
+    synindex get_syn_id() const { return syn_id_; }
+
+    index get_source_gid() const { return source_gid_; }
+
+    virtual size_t n_connections() const = 0;
+
+    /** Write the state of all connections into rows row, row+1, ... of c. */
+    virtual void get_columns(SynapseColumns& c, size_t row) const = 0;
+
+    /** True if source and target of the rows starting at row match. */
+    virtual bool match_columns(const SynapseColumns& c, size_t row) const = 0;
+
+    /** Set the state of all connections from the rows starting at row. */
+    virtual void set_columns(const SynapseColumns& c, size_t row) = 0;
+
+    /** Freeze all connections, returns the number frozen. */
+    virtual size_t freeze() = 0;
+
+    /**
+     * Remove the connections silent since t_before or earlier, returns the
+     * number removed.
+     */
+    virtual size_t prune(double_t t_before) = 0;
+
+    /**
+     * Add |w| (order 1) or w^2 (order 2) of each connection to
+     * norms[target gid].
+     */
+    virtual void add_norms(std::vector<double_t>& norms, int order) const = 0;
+
+    /** Multiply each weight by scale[target gid] and clip it to Wmax. */
+    virtual void scale_weights(const std::vector<double_t>& scale) = 0;
+
+    static const std::vector<ModuleConnectorBase*>& get_registry() { return registry_; }
+
+  protected:
+
+    index source_gid_;
+
+  private:
+
+    synindex syn_id_;
+
+    static std::vector<ModuleConnectorBase*> registry_;
+  };
+
+  /**
+   * GenericConnector that registers itself with ModuleConnectorBase.
+   *
+   * ConnectionT must provide get_trace(), set_trace(), apply_deferred(),
+   * freeze(), prune(), restart_silent() and get_wmax() in addition to the
+   * usual connection interface.
+   */
+  template <typename ConnectionT>
+  class ModuleConnector :
+    public GenericConnector<ConnectionT, CommonSynapseProperties,
+             GenericConnectorModel<ConnectionT, CommonSynapseProperties, ModuleConnector<ConnectionT> > >,
+    public ModuleConnectorBase
+  {
+  public:
+
+    typedef GenericConnectorModel<ConnectionT, CommonSynapseProperties, ModuleConnector<ConnectionT> > ModelT;
+    typedef GenericConnector<ConnectionT, CommonSynapseProperties, ModelT> BaseT;
+
+    ModuleConnector(ModelT& cm)
+      : BaseT(cm),
+        ModuleConnectorBase(cm)
+    {}
+
+    /**
+     * Connections are registered with the connector of their source, so
+     * the source gid is taken from the first registration.
+     */
+    void register_connection(Node& s, Node& r)
+    {
+      BaseT::register_connection(s, r);
+      source_gid_ = s.get_gid();
+    }
+
+    void register_connection(Node& s, Node& r, double_t w, double_t d)
+    {
+      BaseT::register_connection(s, r, w, d);
+      source_gid_ = s.get_gid();
+    }
+
+    void register_connection(Node& s, Node& r, DictionaryDatum& d)
+    {
+      BaseT::register_connection(s, r, d);
+      source_gid_ = s.get_gid();
+    }
+
+    size_t n_connections() const
+    {
+      return this->connections_.size();
+    }
+
+    void get_columns(SynapseColumns& c, size_t row) const
+    {
+      for ( size_t i = 0; i < this->connections_.size(); ++i, ++row )
+      {
+        const ConnectionT& conn = this->connections_[i];
+        conn.apply_deferred();
+        c.source[row] = source_gid_;
+        c.target[row] = conn.get_target()->get_gid();
+        c.weight[row] = conn.get_weight();
+        c.trace[row]  = conn.get_trace();
+      }
+    }
+
+    bool match_columns(const SynapseColumns& c, size_t row) const
+    {
+      for ( size_t i = 0; i < this->connections_.size(); ++i, ++row )
+        if ( c.source[row] != static_cast<long>(source_gid_)
+             || c.target[row] != static_cast<long>(this->connections_[i].get_target()->get_gid()) )
+          return false;
+      return true;
+    }
+
+    void set_columns(const SynapseColumns& c, size_t row)
+    {
+      for ( size_t i = 0; i < this->connections_.size(); ++i, ++row )
+      {
+        ConnectionT& conn = this->connections_[i];
+        conn.apply_deferred();
+        conn.set_weight(c.weight[row]);
+        conn.set_trace(c.trace[row]);
+        conn.restart_silent();
+      }
+    }
+
+    size_t freeze()
+    {
+      size_t n = 0;
+      for ( size_t i = 0; i < this->connections_.size(); ++i )
+        if ( this->connections_[i].freeze(this->t_lastspike_) )
+          ++n;
+      return n;
+    }
+
+    size_t prune(double_t t_before)
+    {
+      std::vector<ConnectionT>& c = this->connections_;
+
+      // keep the order of the remaining connections
+      size_t j = 0;
+      for ( size_t i = 0; i < c.size(); ++i )
+        if ( !c[i].prune(t_before, this->t_lastspike_) )
+        {
+          if ( j != i )
+            c[j] = c[i];
+          ++j;
+        }
+
+      const size_t n = c.size() - j;
+      if ( n > 0 )
+        std::vector<ConnectionT>(c.begin(), c.begin() + j).swap(c);
+      return n;
+    }
+
+    void add_norms(std::vector<double_t>& norms, int order) const
+    {
+      for ( size_t i = 0; i < this->connections_.size(); ++i )
+      {
+        const ConnectionT& conn = this->connections_[i];
+        conn.apply_deferred();
+        const double_t w = conn.get_weight();
+        norms[conn.get_target()->get_gid()] += order == 1 ? std::fabs(w) : w * w;
+      }
+    }
+
+    void scale_weights(const std::vector<double_t>& scale)
+    {
+      for ( size_t i = 0; i < this->connections_.size(); ++i )
+      {
+        ConnectionT& conn = this->connections_[i];
+        const double_t w = conn.get_weight() * scale[conn.get_target()->get_gid()];
+        const double_t wmax = conn.get_wmax();
+        conn.set_weight(w > wmax ? wmax : (w < -wmax ? -wmax : w));
+        conn.restart_silent();
+      }
+    }
+  };
+
+  /**
+   * Register a synapse type whose connectors are ModuleConnectors.
+   * Use instead of nest::register_prototype_connection().
+   */
+  template <class ConnectionT>
+  synindex register_module_connection(Network& net, const std::string& name)
+  {
+    ConnectorModel* prototype =
+      new typename ModuleConnector<ConnectionT>::ModelT(net, name);
+    return net.register_synapse_prototype(prototype);
+  }
+
+  // Bulk access to the connections of a synapse model, see documentation.
+
+  void get_synapse_columns(synindex syn_id, SynapseColumns& c);
+  void set_synapse_columns(synindex syn_id, const SynapseColumns& c);
+  void save_synapse_columns(synindex syn_id, const std::string& filename);
+  void load_synapse_columns(synindex syn_id, const std::string& filename);
+  size_t freeze_synapses(synindex syn_id);
+  size_t prune_synapses(synindex syn_id, double_t time);
+  void normalize_synapses(synindex syn_id, double_t norm, int order);
+
+} // namespace
+
+#endif /* #ifndef MODULE_CONNECTOR_H */
@@ -0,0 +1,173 @@
+/*
+ *  module_math.h
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef MODULE_MATH_H
+#define MODULE_MATH_H
+
+/*
+ * exp, log and pow of the module in three accuracy tiers.
+ *
+ * The models call exp and pow per step or per spike. Where the parameter
+ * math_accuracy of a model allows it, they use the functions below, which
+ * are inline and have no table. The tier is a template argument: neurons
+ * choose the instance of update() in calibrate(), synapses once per spike
+ * in send(), so no loop branches on math_accuracy. The range checks keep
+ * the loops from being vectorized.
+ *
+ *   MATH_EXACT  0   std::exp, std::log, std::pow
+ *   MATH_1E12   1   relative error below 1e-12
+ *   MATH_1E7    2   relative error below 1e-7
+ *
+ * exp reduces x = k ln2 + r with |r| <= ln2/2 and sums the Taylor series
+ * of exp(r), 11 terms for MATH_1E12 and 7 for MATH_1E7. log reduces
+ * x = 2^e m with m in [sqrt(1/2), sqrt(2)) and sums the series of
+ * 2 atanh((m-1)/(m+1)). Arguments where the result over- or underflows,
+ * as well as infinities and NaN, are passed on to the std functions.
+ *
+ * pow(x, y) is exp(y log(x)) for x > 0; the error of log is multiplied by
+ * |y log(x)|, so pow only keeps the tier for moderate results. Callers
+ * that take powers of a fixed base compute its log once with std::log and
+ * call exp.
+ *
+ * The tiers gain from fused multiply-add. bench/math_bench.cpp measures
+ * the time and error of each tier, alone and in the models: built with
+ * -O2 the tiers are slower than std (exp 13 and 10 ns against 8 ns),
+ * with -O2 -march=native faster (exp 4.4 and 3.5 ns against 5.6 ns).
+ * Keep MATH_EXACT unless the module is built for such a target.
+ *
+ * Like the kernels, this header only needs the standard library.
+ */
+
+#include <cmath>
+#include <stdint.h>
+
+namespace mynest
+{
+
+  /** Accuracy tiers, the values of the parameter math_accuracy. */
+  enum MathAccuracy { MATH_EXACT = 0, MATH_1E12 = 1, MATH_1E7 = 2 };
+
+  namespace math
+  {
+
+    const double log2e  = 1.44269504088896338700e+00;
+    const double ln2_hi = 6.93147180369123816490e-01;  //!< ln2 with 32 bits
+    const double ln2_lo = 1.90821492927058770002e-10;  //!< ln2 - ln2_hi
+    const double sqrt2  = 1.41421356237309504880e+00;
+
+    /** True if a is a valid math_accuracy. */
+    inline
+    bool valid_accuracy(long a)
+    {
+      return a >= MATH_EXACT && a <= MATH_1E7;
+    }
+
+    /**
+     * Bits of a double. Not std::memcpy: <cstring> declares ::index on
+     * some systems, which clashes with nest::index in the models.
+     */
+    union Bits_
+    {
+      double d;
+      int64_t i;
+    };
+
+    /** 2^k for -1022 <= k <= 1023, built from the bits. */
+    inline
+    double pow2_(int64_t k)
+    {
+      Bits_ b;
+      b.i = (k + 1023) << 52;
+      return b.d;
+    }
+
+    template <int A>
+    inline
+    double exp(double x)
+    {
+      if ( A == MATH_EXACT || !(x > -708.0 && x < 709.0) )
+        return std::exp(x);
+
+      const double k = std::floor(x * log2e + 0.5);
+      const double r = (x - k * ln2_hi) - k * ln2_lo;
+
+      double p;
+      if ( A == MATH_1E12 )
+        p = 1.0 + r * (1.0 + r * (1.0/2 + r * (1.0/6 + r * (1.0/24 + r * (1.0/120
+              + r * (1.0/720 + r * (1.0/5040 + r * (1.0/40320 + r * (1.0/362880
+              + r * (1.0/3628800 + r * (1.0/39916800)))))))))));
+      else
+        p = 1.0 + r * (1.0 + r * (1.0/2 + r * (1.0/6 + r * (1.0/24 + r * (1.0/120
+              + r * (1.0/720 + r * (1.0/5040)))))));
+
+      return p * pow2_(static_cast<int64_t>(k));
+    }
+
+    template <int A>
+    inline
+    double log(double x)
+    {
+      // zero, negative, subnormal, infinite and NaN arguments
+      if ( A == MATH_EXACT || !(x >= 2.2250738585072014e-308 && x <= 1.7976931348623157e+308) )
+        return std::log(x);
+
+      Bits_ b;
+      b.d = x;
+      int64_t e = ((b.i >> 52) & 0x7ff) - 1023;
+      const int64_t mantissa = (static_cast<int64_t>(1) << 52) - 1;
+      b.i = (b.i & mantissa) | (static_cast<int64_t>(1023) << 52);
+      double m = b.d;
+      if ( m >= sqrt2 )
+      {
+        m *= 0.5;
+        ++e;
+      }
+
+      const double s = (m - 1.0) / (m + 1.0);
+      const double s2 = s * s;
+
+      double q;
+      if ( A == MATH_1E12 )
+        q = 1.0 + s2 * (1.0/3 + s2 * (1.0/5 + s2 * (1.0/7 + s2 * (1.0/9 + s2 * (1.0/11
+              + s2 * (1.0/13 + s2 * (1.0/15)))))));
+      else
+        q = 1.0 + s2 * (1.0/3 + s2 * (1.0/5 + s2 * (1.0/7 + s2 * (1.0/9))));
+
+      const double de = static_cast<double>(e);
+      return de * ln2_hi + (2.0 * s * q + de * ln2_lo);
+    }
+
+    /** x^y, see above for x <= 0 and the error. */
+    template <int A>
+    inline
+    double pow(double x, double y)
+    {
+      if ( A == MATH_EXACT || !(x > 0.0) )
+        return std::pow(x, y);
+      return exp<A>(y * log<A>(x));
+    }
+
+  } // namespace math
+
+} // namespace
+
+#endif /* #ifndef MODULE_MATH_H */
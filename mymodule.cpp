@@ -33,9 +33,15 @@
 #include "exceptions.h"
 #include "sliexceptions.h"
 #include "nestmodule.h"
+#include "dictutils.h"
+#include "intvectordatum.h"
+#include "doublevectordatum.h"
 
 // include headers with your own stuff
 #include "mymodule.h"
+#include "module_connector.h"
+#include "checkpoint.h"
+#include "drop_odd_spike_connection.h"
 #include "stdp_connection_ext.h"
 #include "stdp_connection_alpha.h"
 #include "stdp_connection_multi.h"
@@ -44,9 +50,15 @@
 #include "glif_psc_alpha_multi.h"
 #include "iaf_freq_sensor.h"
 #include "iaf_freq_sensor_v2.h"
+#include "iaf_freq_sensor_v2_ps.h"
+#include "freq_sensor_bank.h"
+#include "freq_sensor_v2_sweep.h"
 #include "iaf_wsn_hermitian_1.h"
 #include "iaf_wsn_hermitian_2.h"
 #include "iaf_wsn_alpha.h"
+#include "trace_current_generator.h"
+#include "binary_spike_recorder.h"
+#include "sensor_clock.h"
 
 // -- Interface to dynamic module loader ---------------------------------------
 
@@ -110,25 +122,40 @@ mynest::MyModule::~MyModule()
                                         "iaf_freq_sensor");
     nest::register_model<iaf_freq_sensor_v2>(nest::NestModule::get_network(),
                                         "iaf_freq_sensor_v2");
+    nest::register_model<iaf_freq_sensor_v2_ps>(nest::NestModule::get_network(),
+                                        "iaf_freq_sensor_v2_ps");
+    nest::register_model<freq_sensor_bank>(nest::NestModule::get_network(),
+                                        "freq_sensor_bank");
+    nest::register_model<freq_sensor_v2_sweep>(nest::NestModule::get_network(),
+                                        "freq_sensor_v2_sweep");
     nest::register_model<iaf_wsn_hermitian_2>(nest::NestModule::get_network(),
                                         "wsn_hermitian_2");
     nest::register_model<iaf_wsn_hermitian_1>(nest::NestModule::get_network(),
                                         "wsn_hermitian_1");
     nest::register_model<iaf_wsn_alpha>(nest::NestModule::get_network(),
                                         "wsn_alpha");
+    nest::register_model<trace_current_generator>(nest::NestModule::get_network(),
+                                        "trace_current_generator");
+    nest::register_model<binary_spike_recorder>(nest::NestModule::get_network(),
+                                        "binary_spike_recorder");
+    nest::register_model<sensor_clock>(nest::NestModule::get_network(),
+                                        "sensor_clock");
 
 
     /* Register a synapse type.
        Give synapse type as template argument and the name as second argument.
        The first argument is always a reference to the network.
     */
-    //nest::register_prototype_connection<DropOddSpikeConnection>(nest::NestModule::get_network(),
-                                                       //"drop_odd_synapse");
-    nest::register_prototype_connection<STDPConnectionExt>(nest::NestModule::get_network(),
+    nest::register_prototype_connection<DropOddSpikeConnection>(nest::NestModule::get_network(),
+                                                       "drop_odd_synapse");
+    nest::register_prototype_connection<FilterConnection<EveryNthPolicy> >(nest::NestModule::get_network(),
+                                                       "every_nth_synapse");
+    register_bernoulli_connection(nest::NestModule::get_network(), "bernoulli_synapse");
+    register_module_connection<STDPConnectionExt>(nest::NestModule::get_network(),
         "stdp_synapse_ext");
-    nest::register_prototype_connection<STDPConnectionAlpha>(nest::NestModule::get_network(),
+    register_module_connection<STDPConnectionAlpha>(nest::NestModule::get_network(),
             "stdp_synapse_alpha");
-    nest::register_prototype_connection<STDPConnectionMulti>(nest::NestModule::get_network(),
+    register_module_connection<STDPConnectionMulti>(nest::NestModule::get_network(),
             "stdp_synapse_multi");
 
     /* Register a SLI function.
@@ -139,6 +166,15 @@ mynest::MyModule::~MyModule()
     */
     //i->createcommand("StepPatternConnect_Vi_i_Vi_i_l",
                      //&stepPatternConnect_Vi_i_Vi_i_lFunction);
+    i->createcommand("GetSynapseColumns_l", &getSynapseColumns_lFunction);
+    i->createcommand("SetSynapseColumns_l_D", &setSynapseColumns_l_DFunction);
+    i->createcommand("SaveSynapseColumns_l_s", &saveSynapseColumns_l_sFunction);
+    i->createcommand("LoadSynapseColumns_l_s", &loadSynapseColumns_l_sFunction);
+    i->createcommand("FreezeSynapses_l", &freezeSynapses_lFunction);
+    i->createcommand("PruneSynapses_l_d", &pruneSynapses_l_dFunction);
+    i->createcommand("NormalizeSynapses_l_d_i", &normalizeSynapses_l_d_iFunction);
+    i->createcommand("SaveCheckpoint_s_b", &saveCheckpoint_s_bFunction);
+    i->createcommand("LoadCheckpoint_s", &loadCheckpoint_sFunction);
 
     /* Register a Topography connection kernel function
      *
@@ -147,4 +183,141 @@ mynest::MyModule::~MyModule()
 
   }  // MyModule::init()
 
+  //-------------------------------------------------------------------------------------
+
+  namespace
+  {
+    // id of the synapse model named on the stack
+    nest::synindex get_synapse_id_(SLIInterpreter *i, size_t depth)
+    {
+      const std::string synmodel = getValue<std::string>(i->OStack.pick(depth));
+      const Dictionary& synapsedict = nest::NestModule::get_network().get_synapsedict();
+      if ( !synapsedict.known(synmodel) )
+        throw nest::UnknownSynapseType(synmodel);
+      return getValue<long>(synapsedict.lookup(synmodel));
+    }
+  }
+
+  void mynest::MyModule::GetSynapseColumns_lFunction::execute(SLIInterpreter *i) const
+  {
+    i->assert_stack_load(1);
+
+    SynapseColumns c;
+    get_synapse_columns(get_synapse_id_(i, 0), c);
+
+    // the datums take over the columns, swapped rather than copied
+    std::vector<long>* source = new std::vector<long>;
+    std::vector<long>* target = new std::vector<long>;
+    std::vector<double>* weight = new std::vector<double>;
+    std::vector<double>* trace = new std::vector<double>;
+    source->swap(c.source);
+    target->swap(c.target);
+    weight->swap(c.weight);
+    trace->swap(c.trace);
+
+    DictionaryDatum d(new Dictionary);
+    (*d)[nest::names::source] = IntVectorDatum(source);
+    (*d)[nest::names::target] = IntVectorDatum(target);
+    (*d)[nest::names::weight] = DoubleVectorDatum(weight);
+    (*d)["trace"] = DoubleVectorDatum(trace);
+
+    i->OStack.pop(1);
+    i->OStack.push(d);
+    i->EStack.pop();
+  }
+
+  void mynest::MyModule::SetSynapseColumns_l_DFunction::execute(SLIInterpreter *i) const
+  {
+    i->assert_stack_load(2);
+
+    const nest::synindex syn_id = get_synapse_id_(i, 1);
+    DictionaryDatum d = getValue<DictionaryDatum>(i->OStack.pick(0));
+
+    SynapseColumns c;
+    c.source = getValue<std::vector<long> >(d, nest::names::source);
+    c.target = getValue<std::vector<long> >(d, nest::names::target);
+    c.weight = getValue<std::vector<double> >(d, nest::names::weight);
+    c.trace  = getValue<std::vector<double> >(d, "trace");
+    set_synapse_columns(syn_id, c);
+
+    i->OStack.pop(2);
+    i->EStack.pop();
+  }
+
+  void mynest::MyModule::SaveSynapseColumns_l_sFunction::execute(SLIInterpreter *i) const
+  {
+    i->assert_stack_load(2);
+
+    save_synapse_columns(get_synapse_id_(i, 1),
+                         getValue<std::string>(i->OStack.pick(0)));
+
+    i->OStack.pop(2);
+    i->EStack.pop();
+  }
+
+  void mynest::MyModule::LoadSynapseColumns_l_sFunction::execute(SLIInterpreter *i) const
+  {
+    i->assert_stack_load(2);
+
+    load_synapse_columns(get_synapse_id_(i, 1),
+                         getValue<std::string>(i->OStack.pick(0)));
+
+    i->OStack.pop(2);
+    i->EStack.pop();
+  }
+
+  void mynest::MyModule::FreezeSynapses_lFunction::execute(SLIInterpreter *i) const
+  {
+    i->assert_stack_load(1);
+
+    const long n = freeze_synapses(get_synapse_id_(i, 0));
+
+    i->OStack.pop(1);
+    i->OStack.push(n);
+    i->EStack.pop();
+  }
+
+  void mynest::MyModule::PruneSynapses_l_dFunction::execute(SLIInterpreter *i) const
+  {
+    i->assert_stack_load(2);
+
+    const long n = prune_synapses(get_synapse_id_(i, 1),
+                                  getValue<double>(i->OStack.pick(0)));
+
+    i->OStack.pop(2);
+    i->OStack.push(n);
+    i->EStack.pop();
+  }
+
+  void mynest::MyModule::NormalizeSynapses_l_d_iFunction::execute(SLIInterpreter *i) const
+  {
+    i->assert_stack_load(3);
+
+    normalize_synapses(get_synapse_id_(i, 2),
+                       getValue<double>(i->OStack.pick(1)),
+                       getValue<long>(i->OStack.pick(0)));
+
+    i->OStack.pop(3);
+    i->EStack.pop();
+  }
+
+  void mynest::MyModule::SaveCheckpoint_s_bFunction::execute(SLIInterpreter *i) const
+  {
+    i->assert_stack_load(2);
+
+    save_checkpoint(getValue<std::string>(i->OStack.pick(1)),
+                    getValue<bool>(i->OStack.pick(0)));
+
+    i->OStack.pop(2);
+    i->EStack.pop();
+  }
+
+  void mynest::MyModule::LoadCheckpoint_sFunction::execute(SLIInterpreter *i) const
+  {
+    i->assert_stack_load(1);
+
+    load_checkpoint(getValue<std::string>(i->OStack.pick(0)));
 
+    i->OStack.pop(1);
+    i->EStack.pop();
+  }
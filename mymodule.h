@@ -27,6 +27,7 @@
 #include "slifunction.h"
 #include "topologymodule.h"
 #include "parameter.h"
+#include "module_math.h"
 #include <cmath>
 
 namespace nest
@@ -84,6 +85,69 @@ public:
 
   // Classes implementing your functions -----------------------------
 
+  /**
+   * Bulk access to the state of plastic connections, see module_connector.h.
+   * The mangled names give the arguments on the stack (bottom first),
+   * l: literal, D: dictionary, s: string, d: double, i: integer.
+   */
+  class GetSynapseColumns_lFunction: public SLIFunction
+  {
+  public:
+    void execute(SLIInterpreter *) const;
+  } getSynapseColumns_lFunction;
+
+  class SetSynapseColumns_l_DFunction: public SLIFunction
+  {
+  public:
+    void execute(SLIInterpreter *) const;
+  } setSynapseColumns_l_DFunction;
+
+  class SaveSynapseColumns_l_sFunction: public SLIFunction
+  {
+  public:
+    void execute(SLIInterpreter *) const;
+  } saveSynapseColumns_l_sFunction;
+
+  class LoadSynapseColumns_l_sFunction: public SLIFunction
+  {
+  public:
+    void execute(SLIInterpreter *) const;
+  } loadSynapseColumns_l_sFunction;
+
+  class FreezeSynapses_lFunction: public SLIFunction
+  {
+  public:
+    void execute(SLIInterpreter *) const;
+  } freezeSynapses_lFunction;
+
+  class PruneSynapses_l_dFunction: public SLIFunction
+  {
+  public:
+    void execute(SLIInterpreter *) const;
+  } pruneSynapses_l_dFunction;
+
+  class NormalizeSynapses_l_d_iFunction: public SLIFunction
+  {
+  public:
+    void execute(SLIInterpreter *) const;
+  } normalizeSynapses_l_d_iFunction;
+
+  /**
+   * Checkpointing of module nodes, see checkpoint.h.
+   * b: bool.
+   */
+  class SaveCheckpoint_s_bFunction: public SLIFunction
+  {
+  public:
+    void execute(SLIInterpreter *) const;
+  } saveCheckpoint_s_bFunction;
+
+  class LoadCheckpoint_sFunction: public SLIFunction
+  {
+  public:
+    void execute(SLIInterpreter *) const;
+  } loadCheckpoint_sFunction;
+
   /**
    * Implement a function for a step-pattern-based connection.
    * @note What this function does is described in the SLI documentation
@@ -104,10 +168,14 @@ class LaplacianParameter: public nest::Parameter
             Parameter(d),
             a_(3.0),
             b_(3.0),
-            r_(3.0)
+            r_(3.0),
+            math_accuracy_(mynest::MATH_EXACT)
         {
             updateValue<double>(d,"a",a_);
             updateValue<double>(d,"r",r_);
+            updateValue<long>(d,"math_accuracy",math_accuracy_);
+            if (!mynest::math::valid_accuracy(math_accuracy_))
+                throw nest::BadProperty("math_accuracy must be 0, 1 or 2.");
         }
 
         double raw_value(const nest::Position<2>& disp,
@@ -115,8 +183,12 @@ class LaplacianParameter: public nest::Parameter
         {
             double xx;
             xx=disp[0]*disp[0]+disp[1]*disp[1];
-            return (1.0 + a_) * std::exp(-xx / (2.0 * r_ * r_))
-                - a_ * std::exp(-xx / (2.0 * b_ * b_ * r_ * r_));
+            switch (math_accuracy_)
+            {
+            case mynest::MATH_1E12: return value_<mynest::MATH_1E12>(xx);
+            case mynest::MATH_1E7:  return value_<mynest::MATH_1E7>(xx);
+            default:                return value_<mynest::MATH_EXACT>(xx);
+            }
         }
 
         nest::Parameter * clone() const
@@ -125,7 +197,16 @@ class LaplacianParameter: public nest::Parameter
         }
 
     private:
+        //! Value at squared distance xx for MathAccuracy A
+        template <int A>
+        double value_(double xx) const
+        {
+            return (1.0 + a_) * mynest::math::exp<A>(-xx / (2.0 * r_ * r_))
+                - a_ * mynest::math::exp<A>(-xx / (2.0 * b_ * b_ * r_ * r_));
+        }
+
         double a_,b_,r_;
+        long math_accuracy_;
 
 };
 
@@ -0,0 +1,209 @@
+/*
+ *  neuron_arena.cpp
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "neuron_arena.h"
+#include "exceptions.h"
+#include "network.h"
+#include "nestmodule.h"
+
+#include <cstdlib>
+#include <new>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace
+{
+  // arena t of thread t; grown serially and never deleted, since chunks
+  // point to their arena and nodes may release blocks at exit
+  std::vector<mynest::NeuronArena*> arenas;
+
+  // NEST runs the nodes of thread t on OpenMP thread t
+  size_t thread_id()
+  {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+  }
+
+  bool in_parallel()
+  {
+#ifdef _OPENMP
+    return omp_in_parallel();
+#else
+    return false;
+#endif
+  }
+}
+
+namespace mynest
+{
+
+  NeuronArena* NeuronArena::arena_(size_t t)
+  {
+    return t < arenas.size() ? arenas[t] : 0;
+  }
+
+  NeuronArena& NeuronArena::local()
+  {
+    const size_t t = thread_id();
+    if ( !in_parallel() )
+    {
+      // Create runs here, before the nodes are calibrated in parallel
+      size_t n = nest::NestModule::get_network().get_num_threads();
+      if ( n <= t )
+        n = t + 1;
+      while ( arenas.size() < n )
+        arenas.push_back(new NeuronArena);
+    }
+    else if ( t >= arenas.size() )
+      throw nest::KernelException("Multi-receptor models have no arena for this thread.");
+    return *arenas[t];
+  }
+
+  NeuronArena::NeuronArena()
+    : current_(0),
+      has_deferred_(false)
+  {}
+
+  NeuronArena::~NeuronArena()
+  {
+    release_deferred_();
+
+    // chunks with live blocks are freed by their last release()
+    if ( current_ != 0 && current_->live_ == 0 )
+      std::free(current_);
+    current_ = 0;
+  }
+
+  double_t* NeuronArena::allocate(size_t n)
+  {
+    if ( n == 0 )
+      return 0;
+
+    release_deferred_();
+
+    const size_t need = n + header_size;
+    if ( current_ == 0 || current_->top_ + need > current_->capacity_ )
+    {
+      if ( current_ != 0 && current_->live_ == 0 )
+        std::free(current_);
+
+      // room for the arrays of many neurons of the size asked for
+      size_t capacity = 256 * need;
+      if ( capacity < min_chunk )
+        capacity = min_chunk;
+
+      void* mem = std::malloc(sizeof(Chunk_) + capacity * sizeof(double_t));
+      if ( mem == 0 )
+        throw std::bad_alloc();
+
+      current_ = static_cast<Chunk_*>(mem);
+      current_->owner_ = this;
+      current_->capacity_ = capacity;
+      current_->top_ = 0;
+      current_->live_ = 0;
+    }
+
+    Header_* hdr = reinterpret_cast<Header_*>(current_->data() + current_->top_);
+    hdr->h.chunk = current_;
+    hdr->h.size = n;
+    current_->top_ += need;
+    ++current_->live_;
+    return reinterpret_cast<double_t*>(hdr) + header_size;
+  }
+
+  void NeuronArena::release(double_t* p)
+  {
+    if ( p == 0 )
+      return;
+
+    NeuronArena* owner = reinterpret_cast<Header_*>(p - header_size)->h.chunk->owner_;
+    if ( in_parallel() && owner != arena_(thread_id()) )
+    {
+#ifdef _OPENMP
+#pragma omp critical(neuron_arena_deferred)
+#endif
+      {
+        owner->deferred_.push_back(p);
+        owner->has_deferred_ = true;
+      }
+      return;
+    }
+
+    owner->release_(p);
+  }
+
+  void NeuronArena::release_deferred_()
+  {
+    // a block handed over after this check waits for the next allocation
+    if ( !has_deferred_ )
+      return;
+
+    std::vector<double_t*> blocks;
+#ifdef _OPENMP
+#pragma omp critical(neuron_arena_deferred)
+#endif
+    {
+      blocks.swap(deferred_);
+      has_deferred_ = false;
+    }
+
+    for ( size_t i = 0; i < blocks.size(); ++i )
+      release_(blocks[i]);
+  }
+
+  void NeuronArena::release_(double_t* p)
+  {
+    Header_* hdr = reinterpret_cast<Header_*>(p - header_size);
+    Chunk_* c = hdr->h.chunk;
+    --c->live_;
+
+    if ( c != current_ )
+    {
+      if ( c->live_ == 0 )
+        std::free(c);
+    }
+    else if ( c->live_ == 0 )
+      c->top_ = 0;
+    else if ( p + hdr->h.size == c->data() + c->top_ )
+      c->top_ -= hdr->h.size + header_size;
+  }
+
+  void ArenaArray::reserve_(size_t n, bool keep)
+  {
+    if ( n <= capacity_ )
+      return;
+
+    double_t* d = NeuronArena::local().allocate(n);
+    if ( keep )
+      for ( size_t i = 0; i < size_; ++i )
+        d[i] = data_[i];
+    NeuronArena::release(data_);
+    data_ = d;
+    capacity_ = n;
+  }
+
+} // namespace
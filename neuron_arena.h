@@ -0,0 +1,241 @@
+/*
+ *  neuron_arena.h
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef NEURON_ARENA_H
+#define NEURON_ARENA_H
+
+#include "nest.h"
+
+#include <cstddef>
+#include <vector>
+
+/*
+ * Storage for the variable-length arrays of the multi-receptor models
+ * (glif_psc_alpha_multi, iaf_psc_alpha_multi_ext, iaf_wsn_hermitian_*).
+ *
+ * Create copies the prototype once per neuron, and with std::vector every
+ * array of every copy was a heap allocation of its own, repeated in
+ * calibrate(). ArenaArray instead takes its elements from a per-thread
+ * NeuronArena, which hands out pieces of large chunks. The arrays of one
+ * neuron end up next to each other, a chunk holds the arrays of many
+ * neurons and is returned to the heap when its last array is released.
+ */
+
+namespace mynest
+{
+
+  /**
+   * Bump allocator of doubles, one per thread.
+   *
+   * Each block starts with a header that points to its chunk. A chunk
+   * counts its live blocks; the current chunk of an arena is rewound when
+   * it becomes empty, any other chunk is freed. Releasing the block on top
+   * of the current chunk rewinds it as well, so short-lived copies such as
+   * the temporaries of set_status() do not use up the chunk.
+   *
+   * Thread t allocates from arena t, which in calibrate() is the arena of
+   * the node's thread. Create copies the prototype on the master thread,
+   * so the parameter and state arrays of all neurons come from arena 0;
+   * the arrays of the internal variables, sized in calibrate(), come from
+   * the arena of the node's thread.
+   *
+   * The chunks of an arena are only changed by its own thread or outside
+   * parallel regions. NEST creates and deletes nodes serially, but
+   * calibrates them in parallel, and calibrate() may grow an array
+   * allocated at Create by the master thread. A block of another arena
+   * released in a parallel region is therefore handed to its arena, which
+   * releases it with its next allocation; only that hand-over is locked,
+   * and an arena without handed-over blocks does not take the lock.
+   *
+   * There is one arena per thread of the network. The arenas are added
+   * outside parallel regions, when Create asks for the arena of the master
+   * thread, and are kept when the number of threads drops.
+   */
+  class NeuronArena
+  {
+  public:
+
+    /** Smallest chunk in doubles, 256 kB. */
+    static const size_t min_chunk = 32768;
+
+    /**
+     * Arena of the calling thread. Outside parallel regions, adds arenas up
+     * to the number of threads of the network first. Throws KernelException
+     * if a thread without arena calls it in a parallel region.
+     */
+    static NeuronArena& local();
+
+    NeuronArena();
+    ~NeuronArena();
+
+    /** n doubles, uninitialized, or 0 if n is 0. */
+    double_t* allocate(size_t n);
+
+    /** Return a block of any arena, p may be 0. */
+    static void release(double_t* p);
+
+  private:
+
+    struct Chunk_
+    {
+      NeuronArena* owner_;
+      size_t capacity_;   //!< In doubles
+      size_t top_;        //!< Doubles in use
+      size_t live_;       //!< Blocks in use
+
+      double_t* data() { return reinterpret_cast<double_t*>(this + 1); }
+    };
+
+    /** Header in front of each block, two doubles wide. */
+    union Header_
+    {
+      struct { Chunk_* chunk; size_t size; } h;
+      double_t pad[2];
+    };
+
+    static const size_t header_size = sizeof(Header_) / sizeof(double_t);
+
+    NeuronArena(const NeuronArena&);
+    NeuronArena& operator=(const NeuronArena&);
+
+    /** Release a block of this arena, by its thread or serially. */
+    void release_(double_t* p);
+
+    /** Release the blocks handed over by other threads. */
+    void release_deferred_();
+
+    /** Arena t, or 0 if there is none. */
+    static NeuronArena* arena_(size_t t);
+
+    Chunk_* current_;
+    std::vector<double_t*> deferred_;  //!< Handed over, see release()
+    volatile bool has_deferred_;       //!< Read without the lock
+  };
+
+  /**
+   * Fixed-capacity array of doubles in a NeuronArena.
+   *
+   * Offers the part of the std::vector interface the models use.
+   * Copies and growing resizes take memory from the arena of the calling
+   * thread; assignment and resize within the capacity do not allocate.
+   */
+  class ArenaArray
+  {
+  public:
+
+    typedef double_t value_type;
+    typedef double_t* iterator;
+    typedef const double_t* const_iterator;
+
+    ArenaArray()
+      : data_(0), size_(0), capacity_(0)
+    {}
+
+    ArenaArray(const ArenaArray& a)
+      : data_(0), size_(0), capacity_(0)
+    {
+      assign(a.begin(), a.end());
+    }
+
+    explicit ArenaArray(const std::vector<double_t>& v)
+      : data_(0), size_(0), capacity_(0)
+    {
+      assign(v.begin(), v.end());
+    }
+
+    ~ArenaArray()
+    {
+      NeuronArena::release(data_);
+    }
+
+    ArenaArray& operator=(const ArenaArray& a)
+    {
+      if ( this != &a )
+        assign(a.begin(), a.end());
+      return *this;
+    }
+
+    ArenaArray& operator=(const std::vector<double_t>& v)
+    {
+      assign(v.begin(), v.end());
+      return *this;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    double_t& operator[](size_t i) { return data_[i]; }
+    const double_t& operator[](size_t i) const { return data_[i]; }
+
+    iterator begin() { return data_; }
+    iterator end() { return data_ + size_; }
+    const_iterator begin() const { return data_; }
+    const_iterator end() const { return data_ + size_; }
+
+    /** Size 0, the storage is kept. */
+    void clear() { size_ = 0; }
+
+    /** New elements are 0. */
+    void resize(size_t n)
+    {
+      reserve_(n, true);
+      for ( size_t i = size_; i < n; ++i )
+        data_[i] = 0.0;
+      size_ = n;
+    }
+
+    void assign(size_t n, double_t x)
+    {
+      reserve_(n, false);
+      for ( size_t i = 0; i < n; ++i )
+        data_[i] = x;
+      size_ = n;
+    }
+
+    template <class It>
+    void assign(It first, It last)
+    {
+      const size_t n = static_cast<size_t>(last - first);
+      reserve_(n, false);
+      for ( size_t i = 0; i < n; ++i, ++first )
+        data_[i] = *first;
+      size_ = n;
+    }
+
+    std::vector<double_t> to_vector() const
+    {
+      return std::vector<double_t>(begin(), end());
+    }
+
+  private:
+
+    /** Make room for n elements, keep the old ones if asked to. */
+    void reserve_(size_t n, bool keep);
+
+    double_t* data_;
+    size_t size_;
+    size_t capacity_;
+  };
+
+} // namespace
+
+#endif /* #ifndef NEURON_ARENA_H */
@@ -0,0 +1,84 @@
+/*
+ *  neuron_kernel.h
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef NEURON_KERNEL_H
+#define NEURON_KERNEL_H
+
+/*
+ * Update kernels of the module neurons.
+ *
+ * A kernel is a struct with the update math of one model and nothing
+ * else: no NEST headers, no events, no buffers. Its functions are static
+ * templates on the parameter, state and variable types, which must have
+ * the members used by the kernel under the names the model uses. The
+ * model passes its own Parameters_, State_ and Variables_; other programs
+ * use the Parameters, State and Variables structs of the kernel.
+ *
+ * Every kernel provides
+ *
+ *   calibrate(p, v, h)   propagators for step size h in ms. The number
+ *                        of refractory steps is left to the caller, NEST
+ *                        rounds t_ref with nest::Time, see refractory_steps().
+ *   step<A>(p, s, v, ...)  one step of size h, returns true on a spike.
+ *   run(p, s, v, ...)    n steps over input arrays, for offline use.
+ *
+ * A is the MathAccuracy of p.math_accuracy_, see module_math.h. It is a
+ * template argument, so that the caller chooses the tier once, in
+ * calibrate() or before a loop, instead of in every step. run() chooses
+ * it from p.math_accuracy_.
+ *
+ * The inputs of run() are given per step k as NEST delivers them: spike
+ * weights arriving in step k, and the current that the model reads at
+ * the end of step k. The time at the end of step k is (first + k + 1) h.
+ *
+ * The kernels only need the standard library, so a tool can include
+ * them without linking NEST or the module:
+ *
+ *   #include "iaf_freq_sensor_v2_kernel.h"
+ *
+ *   mynest::FreqSensorV2Kernel::Parameters p;   // fill in
+ *   mynest::FreqSensorV2Kernel::State s;
+ *   mynest::FreqSensorV2Kernel::Variables v;
+ *   mynest::FreqSensorV2Kernel::calibrate(p, v, h);
+ *   v.RefractoryCounts_ = mynest::refractory_steps(t_ref, h);
+ *   mynest::FreqSensorV2Kernel::run(p, s, v, h, 0, n, clock, current, spikes);
+ */
+
+#include <cmath>
+#include <cstddef>
+
+namespace mynest
+{
+
+  /** Same value as nest::numerics::pi. */
+  const double kernel_pi = 3.14159265358979323846264338328;
+
+  /** t_ref in steps of h, rounded to the nearest step as nest::Time does. */
+  inline
+  int refractory_steps(double t_ref, double h)
+  {
+    return static_cast<int>(std::floor(t_ref / h + 0.5));
+  }
+
+} // namespace
+
+#endif /* #ifndef NEURON_KERNEL_H */
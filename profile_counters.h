@@ -0,0 +1,131 @@
+/*
+ *  profile_counters.h
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PROFILE_COUNTERS_H
+#define PROFILE_COUNTERS_H
+
+#include "mymodule_config.h"
+
+/*
+ * Hot-path counters of the module models.
+ *
+ * If the module is configured with --enable-profile, MYMODULE_PROFILE is
+ * defined and each instrumented model keeps one static ProfileCounters
+ * object, which sums the counts of all its instances. The counters are
+ * returned as dictionary "profile" by GetDefaults on the model, e.g.
+ *
+ *   /glif_psc_alpha_multi GetDefaults /profile get
+ *
+ * Cycle counts are read from the time stamp counter on x86 and are
+ * approximate, they include the overhead of reading the counter.
+ *
+ * Without MYMODULE_PROFILE, the macros below expand to nothing and no
+ * counters exist.
+ */
+
+#ifdef MYMODULE_PROFILE
+
+#include "nest.h"
+#include "dictutils.h"
+
+#include <ctime>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace mynest
+{
+
+  /** Read the cycle counter, or the process clock where there is none. */
+  inline
+  uint64_t profile_cycles()
+  {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    uint32_t lo, hi;
+    __asm__ __volatile__ ("rdtsc" : "=a"(lo), "=d"(hi));
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+#else
+    return std::clock();
+#endif
+  }
+
+  /**
+   * Named counters, summed over all threads when read.
+   *
+   * Each thread writes to its own block of counters, padded to a cache
+   * line, so counting needs no locks. Threads beyond max_threads share
+   * blocks and may lose counts.
+   */
+  class ProfileCounters
+  {
+  public:
+
+    static const size_t max_threads = 64;
+
+    ProfileCounters(const char* const names[], size_t n)
+      : names_(names, names + n),
+        stride_((n + 7) / 8 * 8),
+        counts_(max_threads * stride_, 0)
+    {}
+
+    void add(nest::thread t, size_t i, uint64_t n)
+    {
+      counts_[(t % max_threads) * stride_ + i] += n;
+    }
+
+    void get(DictionaryDatum& d) const
+    {
+      DictionaryDatum p(new Dictionary);
+      for ( size_t i = 0; i < names_.size(); ++i )
+      {
+        uint64_t sum = 0;
+        for ( size_t t = 0; t < max_threads; ++t )
+          sum += counts_[t * stride_ + i];
+        def<long>(p, names_[i], static_cast<long>(sum));
+      }
+      (*d)["profile"] = p;
+    }
+
+  private:
+
+    std::vector<std::string> names_;
+    size_t stride_;
+    std::vector<uint64_t> counts_;
+  };
+
+} // namespace
+
+#define MYMODULE_PROFILE_COUNT(counters, thr, idx, n) (counters).add((thr), (idx), (n))
+#define MYMODULE_PROFILE_START(var) const uint64_t var = mynest::profile_cycles()
+#define MYMODULE_PROFILE_STOP(counters, thr, idx, var) \
+  (counters).add((thr), (idx), mynest::profile_cycles() - (var))
+
+#else
+
+// statements that do nothing, so that a counter can be the body of an if
+#define MYMODULE_PROFILE_COUNT(counters, thr, idx, n) ((void)0)
+#define MYMODULE_PROFILE_START(var) ((void)0)
+#define MYMODULE_PROFILE_STOP(counters, thr, idx, var) ((void)0)
+
+#endif /* MYMODULE_PROFILE */
+
+#endif /* #ifndef PROFILE_COUNTERS_H */
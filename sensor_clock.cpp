@@ -0,0 +1,151 @@
+/*
+ *  sensor_clock.cpp
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "sensor_clock.h"
+#include "network.h"
+#include "dict.h"
+#include "dictutils.h"
+#include "arraydatum.h"
+#include "exceptions.h"
+
+#include <algorithm>
+#include <limits>
+
+/* ----------------------------------------------------------------
+ * Default constructors defining default parameter
+ * ---------------------------------------------------------------- */
+
+mynest::sensor_clock::Parameters_::Parameters_()
+  : interval_(0.0),
+    phase_(0.0),
+    times_()
+{}
+
+/* ----------------------------------------------------------------
+ * Parameter extraction and manipulation functions
+ * ---------------------------------------------------------------- */
+
+void mynest::sensor_clock::Parameters_::get(DictionaryDatum &d) const
+{
+  def<double>(d, "interval", interval_);
+  def<double>(d, "phase", phase_);
+  (*d)["times"] = new ArrayDatum(times_);
+}
+
+void mynest::sensor_clock::Parameters_::set(const DictionaryDatum& d)
+{
+  updateValue<double>(d, "interval", interval_);
+  updateValue<double>(d, "phase", phase_);
+  updateValue<std::vector<double> >(d, "times", times_);
+
+  if ( interval_ < 0.0 )
+    throw BadProperty("The interval must be >= 0.");
+
+  if ( phase_ < 0.0 )
+    throw BadProperty("The phase must be >= 0.");
+
+  for ( size_t i = 0; i < times_.size(); ++i )
+    if ( times_[i] < 0.0 )
+      throw BadProperty("Tick times must be >= 0.");
+}
+
+/* ----------------------------------------------------------------
+ * Default and copy constructor for node
+ * ---------------------------------------------------------------- */
+
+mynest::sensor_clock::sensor_clock()
+  : Node(),
+    P_()
+{
+  V_.slice_ = std::numeric_limits<long_t>::min();
+}
+
+mynest::sensor_clock::sensor_clock(const sensor_clock& n)
+  : Node(n),
+    P_(n.P_)
+{
+  V_.slice_ = std::numeric_limits<long_t>::min();
+}
+
+/* ----------------------------------------------------------------
+ * Status
+ * ---------------------------------------------------------------- */
+
+void mynest::sensor_clock::get_status(DictionaryDatum &d) const
+{
+  P_.get(d);
+}
+
+void mynest::sensor_clock::set_status(const DictionaryDatum &d)
+{
+  Parameters_ ptmp = P_;  // temporary copy in case of errors
+  ptmp.set(d);            // throws if BadProperty
+
+  // if we get here, temporaries contain consistent set of properties
+  P_ = ptmp;
+}
+
+/* ----------------------------------------------------------------
+ * Node initialization and ticks
+ * ---------------------------------------------------------------- */
+
+void mynest::sensor_clock::calibrate()
+{
+  // times rounded to the grid as for refractory periods, see iaf_freq_sensor
+  V_.interval_ = Time(Time::ms(P_.interval_)).get_steps();
+  V_.phase_ = Time(Time::ms(P_.phase_)).get_steps();
+  if ( P_.interval_ > 0.0 && V_.interval_ < 1 )
+    throw BadProperty("The interval must be at least one time step.");
+
+  V_.times_.resize(P_.times_.size());
+  for ( size_t i = 0; i < P_.times_.size(); ++i )
+    V_.times_[i] = Time(Time::ms(P_.times_[i])).get_steps();
+  std::sort(V_.times_.begin(), V_.times_.end());
+
+  V_.ticks_.assign(Scheduler::get_min_delay(), 0);
+  V_.slice_ = std::numeric_limits<long_t>::min();
+}
+
+void mynest::sensor_clock::fill_(long_t origin)
+{
+  // the tick of lag ends step origin + lag + 1
+  const long_t first = origin + 1;
+  const long_t n = V_.ticks_.size();
+
+  std::fill(V_.ticks_.begin(), V_.ticks_.end(), 0);
+
+  if ( V_.interval_ > 0 )
+  {
+    long_t s = V_.phase_;
+    if ( s < first )
+      s += (first - s + V_.interval_ - 1) / V_.interval_ * V_.interval_;
+    for ( ; s < first + n; s += V_.interval_ )
+      V_.ticks_[s - first] = 1;
+  }
+
+  std::vector<long_t>::const_iterator it =
+    std::lower_bound(V_.times_.begin(), V_.times_.end(), first);
+  for ( ; it != V_.times_.end() && *it < first + n; ++it )
+    V_.ticks_[*it - first] = 1;
+
+  V_.slice_ = origin;
+}
@@ -0,0 +1,143 @@
+/*
+ *  sensor_clock.h
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SENSOR_CLOCK_H
+#define SENSOR_CLOCK_H
+
+#include "nest.h"
+#include "node.h"
+
+#include <vector>
+
+/* BeginDocumentation
+Name: sensor_clock - Clock ticks read directly by the sensor models.
+
+Description:
+
+  The clock-driven sensor models (iaf_freq_sensor, iaf_freq_sensor_v2,
+  iaf_wsn_alpha, iaf_wsn_hermitian_1 and iaf_wsn_hermitian_2) reset their
+  integration on clock spikes. Instead of connecting a spike source to
+  each sensor, set the sensor's parameter clock to the gid of a
+  sensor_clock. The sensor then reads the ticks of the clock's instance on
+  its own thread in each step; no events are sent and the clock input of
+  the sensor is no longer read.
+
+  A tick at time T acts like a clock spike that arrives at T, i.e. it
+  resets the sensor in the step ending at T. Ticks are placed every
+  interval ms starting at phase, plus at each of times. All times are
+  rounded to the resolution.
+
+  The ticks of a slice are computed once per instance when the first
+  sensor asks for them, the other sensors of the thread read the same
+  flags.
+
+Parameters:
+
+  interval  double - Time between periodic ticks in ms, 0 for none (default).
+  phase     double - Time of the first periodic tick in ms, default 0.
+  times     array  - Additional tick times in ms.
+
+Remarks:
+
+  Sensors read the clock in calibrate(), so changing the clock parameter
+  of a sensor takes effect with the next Simulate.
+
+Author: Zhenzhong Wang
+SeeAlso: iaf_freq_sensor, iaf_wsn_hermitian_1, spike_generator
+*/
+
+using namespace nest;
+namespace mynest
+{
+
+  class Network;
+
+  /**
+   * Tick schedule shared by the sensors of one thread.
+   */
+  class sensor_clock : public Node
+  {
+
+  public:
+
+    sensor_clock();
+    sensor_clock(const sensor_clock&);
+
+    bool has_proxies() const { return false; }
+
+    void get_status(DictionaryDatum &) const;
+    void set_status(const DictionaryDatum &);
+
+    /**
+     * True if there is a tick at the end of step origin + lag, the step
+     * a clock spike delivered at lag would be read in.
+     */
+    bool tick(Time const& origin, const long_t lag)
+    {
+      if ( origin.get_steps() != V_.slice_ )
+        fill_(origin.get_steps());
+      return V_.ticks_[lag] != 0;
+    }
+
+  private:
+
+    void init_state_(const Node&) {}
+    void init_buffers_() {}
+    void calibrate();
+
+    void update(Time const &, const long_t, const long_t) {}
+
+    /** Compute the ticks of the slice starting at step origin. */
+    void fill_(long_t origin);
+
+    // ------------------------------------------------------------
+
+    struct Parameters_ {
+      double_t interval_;  //!< In ms, 0 for no periodic ticks
+      double_t phase_;     //!< First periodic tick in ms
+      std::vector<double_t> times_;  //!< Additional ticks in ms
+
+      Parameters_();  //!< Sets default parameter values
+
+      void get(DictionaryDatum&) const;  //!< Store current values in dictionary
+      void set(const DictionaryDatum&);  //!< Set values from dictionary
+    };
+
+    // ------------------------------------------------------------
+
+    struct Variables_ {
+      long_t interval_;              //!< In steps
+      long_t phase_;                 //!< In steps
+      std::vector<long_t> times_;    //!< In steps, sorted
+      long_t slice_;                 //!< Origin of the slice in ticks_
+      std::vector<char> ticks_;      //!< One flag per lag
+    };
+
+    // ------------------------------------------------------------
+
+    Parameters_ P_;
+    Variables_  V_;
+  };
+
+} // namespace
+
+#endif /* #ifndef SENSOR_CLOCK_H */
@@ -25,11 +25,146 @@
 #include "common_synapse_properties.h"
 #include "stdp_connection_alpha.h"
 #include "event.h"
+#include "exceptions.h"
 using namespace nest;
 
 namespace mynest
 {
 
+#ifdef MYMODULE_PROFILE
+  namespace
+  {
+    const char* const profile_names[] =
+      { "sends", "history_entries", "send_cycles" };
+  }
+
+  ProfileCounters STDPConnectionAlpha::profile_(profile_names, 3);
+#endif
+
+  namespace
+  {
+    // live tables, guarded by the critical section gauss_tables
+    std::vector<GaussTable*> gauss_tables;
+
+    // The counts change without the lock. A count that dropped to 0 is
+    // never raised again: its table is about to be removed and deleted
+    // by the thread that dropped it.
+
+    void add_ref(GaussTable* g)
+    {
+#ifdef _OPENMP
+      __sync_add_and_fetch(&g->refs_, 1);
+#else
+      ++g->refs_;
+#endif
+    }
+
+    size_t drop_ref(GaussTable* g)
+    {
+#ifdef _OPENMP
+      return __sync_sub_and_fetch(&g->refs_, 1);
+#else
+      return --g->refs_;
+#endif
+    }
+
+    // add a reference unless the count is 0
+    bool add_live_ref(GaussTable* g)
+    {
+#ifdef _OPENMP
+      for (size_t r = g->refs_; r != 0; r = g->refs_)
+        if (__sync_bool_compare_and_swap(&g->refs_, r, r + 1))
+          return true;
+      return false;
+#else
+      if (g->refs_ == 0)
+        return false;
+      ++g->refs_;
+      return true;
+#endif
+    }
+
+    // live table with a reference added, call in the critical section
+    GaussTable* find_gauss_table(double_t sigma, double_t center, double_t window, double_t h)
+    {
+      for (size_t i = 0; i < gauss_tables.size(); ++i)
+      {
+        GaussTable* g = gauss_tables[i];
+        if (g->sigma_ == sigma && g->center_ == center && g->window_ == window && g->h_ == h
+            && add_live_ref(g))
+          return g;
+      }
+      return 0;
+    }
+  }
+
+  const GaussTable* GaussTable::acquire(const GaussTable* t)
+  {
+    // the caller holds a reference, so the count is not 0
+    if (t != 0)
+      add_ref(const_cast<GaussTable*>(t));
+    return t;
+  }
+
+  void GaussTable::release(const GaussTable* t)
+  {
+    if (t == 0 || drop_ref(const_cast<GaussTable*>(t)) != 0)
+      return;
+
+#ifdef _OPENMP
+#pragma omp critical(gauss_tables)
+#endif
+    gauss_tables.erase(std::find(gauss_tables.begin(), gauss_tables.end(), t));
+    delete t;
+  }
+
+  const GaussTable* GaussTable::get(double_t sigma, double_t center, double_t window)
+  {
+    const double_t h = Time::get_resolution().get_ms();
+
+    GaussTable* g = 0;
+#ifdef _OPENMP
+#pragma omp critical(gauss_tables)
+#endif
+    g = find_gauss_table(sigma, center, window, h);
+    if (g != 0)
+      return g;
+
+    // build outside the lock, another thread may have added the same table
+    g = new GaussTable;
+    g->sigma_  = sigma;
+    g->center_ = center;
+    g->window_ = window;
+    g->h_      = h;
+    g->lo_step_ = static_cast<long_t>(std::floor((center - window * sigma) / h));
+    const long_t hi_step = static_cast<long_t>(std::ceil((center + window * sigma) / h));
+    g->lo_ = g->lo_step_ * h;
+    g->hi_ = hi_step * h;
+    g->values_.resize(hi_step - g->lo_step_ + 1);
+    for (size_t i = 0; i < g->values_.size(); ++i)
+    {
+      const double_t t1 = (g->lo_step_ + static_cast<long_t>(i)) * h - center;
+      g->values_[i] = std::exp(-(t1 * t1)/(sigma * sigma));
+    }
+    g->refs_ = 1;
+
+    GaussTable* other = 0;
+#ifdef _OPENMP
+#pragma omp critical(gauss_tables)
+#endif
+    {
+      other = find_gauss_table(sigma, center, window, h);
+      if (other == 0)
+        gauss_tables.push_back(g);
+    }
+    if (other != 0)
+    {
+      delete g;
+      return other;
+    }
+    return g;
+  }
+
 
   STDPConnectionAlpha::STDPConnectionAlpha() :
     ConnectionHetWD(),
@@ -38,10 +173,19 @@ namespace mynest
     shift_(-0.2),
     sigma_(1.7),
     center_(-2.0),
+    window_(0.0),
     Wmax_(100.0),
     Esyn_(1.0),
     EmitSpk_(true)
-  { }
+  {
+    set_gauss_table_();
+    dendritic_delay_ = Time(Time::step(delay_)).get_ms();
+    step_history_ = false;
+    frozen_ = false;
+    math_accuracy_ = MATH_EXACT;
+    Wprune_ = 0.0;
+    t_silent_ = -1.0;
+  }
 
 
   STDPConnectionAlpha::STDPConnectionAlpha(const STDPConnectionAlpha &rhs) :
@@ -52,9 +196,28 @@ namespace mynest
     shift_  = rhs.shift_;
     sigma_  = rhs.sigma_;
     center_ = rhs.center_;
+    window_ = rhs.window_;
     Wmax_   = rhs.Wmax_;
     Esyn_   = rhs.Esyn_;
     EmitSpk_= rhs.EmitSpk_;
+    gauss_  = rhs.gauss_;
+    dendritic_delay_ = rhs.dendritic_delay_;
+    step_history_ = rhs.step_history_;
+    frozen_ = rhs.frozen_;
+    math_accuracy_ = rhs.math_accuracy_;
+    Wprune_ = rhs.Wprune_;
+    t_silent_ = rhs.t_silent_;
+  }
+
+  void STDPConnectionAlpha::set_gauss_table_()
+  {
+    if (window_ < 0.0)
+      throw BadProperty("window must not be negative.");
+
+    if (window_ > 0.0 && sigma_ > 0.0)
+      gauss_.reset(GaussTable::get(sigma_, center_, window_));
+    else
+      gauss_.reset(0);
   }
 
   void STDPConnectionAlpha::get_status(DictionaryDatum & d) const
@@ -65,9 +228,18 @@ namespace mynest
     def<double_t>(d, "shift", shift_);
     def<double_t>(d, "sigma", sigma_);
     def<double_t>(d, "center", center_);
+    def<double_t>(d, "window", window_);
     def<double_t>(d, "Wmax", Wmax_);
     def<double_t>(d, "Esyn", Esyn_);
     def<bool>    (d, "EmitSpk", EmitSpk_);
+    def<double_t>(d, "Wprune", Wprune_);
+    def<bool>    (d, "frozen", frozen_);
+    def<long>(d, "math_accuracy", math_accuracy_);
+    def<double_t>(d, "t_silent", t_silent_);
+
+#ifdef MYMODULE_PROFILE
+    profile_.get(d);
+#endif
   }
 
   void STDPConnectionAlpha::set_status(const DictionaryDatum & d, ConnectorModel &cm)
@@ -78,9 +250,17 @@ namespace mynest
     updateValue<double_t>(d, "shift"  , shift_);
     updateValue<double_t>(d, "sigma"  , sigma_);
     updateValue<double_t>(d, "center" , center_);
+    updateValue<double_t>(d, "window" , window_);
     updateValue<double_t>(d, "Wmax"   , Wmax_);
     updateValue<double_t>(d, "Esyn"   , Esyn_);
     updateValue<bool>    (d, "EmitSpk", EmitSpk_);
+    updateValue<long>(d, "math_accuracy", math_accuracy_);
+    check_math_accuracy_();
+    updateValue<double_t>(d, "Wprune", Wprune_);
+    set_gauss_table_();
+    dendritic_delay_ = Time(Time::step(delay_)).get_ms();
+    // the weight may have been set, count the silent time anew
+    t_silent_ = -1.0;
   }
 
    /**
@@ -95,9 +275,16 @@ namespace mynest
     set_property<double_t>(d, "shift"  , p, shift_);
     set_property<double_t>(d, "sigma"  , p, sigma_);
     set_property<double_t>(d, "center" , p, center_);
+    set_property<double_t>(d, "window" , p, window_);
     set_property<double_t>(d, "Wmax"   , p, Wmax_);
     set_property<double_t>(d, "Esyn"   , p, Esyn_);
     set_property<bool>    (d, "EmitSpk", p, EmitSpk_);
+    set_property<long>(d, "math_accuracy", p, math_accuracy_);
+    check_math_accuracy_();
+    set_property<double_t>(d, "Wprune", p, Wprune_);
+    set_gauss_table_();
+    dendritic_delay_ = Time(Time::step(delay_)).get_ms();
+    t_silent_ = -1.0;
   }
 
   void STDPConnectionAlpha::initialize_property_arrays(DictionaryDatum & d) const
@@ -108,9 +295,12 @@ namespace mynest
     initialize_property_array(d, "shift"  );
     initialize_property_array(d, "sigma"  );
     initialize_property_array(d, "center" );
+    initialize_property_array(d, "window" );
     initialize_property_array(d, "Wmax"   );
     initialize_property_array(d, "Esyn"   );
     initialize_property_array(d, "EmitSpk");
+    initialize_property_array(d, "math_accuracy");
+    initialize_property_array(d, "Wprune");
   }
 
   /**
@@ -125,9 +315,18 @@ namespace mynest
     append_property<double_t>(d, "shift"  , shift_);
     append_property<double_t>(d, "sigma"  , sigma_);
     append_property<double_t>(d, "center" , center_);
+    append_property<double_t>(d, "window" , window_);
     append_property<double_t>(d, "Wmax"   , Wmax_);
     append_property<double_t>(d, "Esyn"   , Esyn_);
     append_property<bool>    (d, "EmitSpk", EmitSpk_);
+    append_property<long>(d, "math_accuracy", math_accuracy_);
+    append_property<double_t>(d, "Wprune", Wprune_);
+  }
+
+  void STDPConnectionAlpha::calibrate(const TimeConverter &tc)
+  {
+    ConnectionHetWD::calibrate(tc);
+    dendritic_delay_ = Time(Time::step(delay_)).get_ms();
   }
 
 } // of namespace nest
@@ -38,9 +38,27 @@
    shift      double - Shifting in the amplitude of the bell
    sigma      double - Width of the bell
    center     double - Center of the bell
+   window     double - Half width of the learning window in units of sigma,
+                       0 evaluates the bell for every postsynaptic spike
+                       (default)
    Wmax       double - Maximum allowed weight
    Esyn       double - Multiplication to w when sending spikes
    EmitSpk    bool   - whether to emit spikes or not
+   Wprune     double - Weight at or below which the synapse counts as silent
+   t_silent   double - Time since when the synapse is silent, -1 if it is
+                       not (read only), see PruneSynapses
+   math_accuracy int - exp and pow when learning: 0 std (default), 1 relative
+                       error below 1e-12, 2 below 1e-7, see module_math.h
+
+  Remarks:
+   With window > 0 the bell is truncated: exp(-(dt-center)^2/sigma^2) is
+   below exp(-window^2) outside center +- window*sigma, and postsynaptic
+   spikes outside this range only add the shift term, which is applied to
+   all of them at once. The bell inside the range is read from a table
+   over the simulation steps, shared by all synapses with the same sigma,
+   center and window and freed with the last of them. Spike times must
+   then lie on the simulation grid. The default window 0 evaluates the
+   full bell, the results do not depend on window then.
 
   Transmits: SpikeEvent
    
@@ -55,13 +73,100 @@
 
 #include "connection_het_wd.h"
 #include "archiving_node.h"
+#include "archiving_node_ext.h"
 #include "generic_connector.h"
+#include "profile_counters.h"
+#include "module_math.h"
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
 using namespace nest;
 
 namespace mynest
 {
+  /**
+   * Gaussian learning window of stdp_synapse_alpha, tabulated on the
+   * simulation grid over [lo_, hi_]. Tables are built on first use and
+   * counted by the connections using them, see GaussTableRef.
+   */
+  struct GaussTable
+  {
+    double_t sigma_;
+    double_t center_;
+    double_t window_;
+    double_t h_;         //!< resolution in ms the table was built for
+    double_t lo_;        //!< lower end of the window in ms
+    double_t hi_;        //!< upper end of the window in ms
+    long_t   lo_step_;   //!< step of values_[0]
+    std::vector<double_t> values_;
+    size_t   refs_;      //!< GaussTableRefs to the table, changed atomically
+
+    /**
+     * Table for the given parameters at the current resolution, with one
+     * reference added for the caller.
+     */
+    static const GaussTable* get(double_t sigma, double_t center, double_t window);
+
+    /** Add a reference to t, which may be 0. Does not lock. */
+    static const GaussTable* acquire(const GaussTable* t);
+
+    /**
+     * Drop a reference to t, which may be 0, the last one frees t. Only
+     * the last one locks the list of tables.
+     */
+    static void release(const GaussTable* t);
+
+    /** Bell at dt, which must be in [lo_, hi_] */
+    double_t operator()(double_t dt) const
+    {
+      const long_t i = static_cast<long_t>(std::floor(dt / h_ + 0.5)) - lo_step_;
+      return ( i >= 0 && static_cast<size_t>(i) < values_.size() ) ? values_[i] : 0.0;
+    }
+
+    long_t hi_step() const { return lo_step_ + static_cast<long_t>(values_.size()) - 1; }
+
+    /** Bell at step s, which must be in [lo_step_, hi_step()] */
+    double_t at_step(long_t s) const { return values_[s - lo_step_]; }
+  };
+
+  /**
+   * Counted pointer to a GaussTable. Connections are copied and destroyed
+   * by their connectors, this keeps the count right in all cases, so the
+   * tables are gone when all connections are, e.g. after ResetKernel.
+   */
+  class GaussTableRef
+  {
+  public:
+
+    GaussTableRef() : t_(0) {}
+    GaussTableRef(const GaussTableRef& r) : t_(GaussTable::acquire(r.t_)) {}
+    ~GaussTableRef() { GaussTable::release(t_); }
+
+    GaussTableRef& operator=(const GaussTableRef& r)
+    {
+      const GaussTable* t = GaussTable::acquire(r.t_);
+      GaussTable::release(t_);
+      t_ = t;
+      return *this;
+    }
+
+    /** Point to t, whose reference from GaussTable::get() is taken over. */
+    void reset(const GaussTable* t)
+    {
+      GaussTable::release(t_);
+      t_ = t;
+    }
+
+    const GaussTable* get() const { return t_; }
+    const GaussTable& operator*() const { return *t_; }
+    const GaussTable* operator->() const { return t_; }
+
+  private:
+
+    const GaussTable* t_;
+  };
+
   class STDPConnectionAlpha : public ConnectionHetWD
   {
 
@@ -113,6 +218,11 @@ namespace mynest
    */
   void append_properties(DictionaryDatum & d) const;
 
+  /**
+   * Convert the delay after a change of resolution.
+   */
+  void calibrate(const TimeConverter &);
+
   /**
    * Send an event to the receiver of this connection.
    * \param e The event to send
@@ -121,6 +231,43 @@ namespace mynest
    */
   void send(Event& e, double_t t_lastspike, const CommonSynapseProperties &cp);
 
+  /**
+   * This synapse keeps no presynaptic trace, the functions exist for
+   * bulk access through ModuleConnector.
+   */
+  double_t get_trace() const { return 0.0; }
+  void set_trace(double_t) {}
+
+  //! Upper weight bound, for NormalizeSynapses
+  double_t get_wmax() const { return Wmax_; }
+
+  //! Learning is never deferred, for ModuleConnector
+  void apply_deferred() const {}
+
+  /**
+   * Stop learning for good, see FreezeSynapses. The connection then only
+   * transmits and its target can drop the spike history kept for it.
+   * Only connections to an Archiving_Node_Ext can be frozen.
+   * \param t_lastspike Time of the last spike sent, from the connector.
+   * \returns true if the connection is frozen.
+   */
+  bool freeze(double_t t_lastspike);
+
+  /**
+   * Prepare removal by PruneSynapses if the weight has been at or below
+   * Wprune since time t_before or earlier. The connection is unregistered
+   * from its target and must be removed from its connector.
+   * \param t_lastspike Time of the last spike sent, from the connector.
+   * \returns true if the connection is to be removed.
+   */
+  bool prune(double_t t_before, double_t t_lastspike);
+
+  /**
+   * Forget since when the weight has been silent, as set_status does.
+   * Called by ModuleConnector after it rewrites the weight in bulk.
+   */
+  void restart_silent() { t_silent_ = -1.0; }
+
   // overloaded for all supported event types
   using Connection::check_event;
   void check_event(SpikeEvent&) {}
@@ -129,7 +276,23 @@ namespace mynest
 
   //double_t facilitate_(double_t w, double_t kplus);
   //double_t depress_(double_t w, double_t kminus);
+  //! send() for MathAccuracy A
+  template <int A>
+  void send_(Event& e, double_t t_lastspike);
+
+  template <int A>
   double_t learn_(double_t w, double_t dt);
+  double_t clip_(double_t w) const;
+  double_t shift_n_(double_t w, long_t n, double_t dw) const;
+  void set_gauss_table_();
+
+  void track_silent_(double_t t);
+
+  void check_math_accuracy_() const
+  {
+    if (!math::valid_accuracy(math_accuracy_))
+      throw BadProperty("math_accuracy must be 0, 1 or 2.");
+  }
 
   // data members of each connection
   double_t lambda_;
@@ -137,19 +300,47 @@ namespace mynest
   double_t shift_;
   double_t sigma_;
   double_t center_;
+  double_t window_;
   double_t Wmax_;
   double_t Esyn_;
   bool EmitSpk_;
-
+  GaussTableRef gauss_;  //!< 0 if the window is not truncated
+  double_t dendritic_delay_;  //!< delay_ in ms, kept up to date for send()
+  bool step_history_;         //!< target_ is an Archiving_Node_Ext
+  bool frozen_;               //!< no learning, target history released
+  long math_accuracy_;        //!< MathAccuracy of exp and pow in send()
+  double_t Wprune_;
+  double_t t_silent_;         //!< since when weight_ <= Wprune_ in ms, -1 if not
+
+#ifdef MYMODULE_PROFILE
+  //! Counters of all connections of this type, see profile_counters.h
+  enum ProfileCounter_ { PROF_SENDS, PROF_HISTORY, PROF_SEND_CYCLES };
+  static ProfileCounters profile_;
+#endif
   };
 
+template <int A>
 inline
 double_t STDPConnectionAlpha::learn_(double_t w, double_t dt)
 {
     double_t t1 = dt - center_;
     double_t ev = -(t1 * t1)/(sigma_ * sigma_);
-    double_t nw = lambda_ * (amp_ * std::exp(ev) + shift_);
-    nw = w + nw;
+    double_t nw = lambda_ * (amp_ * math::exp<A>(ev) + shift_);
+    return clip_(w + nw);
+}
+
+/**
+ * Weight after n spikes far from the center, each adding dw.
+ */
+inline
+double_t STDPConnectionAlpha::shift_n_(double_t w, long_t n, double_t dw) const
+{
+    return n > 0 ? clip_(w + n * dw) : w;
+}
+
+inline
+double_t STDPConnectionAlpha::clip_(double_t nw) const
+{
     if(nw < 0.0){
         return 0.0;
     }
@@ -187,7 +378,60 @@ void STDPConnectionAlpha::check_connection(Node & s, Node & r, rport receptor_ty
   // At registration, all entries' access counters of history[0, ..., t_last_spike - dendritic_delay] will be 
   // incremented by the following call to Archiving_Node::register_stdp_connection().
   // See bug #218 for details.
-  r.register_stdp_connection(t_lastspike - Time(Time::step(delay_)).get_ms());
+  dendritic_delay_ = Time(Time::step(delay_)).get_ms();
+
+  Archiving_Node_Ext* a = dynamic_cast<Archiving_Node_Ext*>(&r);
+  step_history_ = (a != 0);
+  if (step_history_)
+    a->register_step_connection(Time(Time::ms(t_lastspike)).get_steps() - delay_);
+  else
+    r.register_stdp_connection(t_lastspike - dendritic_delay_);
+
+  // the resolution may have changed since the parameters were set
+  set_gauss_table_();
+}
+
+/**
+ * Orders history entries by spike time, for binary search.
+ */
+struct HistentryBefore
+{
+  bool operator()(const histentry& a, double_t t) const { return a.t_ < t; }
+  bool operator()(double_t t, const histentry& a) const { return t < a.t_; }
+};
+
+inline
+bool STDPConnectionAlpha::freeze(double_t t_lastspike)
+{
+  if (frozen_ || !step_history_)
+    return frozen_;
+
+  static_cast<Archiving_Node_Ext*>(target_)->unregister_step_connection(
+    Time(Time::ms(t_lastspike)).get_steps() - delay_);
+  frozen_ = true;
+  return true;
+}
+
+inline
+void STDPConnectionAlpha::track_silent_(double_t t)
+{
+  if (weight_ > Wprune_)
+    t_silent_ = -1.0;
+  else if (t_silent_ < 0.0)
+    t_silent_ = t;
+}
+
+inline
+bool STDPConnectionAlpha::prune(double_t t_before, double_t t_lastspike)
+{
+  // the history of other targets cannot be released
+  if (!step_history_ || t_silent_ < 0.0 || t_silent_ > t_before)
+    return false;
+
+  if (!frozen_)
+    static_cast<Archiving_Node_Ext*>(target_)->unregister_step_connection(
+      Time(Time::ms(t_lastspike)).get_steps() - delay_);
+  return true;
 }
 
 /**
@@ -198,33 +442,125 @@ void STDPConnectionAlpha::check_connection(Node & s, Node & r, rport receptor_ty
  */
 inline
 void STDPConnectionAlpha::send(Event& e, double_t t_lastspike, const CommonSynapseProperties &)
+{
+  // the tier is chosen once per spike, not per history entry
+  switch (math_accuracy_)
+  {
+  case MATH_1E12: send_<MATH_1E12>(e, t_lastspike); break;
+  case MATH_1E7:  send_<MATH_1E7>(e, t_lastspike); break;
+  default:        send_<MATH_EXACT>(e, t_lastspike); break;
+  }
+}
+
+template <int A>
+inline
+void STDPConnectionAlpha::send_(Event& e, double_t t_lastspike)
 {
   // synapse STDP depressing/facilitation dynamics
+  MYMODULE_PROFILE_START(prof_start);
+
+  if (frozen_)
+  {
+    if (EmitSpk_)
+    {
+      e.set_receiver(*target_);
+      e.set_weight(weight_ * Esyn_);
+      e.set_delay(delay_);
+      e.set_rport(rport_);
+      e();
+    }
+    MYMODULE_PROFILE_COUNT(profile_, target_->get_thread(), PROF_SENDS, 1);
+    MYMODULE_PROFILE_STOP(profile_, target_->get_thread(), PROF_SEND_CYCLES, prof_start);
+    return;
+  }
 
-  double_t t_spike = e.get_stamp().get_ms();
+  const double_t t_spike = e.get_stamp().get_ms();
   // t_lastspike_ = 0 initially
-  double_t dendritic_delay = Time(Time::step(delay_)).get_ms();
+  // local copy, stores to weight_ might otherwise alias the member
+  const double_t dendritic_delay = dendritic_delay_;
 
-  //get spike history in relevant range (t1, t2] from post-synaptic neuron
-  std::deque<histentry>::iterator start;
-  std::deque<histentry>::iterator finish;
+  const double_t da = lambda_ * amp_;
+  const double_t dw = lambda_ * shift_;
 
-  // For a new synapse, t_lastspike contains the point in time of the last spike.
-  // So we initially read the history(t_last_spike - dendritic_delay, ...,  T_spike-dendritic_delay]
-  // which increases the access counter for these entries.
-  // At registration, all entries' access counters of history[0, ..., t_last_spike - dendritic_delay] have been 
-  // incremented by Archiving_Node::register_stdp_connection(). See bug #218 for details.
-  target_->get_history(t_lastspike - dendritic_delay, t_spike - dendritic_delay,
-                         &start, &finish);
-  //facilitation due to post-synaptic spikes since last pre-synaptic spike
-  double_t minus_dt;
-  while (start != finish)
+  // The history is sorted by time, so with a truncated window the spikes
+  // with minus_dt in [lo_, hi_] form one block. Spikes before and after it
+  // only add the constant shift term, and clipping after each of n equal
+  // steps gives the same weight as one step of n times the size.
+
+  if (step_history_)
+  {
+    // the same range in steps, from the contiguous history of the target
+    // resolution and step of the last spike from the cached delay, there
+    // is no Time conversion per spike
+    const double_t h = dendritic_delay / delay_;
+    const long_t t_ref = static_cast<long_t>(std::floor(t_lastspike / h + 0.5)) - delay_;
+    const long_t* first;
+    const long_t* last;
+    static_cast<Archiving_Node_Ext*>(target_)->get_step_history(
+      t_ref, e.get_stamp().get_steps() - delay_, &first, &last);
+    MYMODULE_PROFILE_COUNT(profile_, target_->get_thread(), PROF_HISTORY, last - first);
+
+    if (gauss_.get() == 0)
+    {
+      for (; first != last; ++first)
+        weight_ = learn_<A>(weight_, (t_ref - *first) * h);
+    }
+    else
+    {
+      const long_t* wfirst = std::lower_bound(first, last, t_ref - gauss_->hi_step());
+      const long_t* wlast = std::upper_bound(wfirst, last, t_ref - gauss_->lo_step_);
+
+      weight_ = shift_n_(weight_, wfirst - first, dw);
+      for (; wfirst != wlast; ++wfirst)
+        weight_ = clip_(weight_ + da * gauss_->at_step(t_ref - *wfirst) + dw);
+      weight_ = shift_n_(weight_, last - wlast, dw);
+    }
+  }
+  else
   {
-    minus_dt = t_lastspike - (start->t_ + dendritic_delay);
-    ++start;
-    weight_ = learn_(weight_, minus_dt);
+    //get spike history in relevant range (t1, t2] from post-synaptic neuron
+    std::deque<histentry>::iterator start;
+    std::deque<histentry>::iterator finish;
+
+    // For a new synapse, t_lastspike contains the point in time of the last spike.
+    // So we initially read the history(t_last_spike - dendritic_delay, ...,  T_spike-dendritic_delay]
+    // which increases the access counter for these entries.
+    // At registration, all entries' access counters of history[0, ..., t_last_spike - dendritic_delay] have been 
+    // incremented by Archiving_Node::register_stdp_connection(). See bug #218 for details.
+    target_->get_history(t_lastspike - dendritic_delay, t_spike - dendritic_delay,
+                           &start, &finish);
+    MYMODULE_PROFILE_COUNT(profile_, target_->get_thread(), PROF_HISTORY, finish - start);
+    //facilitation due to post-synaptic spikes since last pre-synaptic spike
+    double_t minus_dt;
+    if (gauss_.get() == 0)
+    {
+      while (start != finish)
+      {
+        minus_dt = t_lastspike - (start->t_ + dendritic_delay);
+        ++start;
+        weight_ = learn_<A>(weight_, minus_dt);
+      }
+    }
+    else
+    {
+      const double_t t_ref = t_lastspike - dendritic_delay;
+      std::deque<histentry>::iterator first =
+        std::lower_bound(start, finish, t_ref - gauss_->hi_, HistentryBefore());
+      std::deque<histentry>::iterator last =
+        std::upper_bound(first, finish, t_ref - gauss_->lo_, HistentryBefore());
+
+      weight_ = shift_n_(weight_, first - start, dw);
+      for (; first != last; ++first)
+      {
+        minus_dt = t_ref - first->t_;
+        weight_ = clip_(weight_ + da * (*gauss_)(minus_dt) + dw);
+      }
+      weight_ = shift_n_(weight_, finish - last, dw);
+    }
   }
 
+  track_silent_(t_spike);
+
   if(EmitSpk_)
   {
     e.set_receiver(*target_);
@@ -233,6 +569,9 @@ void STDPConnectionAlpha::send(Event& e, double_t t_lastspike, const CommonSynap
     e.set_rport(rport_);
     e();
   }
+
+  MYMODULE_PROFILE_COUNT(profile_, target_->get_thread(), PROF_SENDS, 1);
+  MYMODULE_PROFILE_STOP(profile_, target_->get_thread(), PROF_SEND_CYCLES, prof_start);
 }
 
 } // of namespace nest
@@ -30,6 +30,16 @@ using namespace nest;
 namespace mynest
 {
 
+#ifdef MYMODULE_PROFILE
+  namespace
+  {
+    const char* const profile_names[] =
+      { "sends", "history_entries", "send_cycles" };
+  }
+
+  ProfileCounters STDPConnectionExt::profile_(profile_names, 3);
+#endif
+
   STDPConnectionExt::STDPConnectionExt() :
     ConnectionHetWD(),
     tau_plus_(20.0),
@@ -44,7 +54,13 @@ namespace mynest
     LearnEn_(true),
     EmitSpk_(true),
     Esyn_(1.0)
-  { }
+  {
+    dendritic_delay_ = Time(Time::step(delay_)).get_ms();
+    step_history_ = false;
+    frozen_ = false;
+    math_accuracy_ = MATH_EXACT;
+    set_pow_kinds_();
+  }
 
 
   STDPConnectionExt::STDPConnectionExt(const STDPConnectionExt &rhs) :
@@ -62,6 +78,12 @@ namespace mynest
     LearnEn_ = rhs.LearnEn_;
     EmitSpk_ = rhs.EmitSpk_;
     Esyn_ = rhs.Esyn_;
+    dendritic_delay_ = rhs.dendritic_delay_;
+    step_history_ = rhs.step_history_;
+    frozen_ = rhs.frozen_;
+    math_accuracy_ = rhs.math_accuracy_;
+    pow_plus_ = rhs.pow_plus_;
+    pow_minus_ = rhs.pow_minus_;
   }
 
   void STDPConnectionExt::get_status(DictionaryDatum & d) const
@@ -77,7 +99,13 @@ namespace mynest
     def<double_t>(d, "Gpost", Gpost_);
     def<bool>(d, "LearnEn", LearnEn_);
     def<bool>(d, "EmitSpk", EmitSpk_);
+    def<bool>(d, "frozen", frozen_);
+    def<long>(d, "math_accuracy", math_accuracy_);
     def<double_t>(d, "Esyn", Esyn_);
+
+#ifdef MYMODULE_PROFILE
+    profile_.get(d);
+#endif
   }
 
   void STDPConnectionExt::set_status(const DictionaryDatum & d, ConnectorModel &cm)
@@ -93,7 +121,11 @@ namespace mynest
     updateValue<double_t>(d, "Gpost", Gpost_);
     updateValue<bool>(d, "LearnEn", LearnEn_);
     updateValue<bool>(d, "EmitSpk", EmitSpk_);
+    updateValue<long>(d, "math_accuracy", math_accuracy_);
+    check_math_accuracy_();
     updateValue<double_t>(d, "Esyn", Esyn_);
+    dendritic_delay_ = Time(Time::step(delay_)).get_ms();
+    set_pow_kinds_();
   }
 
    /**
@@ -114,7 +146,11 @@ namespace mynest
     set_property<double_t>(d, "Gposts", p, Gpost_);
     set_property<bool>(d, "LearnEns", p, LearnEn_);
     set_property<bool>(d, "EmitSpks", p, EmitSpk_);
+    set_property<long>(d, "math_accuracys", p, math_accuracy_);
+    check_math_accuracy_();
     set_property<double_t>(d, "Esyns", p, Esyn_);
+    dendritic_delay_ = Time(Time::step(delay_)).get_ms();
+    set_pow_kinds_();
   }
 
   void STDPConnectionExt::initialize_property_arrays(DictionaryDatum & d) const
@@ -131,6 +167,7 @@ namespace mynest
     initialize_property_array(d, "Gposts");
     initialize_property_array(d, "LearnEns");
     initialize_property_array(d, "EmitSpks");
+    initialize_property_array(d, "math_accuracys");
     initialize_property_array(d, "Esyns");
   }
 
@@ -152,7 +189,14 @@ namespace mynest
     append_property<double_t>(d, "Gposts", Gpost_);
     append_property<bool>(d, "LearnEns", LearnEn_);
     append_property<bool>(d, "EmitSpks", EmitSpk_);
+    append_property<long>(d, "math_accuracys", math_accuracy_);
     append_property<double_t>(d, "Esyns", Esyn_);
   }
 
+  void STDPConnectionExt::calibrate(const TimeConverter &tc)
+  {
+    ConnectionHetWD::calibrate(tc);
+    dendritic_delay_ = Time(Time::step(delay_)).get_ms();
+  }
+
 } // of namespace nest
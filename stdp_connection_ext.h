@@ -52,6 +52,12 @@
    LearnEn    bool   - Determine whether enable learning or not
    Gpre       double - None-STDP pre-synaptic learning factor
    Gpost      double - None-STDP post-synaptic learning factor
+   math_accuracy int - exp and pow when learning: 0 std (default), 1 relative
+                       error below 1e-12, 2 below 1e-7, see module_math.h
+
+  Remarks:
+   The exponents 0 and 1 as well as integer and half-integer exponents up
+   to 16 are evaluated without std::pow.
 
   Transmits: SpikeEvent
    
@@ -78,7 +84,10 @@
 
 #include "connection_het_wd.h"
 #include "archiving_node.h"
+#include "archiving_node_ext.h"
 #include "generic_connector.h"
+#include "profile_counters.h"
+#include "module_math.h"
 #include <cmath>
 
 using namespace nest;
@@ -136,6 +145,11 @@ namespace mynest
    */
   void append_properties(DictionaryDatum & d) const;
 
+  /**
+   * Convert the delay after a change of resolution.
+   */
+  void calibrate(const TimeConverter &);
+
   /**
    * Send an event to the receiver of this connection.
    * \param e The event to send
@@ -144,15 +158,72 @@ namespace mynest
    */
   void send(Event& e, double_t t_lastspike, const CommonSynapseProperties &cp);
 
+  /**
+   * Presynaptic trace, for bulk access through ModuleConnector.
+   */
+  double_t get_trace() const { return Kplus_; }
+  void set_trace(double_t k) { Kplus_ = k; }
+
+  //! Upper weight bound, for NormalizeSynapses
+  double_t get_wmax() const { return Wmax_; }
+
+  //! Learning is never deferred, for ModuleConnector
+  void apply_deferred() const {}
+
+  /**
+   * Stop learning for good, see FreezeSynapses. The connection then only
+   * transmits and its target can drop the spike history kept for it.
+   * Only connections to an Archiving_Node_Ext can be frozen.
+   * \param t_lastspike Time of the last spike sent, from the connector.
+   * \returns true if the connection is frozen.
+   */
+  bool freeze(double_t t_lastspike);
+
+  //! Not pruned, for ModuleConnector
+  bool prune(double_t, double_t) { return false; }
+
+  //! Nothing to restart, for ModuleConnector
+  void restart_silent() {}
+
   // overloaded for all supported event types
   using Connection::check_event;
   void check_event(SpikeEvent&) {}
 
  private:
 
+  //! send() for MathAccuracy A
+  template <int A>
+  void send_(Event& e, double_t t_lastspike);
+
+  template <int A>
   double_t facilitate_(double_t w, double_t kplus);
+  template <int A>
   double_t depress_(double_t w, double_t kminus);
 
+  /**
+   * Ways to evaluate the weight dependence x^mu, chosen when mu is set.
+   * Additive (0) and multiplicative (1) STDP need no power at all, small
+   * integer and half-integer exponents are a few multiplies and a sqrt.
+   */
+  enum PowKind_ { POW_ZERO, POW_ONE, POW_INT, POW_HALF, POW_GENERAL };
+
+  static unsigned char pow_kind_(double_t mu);
+  template <int A>
+  static double_t pow_(double_t x, double_t mu, unsigned char kind);
+
+  //! Update pow_plus_ and pow_minus_ after a change of the exponents
+  void set_pow_kinds_()
+  {
+    pow_plus_ = pow_kind_(mu_plus_);
+    pow_minus_ = pow_kind_(mu_minus_);
+  }
+
+  void check_math_accuracy_() const
+  {
+    if (!math::valid_accuracy(math_accuracy_))
+      throw BadProperty("math_accuracy must be 0, 1 or 2.");
+  }
+
   // data members of each connection
   double_t tau_plus_;
   double_t lambda_;
@@ -166,14 +237,73 @@ namespace mynest
   bool LearnEn_;
   bool EmitSpk_;
   double_t Esyn_;
-
+  double_t dendritic_delay_;  //!< delay_ in ms, kept up to date for send()
+  bool step_history_;         //!< target_ is an Archiving_Node_Ext
+  bool frozen_;               //!< no learning, target history released
+  long math_accuracy_;        //!< MathAccuracy of exp and pow in send()
+  unsigned char pow_plus_;    //!< PowKind_ of mu_plus_
+  unsigned char pow_minus_;   //!< PowKind_ of mu_minus_
+
+#ifdef MYMODULE_PROFILE
+  //! Counters of all connections of this type, see profile_counters.h
+  enum ProfileCounter_ { PROF_SENDS, PROF_HISTORY, PROF_SEND_CYCLES };
+  static ProfileCounters profile_;
+#endif
   };
 
 
+inline
+unsigned char STDPConnectionExt::pow_kind_(double_t mu)
+{
+  if (mu == 0.0)
+    return POW_ZERO;
+  if (mu == 1.0)
+    return POW_ONE;
+  // up to x^16, beyond that std::pow is as fast as the loop
+  if (mu > 0.0 && mu <= 16.0)
+  {
+    if (mu == std::floor(mu))
+      return POW_INT;
+    if (mu - 0.5 == std::floor(mu))
+      return POW_HALF;
+  }
+  return POW_GENERAL;
+}
+
+template <int A>
+inline
+double_t STDPConnectionExt::pow_(double_t x, double_t mu, unsigned char kind)
+{
+  switch (kind)
+  {
+  case POW_ZERO:
+    return 1.0;
+  case POW_ONE:
+    return x;
+  case POW_INT:
+  case POW_HALF:
+  {
+    // x^n by squaring, n = floor(mu)
+    double_t r = kind == POW_HALF ? std::sqrt(x) : 1.0;
+    double_t b = x;
+    for (unsigned int n = static_cast<unsigned int>(mu); n != 0; n >>= 1)
+    {
+      if (n & 1)
+        r *= b;
+      b *= b;
+    }
+    return r;
+  }
+  default:
+    return math::pow<A>(x, mu);
+  }
+}
+
+template <int A>
 inline
 double_t STDPConnectionExt::facilitate_(double_t w, double_t kplus)
 {
-  double_t norm_w = (w / Wmax_) + (lambda_ * std::pow(1.0 - (w/Wmax_), mu_plus_) * kplus);
+  double_t norm_w = (w / Wmax_) + (lambda_ * pow_<A>(1.0 - (w/Wmax_), mu_plus_, pow_plus_) * kplus);
   norm_w -= lambda_ * Gpost_ / Wmax_;
   if (norm_w < 0.0)
       return 0.0;
@@ -181,10 +311,11 @@ double_t STDPConnectionExt::facilitate_(double_t w, double_t kplus)
       return norm_w < 1.0 ? norm_w * Wmax_ : Wmax_;
 }
 
-inline 
+template <int A>
+inline
 double_t STDPConnectionExt::depress_(double_t w, double_t kminus)
 {
-  double_t norm_w = (w / Wmax_) - (alpha_ * lambda_ * std::pow(w/Wmax_, mu_minus_) * kminus);
+  double_t norm_w = (w / Wmax_) - (alpha_ * lambda_ * pow_<A>(w/Wmax_, mu_minus_, pow_minus_) * kminus);
   norm_w += lambda_ * Gpre_ / Wmax_;
   if (norm_w > 1.0)
     return Wmax_;
@@ -204,7 +335,26 @@ void STDPConnectionExt::check_connection(Node & s, Node & r, rport receptor_type
   // At registration, all entries' access counters of history[0, ..., t_last_spike - dendritic_delay] will be 
   // incremented by the following call to Archiving_Node::register_stdp_connection().
   // See bug #218 for details.
-  r.register_stdp_connection(t_lastspike - Time(Time::step(delay_)).get_ms());
+  dendritic_delay_ = Time(Time::step(delay_)).get_ms();
+
+  Archiving_Node_Ext* a = dynamic_cast<Archiving_Node_Ext*>(&r);
+  step_history_ = (a != 0);
+  if (step_history_)
+    a->register_step_connection(Time(Time::ms(t_lastspike)).get_steps() - delay_);
+  else
+    r.register_stdp_connection(t_lastspike - dendritic_delay_);
+}
+
+inline
+bool STDPConnectionExt::freeze(double_t t_lastspike)
+{
+  if (frozen_ || !step_history_)
+    return frozen_;
+
+  static_cast<Archiving_Node_Ext*>(target_)->unregister_step_connection(
+    Time(Time::ms(t_lastspike)).get_steps() - delay_);
+  frozen_ = true;
+  return true;
 }
 
 /**
@@ -215,45 +365,107 @@ void STDPConnectionExt::check_connection(Node & s, Node & r, rport receptor_type
  */
 inline
 void STDPConnectionExt::send(Event& e, double_t t_lastspike, const CommonSynapseProperties &)
+{
+  // the tier is chosen once per spike, not per history entry
+  switch (math_accuracy_)
+  {
+  case MATH_1E12: send_<MATH_1E12>(e, t_lastspike); break;
+  case MATH_1E7:  send_<MATH_1E7>(e, t_lastspike); break;
+  default:        send_<MATH_EXACT>(e, t_lastspike); break;
+  }
+}
+
+template <int A>
+inline
+void STDPConnectionExt::send_(Event& e, double_t t_lastspike)
 {
   // synapse STDP depressing/facilitation dynamics
+  MYMODULE_PROFILE_START(prof_start);
 
-  double_t t_spike = e.get_stamp().get_ms();
-  // t_lastspike_ = 0 initially
-  double_t dendritic_delay = Time(Time::step(delay_)).get_ms();
+  if (frozen_)
+  {
+    if (EmitSpk_)
+    {
+      e.set_receiver(*target_);
+      e.set_weight(weight_ * Esyn_);
+      e.set_delay(delay_);
+      e.set_rport(rport_);
+      e();
+    }
+    MYMODULE_PROFILE_COUNT(profile_, target_->get_thread(), PROF_SENDS, 1);
+    MYMODULE_PROFILE_STOP(profile_, target_->get_thread(), PROF_SEND_CYCLES, prof_start);
+    return;
+  }
 
-  //get spike history in relevant range (t1, t2] from post-synaptic neuron
-  std::deque<histentry>::iterator start;
-  std::deque<histentry>::iterator finish;
+  const double_t t_spike = e.get_stamp().get_ms();
+  // t_lastspike_ = 0 initially
+  // local copy, stores to weight_ might otherwise alias the member
+  const double_t dendritic_delay = dendritic_delay_;
 
-  // For a new synapse, t_lastspike contains the point in time of the last spike.
-  // So we initially read the history(t_last_spike - dendritic_delay, ...,  T_spike-dendritic_delay]
-  // which increases the access counter for these entries.
-  // At registration, all entries' access counters of history[0, ..., t_last_spike - dendritic_delay] have been 
-  // incremented by Archiving_Node::register_stdp_connection(). See bug #218 for details.
-  target_->get_history(t_lastspike - dendritic_delay, t_spike - dendritic_delay,
-                         &start, &finish);
-  //facilitation due to post-synaptic spikes since last pre-synaptic spike
-  double_t minus_dt;
   bool neg_w=false;
   if(weight_ < 0.0){
       neg_w = true;
       weight_ = -weight_;
   }
 
-  while (start != finish)
+  if (step_history_)
   {
-    minus_dt = t_lastspike - (start->t_ + dendritic_delay);
-    ++start;
-    if (minus_dt == 0)
-      continue;
+    // the same range in steps, from the contiguous history of the target
+    Archiving_Node_Ext* target = static_cast<Archiving_Node_Ext*>(target_);
+    // resolution and step of the last spike from the cached delay, there
+    // is no Time conversion per spike
+    const double_t h = dendritic_delay / delay_;
+    const long_t t_ref = static_cast<long_t>(std::floor(t_lastspike / h + 0.5)) - delay_;
+    const long_t t_now = e.get_stamp().get_steps() - delay_;
+    const long_t* first;
+    const long_t* last;
+    target->get_step_history(t_ref, t_now, &first, &last);
+    MYMODULE_PROFILE_COUNT(profile_, target_->get_thread(), PROF_HISTORY, last - first);
+
     if(LearnEn_)
-        weight_ = facilitate_(weight_, Kplus_ * std::exp(minus_dt / tau_plus_));
+    {
+      for (; first != last; ++first)
+      {
+        if (*first == t_ref)
+          continue;
+        weight_ = facilitate_<A>(weight_, Kplus_ * math::exp<A>((t_ref - *first) * h / tau_plus_));
+      }
+
+      //depression due to new pre-synaptic spike
+      weight_ = depress_<A>(weight_, target->get_step_K_value(t_now));
+    }
+  }
+  else
+  {
+    //get spike history in relevant range (t1, t2] from post-synaptic neuron
+    std::deque<histentry>::iterator start;
+    std::deque<histentry>::iterator finish;
+
+    // For a new synapse, t_lastspike contains the point in time of the last spike.
+    // So we initially read the history(t_last_spike - dendritic_delay, ...,  T_spike-dendritic_delay]
+    // which increases the access counter for these entries.
+    // At registration, all entries' access counters of history[0, ..., t_last_spike - dendritic_delay] have been 
+    // incremented by Archiving_Node::register_stdp_connection(). See bug #218 for details.
+    target_->get_history(t_lastspike - dendritic_delay, t_spike - dendritic_delay,
+                           &start, &finish);
+    MYMODULE_PROFILE_COUNT(profile_, target_->get_thread(), PROF_HISTORY, finish - start);
+    //facilitation due to post-synaptic spikes since last pre-synaptic spike
+    double_t minus_dt;
+    if(LearnEn_)
+    {
+      while (start != finish)
+      {
+        minus_dt = t_lastspike - (start->t_ + dendritic_delay);
+        ++start;
+        if (minus_dt == 0)
+          continue;
+        weight_ = facilitate_<A>(weight_, Kplus_ * math::exp<A>(minus_dt / tau_plus_));
+      }
+
+      //depression due to new pre-synaptic spike
+      weight_ = depress_<A>(weight_, target_->get_K_value(t_spike - dendritic_delay));
+    }
   }
-
-  //depression due to new pre-synaptic spike
-  if(LearnEn_)
-    weight_ = depress_(weight_, target_->get_K_value(t_spike - dendritic_delay));
 
   if(neg_w)
       weight_ = -weight_;
@@ -268,7 +480,10 @@ void STDPConnectionExt::send(Event& e, double_t t_lastspike, const CommonSynapse
   }
 
  
-  Kplus_ = Kplus_ * std::exp((t_lastspike - t_spike) / tau_plus_) + 1.0;
+  Kplus_ = Kplus_ * math::exp<A>((t_lastspike - t_spike) / tau_plus_) + 1.0;
+
+  MYMODULE_PROFILE_COUNT(profile_, target_->get_thread(), PROF_SENDS, 1);
+  MYMODULE_PROFILE_STOP(profile_, target_->get_thread(), PROF_SEND_CYCLES, prof_start);
 }
 
 } // of namespace nest
@@ -30,6 +30,16 @@ using namespace nest;
 namespace mynest
 {
 
+#ifdef MYMODULE_PROFILE
+  namespace
+  {
+    const char* const profile_names[] =
+      { "sends", "history_entries", "send_cycles" };
+  }
+
+  ProfileCounters STDPConnectionMulti::profile_(profile_names, 3);
+#endif
+
 
   STDPConnectionMulti::STDPConnectionMulti() :
     ConnectionHetWD(),
@@ -39,8 +49,17 @@ namespace mynest
     tneg_(10.0),
     Wmax_(100.0),
     Esyn_(1.0),
-    EmitSpk_(true)
-  { }
+    EmitSpk_(true),
+    Defer_(false),
+    DeferInterval_(0.0)
+  {
+    dendritic_delay_ = Time(Time::step(delay_)).get_ms();
+    step_history_ = false;
+    frozen_ = false;
+    math_accuracy_ = MATH_EXACT;
+    Wprune_ = 0.0;
+    t_silent_ = -1.0;
+  }
 
 
   STDPConnectionMulti::STDPConnectionMulti(const STDPConnectionMulti &rhs) :
@@ -53,10 +72,20 @@ namespace mynest
     Wmax_   = rhs.Wmax_;
     Esyn_   = rhs.Esyn_;
     EmitSpk_= rhs.EmitSpk_;
+    Defer_  = rhs.Defer_;
+    DeferInterval_ = rhs.DeferInterval_;
+    dendritic_delay_ = rhs.dendritic_delay_;
+    step_history_ = rhs.step_history_;
+    frozen_ = rhs.frozen_;
+    math_accuracy_ = rhs.math_accuracy_;
+    Wprune_ = rhs.Wprune_;
+    t_silent_ = rhs.t_silent_;
+    pending_ = rhs.pending_;
   }
 
   void STDPConnectionMulti::get_status(DictionaryDatum & d) const
   {
+    apply_deferred();
     ConnectionHetWD::get_status(d);
     def<double_t>(d, "Aplus", Aplus_);
     def<double_t>(d, "Aneg", Aneg_);
@@ -65,10 +94,22 @@ namespace mynest
     def<double_t>(d, "Esyn", Esyn_);
     def<double_t>(d, "Wmax", Wmax_);
     def<bool>    (d, "EmitSpk", EmitSpk_);
+    def<double_t>(d, "Wprune", Wprune_);
+    def<bool>    (d, "frozen", frozen_);
+    def<long>(d, "math_accuracy", math_accuracy_);
+    def<double_t>(d, "t_silent", t_silent_);
+    def<bool>    (d, "Defer", Defer_);
+    def<double_t>(d, "DeferInterval", DeferInterval_);
+
+#ifdef MYMODULE_PROFILE
+    profile_.get(d);
+#endif
   }
 
   void STDPConnectionMulti::set_status(const DictionaryDatum & d, ConnectorModel &cm)
   {
+    // deferred spikes learn with the old parameters
+    apply_deferred();
     ConnectionHetWD::set_status(d, cm);
     updateValue<double_t>(d, "Aplus", Aplus_);
     updateValue<double_t>(d, "Aneg", Aneg_);
@@ -77,6 +118,14 @@ namespace mynest
     updateValue<double_t>(d, "Esyn", Esyn_);
     updateValue<double_t>(d, "Wmax", Wmax_);
     updateValue<bool>    (d, "EmitSpk", EmitSpk_);
+    updateValue<long>(d, "math_accuracy", math_accuracy_);
+    check_math_accuracy_();
+    updateValue<double_t>(d, "Wprune", Wprune_);
+    updateValue<bool>    (d, "Defer", Defer_);
+    updateValue<double_t>(d, "DeferInterval", DeferInterval_);
+    dendritic_delay_ = Time(Time::step(delay_)).get_ms();
+    // the weight may have been set, count the silent time anew
+    t_silent_ = -1.0;
   }
 
    /**
@@ -85,6 +134,7 @@ namespace mynest
    */
   void STDPConnectionMulti::set_status(const DictionaryDatum & d, nest::index p, ConnectorModel &cm)
   {
+    apply_deferred();
     ConnectionHetWD::set_status(d, p, cm);
     set_property<double_t>(d, "Aplus"   , p, Aplus_);
     set_property<double_t>(d, "Aneg"    , p, Aneg_);
@@ -93,6 +143,13 @@ namespace mynest
     set_property<double_t>(d, "Esyn"    , p, Esyn_);
     set_property<double_t>(d, "Wmax"    , p, Wmax_);
     set_property<bool>    (d, "EmitSpk" , p, EmitSpk_);
+    set_property<long>(d, "math_accuracy", p, math_accuracy_);
+    check_math_accuracy_();
+    set_property<double_t>(d, "Wprune", p, Wprune_);
+    set_property<bool>    (d, "Defer"   , p, Defer_);
+    set_property<double_t>(d, "DeferInterval", p, DeferInterval_);
+    dendritic_delay_ = Time(Time::step(delay_)).get_ms();
+    t_silent_ = -1.0;
   }
 
   void STDPConnectionMulti::initialize_property_arrays(DictionaryDatum & d) const
@@ -105,6 +162,10 @@ namespace mynest
     initialize_property_array(d, "Esyn"    );
     initialize_property_array(d, "Wmax"    );
     initialize_property_array(d, "EmitSpk" );
+    initialize_property_array(d, "math_accuracy");
+    initialize_property_array(d, "Wprune");
+    initialize_property_array(d, "Defer"   );
+    initialize_property_array(d, "DeferInterval");
   }
 
   /**
@@ -113,6 +174,7 @@ namespace mynest
    */
   void STDPConnectionMulti::append_properties(DictionaryDatum & d) const
   {
+    apply_deferred();
     ConnectionHetWD::append_properties(d);
     append_property<double_t>(d, "Aplus", Aplus_);
     append_property<double_t>(d, "Aneg", Aneg_);
@@ -121,6 +183,72 @@ namespace mynest
     append_property<double_t>(d, "Esyn", Esyn_);
     append_property<double_t>(d, "Wmax", Wmax_);
     append_property<bool>    (d, "EmitSpk", EmitSpk_);
+    append_property<long>(d, "math_accuracy", math_accuracy_);
+    append_property<double_t>(d, "Wprune", Wprune_);
+    append_property<bool>    (d, "Defer", Defer_);
+    append_property<double_t>(d, "DeferInterval", DeferInterval_);
+  }
+
+  void STDPConnectionMulti::apply_deferred_()
+  {
+    switch (math_accuracy_)
+    {
+    case MATH_1E12: learn_deferred_<MATH_1E12>(); break;
+    case MATH_1E7:  learn_deferred_<MATH_1E7>(); break;
+    default:        learn_deferred_<MATH_EXACT>(); break;
+    }
+  }
+
+  template <int A>
+  void STDPConnectionMulti::learn_deferred_()
+  {
+    // pending_[i-1] and pending_[i] bound the interval of the i-th deferred
+    // spike. The history of all intervals is read at once, each
+    // postsynaptic spike learns with the spike that ends its interval.
+    double_t kplus, kneg;
+    decays_<A>(kplus, kneg);
+    const double_t h = Time::get_resolution().get_ms();
+    size_t i = 1;
+
+    if (step_history_)
+    {
+      const long_t* first;
+      const long_t* last;
+      static_cast<Archiving_Node_Ext*>(target_)->get_step_history(
+        pending_.front() - delay_, pending_.back() - delay_, &first, &last);
+      MYMODULE_PROFILE_COUNT(profile_, target_->get_thread(), PROF_HISTORY, last - first);
+      for (; first != last; ++first)
+      {
+        while (i + 1 < pending_.size() && *first + delay_ > pending_[i])
+          ++i;
+        weight_ = learn_<A>(weight_, (pending_[i-1] - delay_ - *first) * h, kplus, kneg);
+      }
+    }
+    else
+    {
+      std::deque<histentry>::iterator start;
+      std::deque<histentry>::iterator finish;
+      target_->get_history(Time(Time::step(pending_.front())).get_ms() - dendritic_delay_,
+                           Time(Time::step(pending_.back())).get_ms() - dendritic_delay_,
+                           &start, &finish);
+      MYMODULE_PROFILE_COUNT(profile_, target_->get_thread(), PROF_HISTORY, finish - start);
+      for (; start != finish; ++start)
+      {
+        while (i + 1 < pending_.size()
+               && Time(Time::ms(start->t_)).get_steps() + delay_ > pending_[i])
+          ++i;
+        weight_ = learn_<A>(weight_, (pending_[i-1] - delay_) * h - start->t_, kplus, kneg);
+      }
+    }
+
+    track_silent_(Time(Time::step(pending_.back())).get_ms());
+    pending_.clear();
+  }
+
+  void STDPConnectionMulti::calibrate(const TimeConverter &tc)
+  {
+    ConnectionHetWD::calibrate(tc);
+    dendritic_delay_ = Time(Time::step(delay_)).get_ms();
   }
 
 } // of namespace nest
@@ -41,7 +41,24 @@
    Wmax       double - Maximum limitation of synapse weight
    Esyn       double - Multiplication to w when sending spikes
    EmitSpk    bool   - whether to emit spikes or not
+   Defer      bool   - Defer learning while EmitSpk is false
+   DeferInterval double - Apply deferred learning at least this often, in ms
+   Wprune     double - Weight at or below which the synapse counts as silent
+   t_silent   double - Time since when the synapse is silent, -1 if it is
+                       not (read only), see PruneSynapses
+   math_accuracy int - exp and pow when learning: 0 std (default), 1 relative
+                       error below 1e-12, 2 below 1e-7, see module_math.h
    
+  Remarks:
+   With EmitSpk false the synapse does not affect the network, nobody sees
+   its weight until it is read. If Defer is set as well, a presynaptic spike
+   only records its step. The weight updates of all recorded spikes are
+   computed in one pass over the postsynaptic history when the weight is
+   read (GetStatus, GetSynapseColumns), before any SetStatus, and once the
+   recorded spikes span DeferInterval ms (0: only then). The postsynaptic
+   history is kept until the pass, so a long DeferInterval costs memory in
+   the target neuron. The result is the same as without Defer.
+
 
   Transmits: SpikeEvent
    
@@ -56,13 +73,71 @@
 
 #include "connection_het_wd.h"
 #include "archiving_node.h"
+#include "archiving_node_ext.h"
 #include "generic_connector.h"
+#include "profile_counters.h"
+#include "module_math.h"
+#include <algorithm>
 #include <cmath>
+#include <vector>
 
 using namespace nest;
 
 namespace mynest
 {
+  /**
+   * Steps of the deferred spikes of a STDPConnectionMulti, see Defer.
+   * Connections are stored by value per synapse, so the steps are held
+   * out of line: a connection that does not defer carries a null pointer,
+   * the vector is allocated with the first deferred spike.
+   */
+  class DeferredSteps
+  {
+  public:
+
+    DeferredSteps() : v_(0) {}
+
+    DeferredSteps(const DeferredSteps& d)
+      : v_(d.empty() ? 0 : new std::vector<long_t>(*d.v_))
+    {}
+
+    ~DeferredSteps() { delete v_; }
+
+    DeferredSteps& operator=(const DeferredSteps& d)
+    {
+      if (this != &d)
+      {
+        DeferredSteps tmp(d);
+        std::swap(v_, tmp.v_);
+      }
+      return *this;
+    }
+
+    bool empty() const { return v_ == 0 || v_->empty(); }
+    size_t size() const { return v_ == 0 ? 0 : v_->size(); }
+    long_t operator[](size_t i) const { return (*v_)[i]; }
+    long_t front() const { return v_->front(); }
+    long_t back() const { return v_->back(); }
+
+    void push_back(long_t s)
+    {
+      if (v_ == 0)
+        v_ = new std::vector<long_t>;
+      v_->push_back(s);
+    }
+
+    /** Keeps the storage, the connection defers again. */
+    void clear()
+    {
+      if (v_ != 0)
+        v_->clear();
+    }
+
+  private:
+
+    std::vector<long_t>* v_;
+  };
+
   class STDPConnectionMulti : public ConnectionHetWD
   {
 
@@ -114,6 +189,11 @@ namespace mynest
    */
   void append_properties(DictionaryDatum & d) const;
 
+  /**
+   * Convert the delay after a change of resolution.
+   */
+  void calibrate(const TimeConverter &);
+
   /**
    * Send an event to the receiver of this connection.
    * \param e The event to send
@@ -122,6 +202,50 @@ namespace mynest
    */
   void send(Event& e, double_t t_lastspike, const CommonSynapseProperties &cp);
 
+  /**
+   * This synapse keeps no presynaptic trace, the functions exist for
+   * bulk access through ModuleConnector.
+   */
+  double_t get_trace() const { return 0.0; }
+  void set_trace(double_t) {}
+
+  //! Upper weight bound, for NormalizeSynapses
+  double_t get_wmax() const { return Wmax_; }
+
+  /**
+   * Apply the learning of deferred spikes to the weight, see Defer. The
+   * weight is brought up to date, not changed, so this counts as const.
+   */
+  void apply_deferred() const
+  {
+    if (!pending_.empty())
+      const_cast<STDPConnectionMulti*>(this)->apply_deferred_();
+  }
+
+  /**
+   * Stop learning for good, see FreezeSynapses. The connection then only
+   * transmits and its target can drop the spike history kept for it.
+   * Only connections to an Archiving_Node_Ext can be frozen.
+   * \param t_lastspike Time of the last spike sent, from the connector.
+   * \returns true if the connection is frozen.
+   */
+  bool freeze(double_t t_lastspike);
+
+  /**
+   * Prepare removal by PruneSynapses if the weight has been at or below
+   * Wprune since time t_before or earlier. The connection is unregistered
+   * from its target and must be removed from its connector.
+   * \param t_lastspike Time of the last spike sent, from the connector.
+   * \returns true if the connection is to be removed.
+   */
+  bool prune(double_t t_before, double_t t_lastspike);
+
+  /**
+   * Forget since when the weight has been silent, as set_status does.
+   * Called by ModuleConnector after it rewrites the weight in bulk.
+   */
+  void restart_silent() { t_silent_ = -1.0; }
+
   // overloaded for all supported event types
   using Connection::check_event;
   void check_event(SpikeEvent&) {}
@@ -130,7 +254,27 @@ namespace mynest
 
   //double_t facilitate_(double_t w, double_t kplus);
   //double_t depress_(double_t w, double_t kminus);
-  double_t learn_(double_t w, double_t dt);
+  //! send() for MathAccuracy A
+  template <int A>
+  void send_(Event& e, double_t t_lastspike);
+
+  template <int A>
+  double_t learn_(double_t w, double_t dt, double_t kplus, double_t kneg);
+  template <int A>
+  void decays_(double_t& kplus, double_t& kneg) const;
+
+  void apply_deferred_();
+  //! apply_deferred_() for MathAccuracy A
+  template <int A>
+  void learn_deferred_();
+
+  void track_silent_(double_t t);
+
+  void check_math_accuracy_() const
+  {
+    if (!math::valid_accuracy(math_accuracy_))
+      throw BadProperty("math_accuracy must be 0, 1 or 2.");
+  }
 
   // data members of each connection
   double_t Aplus_;
@@ -140,22 +284,56 @@ namespace mynest
   double_t Wmax_;
   double_t Esyn_;
   bool EmitSpk_;
-
+  bool Defer_;
+  double_t DeferInterval_;
+  double_t dendritic_delay_;  //!< delay_ in ms, kept up to date for send()
+  bool step_history_;         //!< target_ is an Archiving_Node_Ext
+  bool frozen_;               //!< no learning, target history released
+  long math_accuracy_;        //!< MathAccuracy of exp and pow in send()
+  double_t Wprune_;
+  double_t t_silent_;         //!< since when weight_ <= Wprune_ in ms, -1 if not
+
+  //! Steps of the deferred spikes, preceded by the step of the spike before
+  DeferredSteps pending_;
+
+#ifdef MYMODULE_PROFILE
+  //! Counters of all connections of this type, see profile_counters.h
+  enum ProfileCounter_ { PROF_SENDS, PROF_HISTORY, PROF_SEND_CYCLES };
+  static ProfileCounters profile_;
+#endif
   };
 
+template <int A>
+inline
+void STDPConnectionMulti::decays_(double_t& kplus, double_t& kneg) const
+{
+    // the per-ms decays 1 - 1/tplus and 1 - 1/tneg, taken to the power dt
+    // by std::pow in MATH_EXACT; the other tiers take their logs once so
+    // that learn_ needs only an exp per history entry
+    kplus = 1.0 - 1.0/tplus_;
+    kneg = 1.0 - 1.0/tneg_;
+    if (A != MATH_EXACT)
+    {
+        kplus = std::log(kplus);
+        kneg = std::log(kneg);
+    }
+}
+
+template <int A>
 inline
-double_t STDPConnectionMulti::learn_(double_t w, double_t dt)
+double_t STDPConnectionMulti::learn_(double_t w, double_t dt, double_t kplus, double_t kneg)
 {
+    // kplus and kneg come from decays_()
     double_t wd,td,nw;
     if(dt>0)
     {
-        wd = std::exp(-w) * Aplus_;
-        td = std::pow(1.0 - 1.0/tplus_,dt);
+        wd = math::exp<A>(-w) * Aplus_;
+        td = A == MATH_EXACT ? std::pow(kplus,dt) : math::exp<A>(dt * kplus);
     }
     else
     {
         wd = -w * Aneg_;
-        td = std::pow(1.0 - 1.0/tneg_,-dt);
+        td = A == MATH_EXACT ? std::pow(kneg,-dt) : math::exp<A>(-dt * kneg);
     }
     nw = w + wd * td;
     if(nw < 0.0){
@@ -195,7 +373,51 @@ void STDPConnectionMulti::check_connection(Node & s, Node & r, rport receptor_ty
   // At registration, all entries' access counters of history[0, ..., t_last_spike - dendritic_delay] will be 
   // incremented by the following call to Archiving_Node::register_stdp_connection().
   // See bug #218 for details.
-  r.register_stdp_connection(t_lastspike - Time(Time::step(delay_)).get_ms());
+  dendritic_delay_ = Time(Time::step(delay_)).get_ms();
+
+  Archiving_Node_Ext* a = dynamic_cast<Archiving_Node_Ext*>(&r);
+  step_history_ = (a != 0);
+  if (step_history_)
+    a->register_step_connection(Time(Time::ms(t_lastspike)).get_steps() - delay_);
+  else
+    r.register_stdp_connection(t_lastspike - dendritic_delay_);
+}
+
+inline
+bool STDPConnectionMulti::freeze(double_t t_lastspike)
+{
+  if (frozen_ || !step_history_)
+    return frozen_;
+
+  apply_deferred();
+  static_cast<Archiving_Node_Ext*>(target_)->unregister_step_connection(
+    Time(Time::ms(t_lastspike)).get_steps() - delay_);
+  frozen_ = true;
+  return true;
+}
+
+inline
+void STDPConnectionMulti::track_silent_(double_t t)
+{
+  if (weight_ > Wprune_)
+    t_silent_ = -1.0;
+  else if (t_silent_ < 0.0)
+    t_silent_ = t;
+}
+
+inline
+bool STDPConnectionMulti::prune(double_t t_before, double_t t_lastspike)
+{
+  apply_deferred();
+
+  // the history of other targets cannot be released
+  if (!step_history_ || t_silent_ < 0.0 || t_silent_ > t_before)
+    return false;
+
+  if (!frozen_)
+    static_cast<Archiving_Node_Ext*>(target_)->unregister_step_connection(
+      Time(Time::ms(t_lastspike)).get_steps() - delay_);
+  return true;
 }
 
 /**
@@ -206,33 +428,102 @@ void STDPConnectionMulti::check_connection(Node & s, Node & r, rport receptor_ty
  */
 inline
 void STDPConnectionMulti::send(Event& e, double_t t_lastspike, const CommonSynapseProperties &)
+{
+  // the tier is chosen once per spike, not per history entry
+  switch (math_accuracy_)
+  {
+  case MATH_1E12: send_<MATH_1E12>(e, t_lastspike); break;
+  case MATH_1E7:  send_<MATH_1E7>(e, t_lastspike); break;
+  default:        send_<MATH_EXACT>(e, t_lastspike); break;
+  }
+}
+
+template <int A>
+inline
+void STDPConnectionMulti::send_(Event& e, double_t t_lastspike)
 {
   // synapse STDP depressing/facilitation dynamics
+  MYMODULE_PROFILE_START(prof_start);
+
+  if (frozen_)
+  {
+    if (EmitSpk_)
+    {
+      e.set_receiver(*target_);
+      e.set_weight(weight_ * Esyn_);
+      e.set_delay(delay_);
+      e.set_rport(rport_);
+      e();
+    }
+    MYMODULE_PROFILE_COUNT(profile_, target_->get_thread(), PROF_SENDS, 1);
+    MYMODULE_PROFILE_STOP(profile_, target_->get_thread(), PROF_SEND_CYCLES, prof_start);
+    return;
+  }
 
-  double_t t_spike = e.get_stamp().get_ms();
+  const double_t t_spike = e.get_stamp().get_ms();
   // t_lastspike_ = 0 initially
-  double_t dendritic_delay = Time(Time::step(delay_)).get_ms();
+  // local copy, stores to weight_ might otherwise alias the member
+  const double_t dendritic_delay = dendritic_delay_;
 
-  //get spike history in relevant range (t1, t2] from post-synaptic neuron
-  std::deque<histentry>::iterator start;
-  std::deque<histentry>::iterator finish;
+  if (Defer_ && !EmitSpk_)
+  {
+    const double_t h = dendritic_delay / delay_;
+    if (pending_.empty())
+      pending_.push_back(static_cast<long_t>(std::floor(t_lastspike / h + 0.5)));
+    pending_.push_back(e.get_stamp().get_steps());
 
-  // For a new synapse, t_lastspike contains the point in time of the last spike.
-  // So we initially read the history(t_last_spike - dendritic_delay, ...,  T_spike-dendritic_delay]
-  // which increases the access counter for these entries.
-  // At registration, all entries' access counters of history[0, ..., t_last_spike - dendritic_delay] have been 
-  // incremented by Archiving_Node::register_stdp_connection(). See bug #218 for details.
-  target_->get_history(t_lastspike - dendritic_delay, t_spike - dendritic_delay,
-                         &start, &finish);
-  //facilitation due to post-synaptic spikes since last pre-synaptic spike
-  double_t minus_dt;
-  while (start != finish)
+    if (DeferInterval_ > 0.0 && (pending_.back() - pending_.front()) * h >= DeferInterval_)
+      apply_deferred_();
+
+    MYMODULE_PROFILE_COUNT(profile_, target_->get_thread(), PROF_SENDS, 1);
+    MYMODULE_PROFILE_STOP(profile_, target_->get_thread(), PROF_SEND_CYCLES, prof_start);
+    return;
+  }
+
+  double_t kplus, kneg;
+  decays_<A>(kplus, kneg);
+
+  if (step_history_)
   {
-    minus_dt = t_lastspike - (start->t_ + dendritic_delay);
-    ++start;
-    weight_ = learn_(weight_, minus_dt);
+    // the same range in steps, from the contiguous history of the target
+    // resolution and step of the last spike from the cached delay, there
+    // is no Time conversion per spike
+    const double_t h = dendritic_delay / delay_;
+    const long_t t_ref = static_cast<long_t>(std::floor(t_lastspike / h + 0.5)) - delay_;
+    const long_t* first;
+    const long_t* last;
+    static_cast<Archiving_Node_Ext*>(target_)->get_step_history(
+      t_ref, e.get_stamp().get_steps() - delay_, &first, &last);
+    MYMODULE_PROFILE_COUNT(profile_, target_->get_thread(), PROF_HISTORY, last - first);
+    for (; first != last; ++first)
+      weight_ = learn_<A>(weight_, (t_ref - *first) * h, kplus, kneg);
+  }
+  else
+  {
+    //get spike history in relevant range (t1, t2] from post-synaptic neuron
+    std::deque<histentry>::iterator start;
+    std::deque<histentry>::iterator finish;
+
+    // For a new synapse, t_lastspike contains the point in time of the last spike.
+    // So we initially read the history(t_last_spike - dendritic_delay, ...,  T_spike-dendritic_delay]
+    // which increases the access counter for these entries.
+    // At registration, all entries' access counters of history[0, ..., t_last_spike - dendritic_delay] have been 
+    // incremented by Archiving_Node::register_stdp_connection(). See bug #218 for details.
+    target_->get_history(t_lastspike - dendritic_delay, t_spike - dendritic_delay,
+                           &start, &finish);
+    MYMODULE_PROFILE_COUNT(profile_, target_->get_thread(), PROF_HISTORY, finish - start);
+    //facilitation due to post-synaptic spikes since last pre-synaptic spike
+    double_t minus_dt;
+    while (start != finish)
+    {
+      minus_dt = t_lastspike - (start->t_ + dendritic_delay);
+      ++start;
+      weight_ = learn_<A>(weight_, minus_dt, kplus, kneg);
+    }
   }
 
+  track_silent_(t_spike);
+
   if(EmitSpk_)
   {
     e.set_receiver(*target_);
@@ -241,6 +532,9 @@ void STDPConnectionMulti::send(Event& e, double_t t_lastspike, const CommonSynap
     e.set_rport(rport_);
     e();
   }
+
+  MYMODULE_PROFILE_COUNT(profile_, target_->get_thread(), PROF_SENDS, 1);
+  MYMODULE_PROFILE_STOP(profile_, target_->get_thread(), PROF_SEND_CYCLES, prof_start);
 }
 
 } // of namespace nest
@@ -0,0 +1,285 @@
+/*
+ *  trace_current_generator.cpp
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "trace_current_generator.h"
+#include "network.h"
+#include "dict.h"
+#include "dictutils.h"
+#include "exceptions.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* ----------------------------------------------------------------
+ * Trace files
+ * ---------------------------------------------------------------- */
+
+namespace
+{
+  const char trace_tag[8] = { 'M', 'Y', 'T', 'R', 'A', 'C', 'E', '1' };
+  const size_t trace_header_bytes = 24;  // tag, channels, sampling interval
+
+  std::vector<mynest::TraceFile*> trace_files;
+}
+
+mynest::TraceFile* mynest::TraceFile::acquire(const std::string& filename)
+{
+  for ( size_t i = 0; i < trace_files.size(); ++i )
+    if ( trace_files[i]->filename_ == filename )
+      return acquire(trace_files[i]);
+
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if ( fd < 0 )
+    throw IOError("Could not open " + filename + " for reading.");
+
+  struct stat st;
+  if ( fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(trace_header_bytes) )
+  {
+    close(fd);
+    throw IOError(filename + " is not a trace file.");
+  }
+
+  const size_t bytes = st.st_size;
+  void* map = mmap(0, bytes, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if ( map == MAP_FAILED )
+    throw IOError("Could not map " + filename + ".");
+
+  const char* base = static_cast<const char*>(map);
+  int64_t n_channels;
+  double dt;
+  std::memcpy(&n_channels, base + 8, sizeof(n_channels));
+  std::memcpy(&dt, base + 16, sizeof(dt));
+  if ( std::memcmp(base, trace_tag, sizeof(trace_tag)) != 0 || n_channels <= 0 || dt <= 0.0 )
+  {
+    munmap(map, bytes);
+    throw IOError(filename + " is not a trace file.");
+  }
+
+  // samples are read in order, let the system read ahead
+  madvise(map, bytes, MADV_SEQUENTIAL);
+
+  TraceFile* t = new TraceFile;
+  t->filename_ = filename;
+  t->refs_ = 1;
+  t->map_ = map;
+  t->bytes_ = bytes;
+  t->n_channels_ = n_channels;
+  t->dt_ = dt;
+  t->samples_ = reinterpret_cast<const float*>(base + trace_header_bytes);
+  t->n_samples_ = (bytes - trace_header_bytes) / sizeof(float) / n_channels;
+  trace_files.push_back(t);
+  return t;
+}
+
+mynest::TraceFile* mynest::TraceFile::acquire(TraceFile* t)
+{
+  if ( t != 0 )
+    ++t->refs_;
+  return t;
+}
+
+void mynest::TraceFile::release(TraceFile* t)
+{
+  if ( t == 0 || --t->refs_ > 0 )
+    return;
+
+  for ( size_t i = 0; i < trace_files.size(); ++i )
+    if ( trace_files[i] == t )
+    {
+      trace_files.erase(trace_files.begin() + i);
+      break;
+    }
+  munmap(t->map_, t->bytes_);
+  delete t;
+}
+
+/* ----------------------------------------------------------------
+ * Default constructors defining default parameter
+ * ---------------------------------------------------------------- */
+
+mynest::trace_current_generator::Parameters_::Parameters_()
+  : filename_(""),
+    channel_(0),
+    scale_(1.0),
+    offset_(0.0)
+{}
+
+/* ----------------------------------------------------------------
+ * Parameter extraction and manipulation functions
+ * ---------------------------------------------------------------- */
+
+void mynest::trace_current_generator::Parameters_::get(DictionaryDatum &d) const
+{
+  def<std::string>(d, "filename", filename_);
+  def<long>(d, "channel", channel_);
+  def<double>(d, "scale", scale_);
+  def<double>(d, "offset", offset_);
+}
+
+void mynest::trace_current_generator::Parameters_::set(const DictionaryDatum& d)
+{
+  updateValue<std::string>(d, "filename", filename_);
+  updateValue<long>(d, "channel", channel_);
+  updateValue<double>(d, "scale", scale_);
+  updateValue<double>(d, "offset", offset_);
+
+  if ( channel_ < 0 )
+    throw BadProperty("The channel must be >= 0.");
+}
+
+/* ----------------------------------------------------------------
+ * Default and copy constructor for node
+ * ---------------------------------------------------------------- */
+
+mynest::trace_current_generator::trace_current_generator()
+  : Node(),
+    device_(),
+    P_(),
+    trace_(0)
+{}
+
+mynest::trace_current_generator::trace_current_generator(const trace_current_generator& n)
+  : Node(n),
+    device_(n.device_),
+    P_(n.P_),
+    trace_(TraceFile::acquire(n.trace_))
+{}
+
+mynest::trace_current_generator::~trace_current_generator()
+{
+  TraceFile::release(trace_);
+}
+
+/* ----------------------------------------------------------------
+ * Status
+ * ---------------------------------------------------------------- */
+
+void mynest::trace_current_generator::get_status(DictionaryDatum &d) const
+{
+  P_.get(d);
+  device_.get_status(d);
+
+  def<long>(d, "n_channels", trace_ != 0 ? trace_->n_channels_ : 0);
+  def<long>(d, "n_samples", trace_ != 0 ? trace_->n_samples_ : 0);
+}
+
+void mynest::trace_current_generator::set_status(const DictionaryDatum &d)
+{
+  Parameters_ ptmp = P_;  // temporary copy in case of errors
+  ptmp.set(d);            // throws if BadProperty
+
+  // map the new file before releasing the old one
+  TraceFile* t = trace_;
+  if ( ptmp.filename_ != P_.filename_ )
+    t = ptmp.filename_.empty() ? 0 : TraceFile::acquire(ptmp.filename_);
+  else
+    TraceFile::acquire(t);
+
+  if ( t != 0 && ptmp.channel_ >= t->n_channels_ )
+  {
+    TraceFile::release(t);
+    throw BadProperty("The trace file has fewer channels.");
+  }
+
+  try
+  {
+    device_.set_status(d);
+  }
+  catch ( ... )
+  {
+    TraceFile::release(t);
+    throw;
+  }
+
+  // if we get here, temporaries contain consistent set of properties
+  TraceFile::release(trace_);
+  trace_ = t;
+  P_ = ptmp;
+}
+
+/* ----------------------------------------------------------------
+ * Node initialization functions
+ * ---------------------------------------------------------------- */
+
+void mynest::trace_current_generator::init_state_(const Node& proto)
+{
+  const trace_current_generator& pr = downcast<trace_current_generator>(proto);
+
+  device_.init_state(pr.device_);
+}
+
+void mynest::trace_current_generator::init_buffers_()
+{
+  device_.init_buffers();
+}
+
+void mynest::trace_current_generator::calibrate()
+{
+  device_.calibrate();
+
+  V_.samples_ = 0;
+  V_.stride_ = 0;
+  V_.n_samples_ = 0;
+  V_.offset_ = Time(Time::ms(P_.offset_)).get_steps();
+
+  if ( trace_ == 0 )
+    return;
+
+  const double_t h = Time::get_resolution().get_ms();
+  if ( std::abs(trace_->dt_ - h) > 1e-9 * h )
+    throw BadProperty("The sampling interval of " + trace_->filename_ +
+                      " differs from the resolution.");
+
+  V_.samples_ = trace_->samples_ + P_.channel_;
+  V_.stride_ = trace_->n_channels_;
+  V_.n_samples_ = trace_->n_samples_;
+}
+
+/* ----------------------------------------------------------------
+ * Update function
+ * ---------------------------------------------------------------- */
+
+void mynest::trace_current_generator::update(Time const& origin, const long_t from, const long_t to)
+{
+  assert(to >= 0 && (delay) from < Scheduler::get_min_delay());
+  assert(from < to);
+
+  for ( long_t lag = from ; lag < to ; ++lag )
+  {
+    const long_t step = origin.get_steps() + lag;
+    const long_t k = step - V_.offset_;
+    if ( k < 0 || k >= V_.n_samples_ || !device_.is_active(Time::step(step)) )
+      continue;
+
+    // the sample is read straight from the mapping
+    CurrentEvent ce;
+    ce.set_current(P_.scale_ * V_.samples_[k * V_.stride_]);
+    network()->send(*this, ce, lag);
+  }
+}
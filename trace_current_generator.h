@@ -0,0 +1,175 @@
+/*
+ *  trace_current_generator.h
+ *
+ *  This file is part of NEST.
+ *
+ *  Copyright (C) 2004 The NEST Initiative
+ *
+ *  NEST is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  NEST is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with NEST.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef TRACE_CURRENT_GENERATOR_H
+#define TRACE_CURRENT_GENERATOR_H
+
+#include "nest.h"
+#include "event.h"
+#include "node.h"
+#include "stimulating_device.h"
+#include "connection.h"
+
+#include <string>
+
+/* BeginDocumentation
+Name: trace_current_generator - Current generator playing a recorded trace from file.
+
+Description:
+
+  trace_current_generator injects one channel of a recorded signal, stored
+  as binary file with one sample per simulation step. The file is mapped
+  into memory and the samples are read from the mapping in update(), so
+  large traces need no loading time and are paged in by the system as the
+  simulation proceeds. All generators reading the same file share one
+  mapping.
+
+  Sample k of the channel is sent at simulation step k + offset/h, scaled
+  by scale. Outside the trace and outside start/stop no current is sent.
+
+  The file consists of an 8 byte tag "MYTRACE1", the number of channels as
+  64 bit integer, the sampling interval in ms as double, followed by the
+  samples as 32 bit floats in native byte order, the channels of one step
+  next to each other.
+
+Parameters:
+
+  filename   string - Trace file, set to () to release it.
+  channel    int    - Channel to play, starting at 0.
+  scale      double - Current in pA per sample unit.
+  offset     double - Time in ms at which sample 0 is played.
+  n_channels int    - Number of channels in the file (read only).
+  n_samples  int    - Number of samples per channel (read only).
+
+  The parameters origin, start and stop of all stimulating devices apply.
+
+Remarks:
+
+  The sampling interval of the file must equal the simulation resolution.
+
+Sends: CurrentEvent
+
+Author: Zhenzhong Wang
+SeeAlso: step_current_generator, iaf_freq_sensor
+*/
+
+using namespace nest;
+namespace mynest
+{
+
+  class Network;
+
+  /**
+   * Memory mapping of one trace file, shared by all generators reading it.
+   */
+  struct TraceFile
+  {
+    std::string filename_;
+    size_t refs_;           //!< Generators using the mapping
+    void* map_;
+    size_t bytes_;
+    long n_channels_;
+    double dt_;             //!< Sampling interval in ms
+    const float* samples_;  //!< Start of the samples in the mapping
+    long n_samples_;        //!< Samples per channel
+
+    /** Mapping of filename, maps the file on first use. */
+    static TraceFile* acquire(const std::string& filename);
+
+    /** Share an existing mapping. */
+    static TraceFile* acquire(TraceFile*);
+
+    /** Unmap when the last user releases it. */
+    static void release(TraceFile*);
+  };
+
+  /**
+   * Current generator reading a memory-mapped trace file.
+   */
+  class trace_current_generator : public Node
+  {
+
+  public:
+
+    trace_current_generator();
+    trace_current_generator(const trace_current_generator&);
+    ~trace_current_generator();
+
+    bool has_proxies() const { return false; }
+
+    port check_connection(Connection&, port);
+
+    void get_status(DictionaryDatum &) const;
+    void set_status(const DictionaryDatum &);
+
+  private:
+
+    void init_state_(const Node&);
+    void init_buffers_();
+    void calibrate();
+
+    void update(Time const &, const long_t, const long_t);
+
+    // ------------------------------------------------------------
+
+    struct Parameters_ {
+      std::string filename_;  //!< File of the mapped trace
+      long_t   channel_;      //!< Channel to play
+      double_t scale_;        //!< pA per sample unit
+      double_t offset_;       //!< Time of sample 0 in ms
+
+      Parameters_();  //!< Sets default parameter values
+
+      void get(DictionaryDatum&) const;  //!< Store current values in dictionary
+      void set(const DictionaryDatum&);  //!< Set values from dictionary
+    };
+
+    // ------------------------------------------------------------
+
+    struct Variables_ {
+      const float* samples_;  //!< First sample of the channel
+      long_t stride_;         //!< Floats between two samples of the channel
+      long_t n_samples_;      //!< Samples in the channel
+      long_t offset_;         //!< Step at which sample 0 is played
+    };
+
+    // ------------------------------------------------------------
+
+    StimulatingDevice<CurrentEvent> device_;
+    Parameters_ P_;
+    Variables_  V_;
+
+    TraceFile* trace_;  //!< Shared mapping, 0 without file
+  };
+
+  inline
+  port trace_current_generator::check_connection(Connection& c, port receptor_type)
+  {
+    CurrentEvent e;
+    e.set_sender(*this);
+    c.check_event(e);
+    return c.get_target()->connect_sender(e, receptor_type);
+  }
+
+} // namespace
+
+#endif /* #ifndef TRACE_CURRENT_GENERATOR_H */